@@ -0,0 +1,104 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Micro benchmark of the hex display formatting, see HexCodec.hpp.
+// Built with -DZMQTESTTOOL_BUILD_BENCH=ON, run without arguments.
+
+#include "HexCodec.hpp"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+
+#include <cstdio>
+
+using nzmqt::samples::HexCodec;
+
+namespace
+{
+
+// The per byte formatting the subscriber used before, kept as the baseline
+QByteArray formatPerByte(const QByteArray& data)
+{
+    QByteArray hexString;
+    for (int i = 0; i < data.size(); ++i)
+    {
+        hexString.append(QByteArray::number(static_cast<uchar>(data[i]), 16).rightJustified(2, '0').toUpper());
+        hexString.append(" ");
+    }
+    return hexString;
+}
+
+QByteArray formatScalar(const QByteArray& data)
+{
+    QByteArray text(data.size() * 3, Qt::Uninitialized);
+    HexCodec::toSpacedHexScalar(data.constData(), data.size(), text.data());
+    return text;
+}
+
+#ifdef NZMQT_HEXCODEC_SSE2
+QByteArray formatSsse3(const QByteArray& data)
+{
+    QByteArray text(data.size() * 3, Qt::Uninitialized);
+    HexCodec::toSpacedHexSsse3(data.constData(), data.size(), text.data());
+    return text;
+}
+#endif
+
+QByteArray decodeText(const QByteArray& text)
+{
+    QByteArray bytes;
+    QString error;
+    HexCodec::decode(text, &bytes, &error);
+    return bytes;
+}
+
+// Repeats the function for about 200 ms and prints the input bytes per second
+template <typename Function>
+void measure(const char* name, const QByteArray& input, Function function)
+{
+    qint64 checksum = 0;
+    qint64 runs = 0;
+    QElapsedTimer timer;
+    timer.start();
+    do
+    {
+        checksum += function(input).size();
+        ++runs;
+    } while (timer.nsecsElapsed() < 200 * 1000000LL);
+
+    double seconds = timer.nsecsElapsed() / 1e9;
+    std::printf("%-10s %9d bytes  %10.1f MB/s  (%lld)\n", name, input.size(), runs * input.size() / seconds / 1e6, static_cast<long long>(checksum / runs));
+}
+
+}
+
+int main()
+{
+#ifdef NZMQT_HEXCODEC_SSE2
+    std::printf("SSSE3: %s\n", HexCodec::hasSsse3() ? "yes" : "no");
+#endif
+
+    const int sizes[] = { 64, 4096, 1024 * 1024 };
+    for (int size : sizes)
+    {
+        QByteArray data(size, Qt::Uninitialized);
+        for (int i = 0; i < size; ++i)
+        {
+            data[i] = static_cast<char>(i * 131 + (i >> 8));
+        }
+
+        if (size <= 4096)
+        {
+            measure("per byte", data, formatPerByte);
+        }
+        measure("table", data, formatScalar);
+#ifdef NZMQT_HEXCODEC_SSE2
+        if (HexCodec::hasSsse3())
+        {
+            measure("ssse3", data, formatSsse3);
+        }
+#endif
+        measure("decode", HexCodec::toSpacedHex(data), decodeText);
+    }
+    return 0;
+}
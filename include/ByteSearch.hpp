@@ -0,0 +1,134 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_BYTESEARCH_H
+#define NZMQT_BYTESEARCH_H
+
+#include <QByteArray>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NZMQT_BYTESEARCH_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#include <cstring>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Byte Search:
+Finds a byte pattern in a buffer, the verification pass of a capture search. With SSE2, 16 candidate
+positions are tested at a time by comparing the first and the last byte of the pattern against two
+overlapping loads; only positions where both match are compared in full. Patterns in payloads rarely
+share both bytes with their surroundings, so the full compare runs seldom and the loop goes at
+memory speed. Without SSE2, and for the tail, memchr finds the first byte and memcmp checks the rest.
+*/
+class ByteSearch
+{
+public:
+    /**
+     * @brief Finds the first occurrence of a pattern.
+     * @param data The buffer to search.
+     * @param size The size of the buffer.
+     * @param pattern The bytes to find, an empty pattern is found at 0.
+     * @return The offset of the first occurrence, -1 if there is none.
+     */
+    static int find(const char* data, int size, const QByteArray& pattern)
+    {
+        const int length = pattern.size();
+        if (length == 0)
+        {
+            return 0;
+        }
+        if (length > size)
+        {
+            return -1;
+        }
+
+        int from = 0;
+#ifdef NZMQT_BYTESEARCH_SSE2
+        int found = findSse2(data, size, pattern.constData(), length, &from);
+        if (found >= 0)
+        {
+            return found;
+        }
+#endif
+        return findScalar(data, size, pattern.constData(), length, from);
+    }
+
+    static bool contains(const QByteArray& data, const QByteArray& pattern)
+    {
+        return find(data.constData(), data.size(), pattern) >= 0;
+    }
+
+private:
+    static int findScalar(const char* data, int size, const char* pattern, int length, int from)
+    {
+        const char* end = data + size - length + 1;
+        for (const char* p = data + from; p < end; ++p)
+        {
+            p = static_cast<const char*>(memchr(p, pattern[0], end - p));
+            if (!p)
+            {
+                return -1;
+            }
+            if (memcmp(p + 1, pattern + 1, length - 1) == 0)
+            {
+                return static_cast<int>(p - data);
+            }
+        }
+        return -1;
+    }
+
+#ifdef NZMQT_BYTESEARCH_SSE2
+    // Tests 16 positions at a time while both loads fit, next receives the first position left untested
+    static int findSse2(const char* data, int size, const char* pattern, int length, int* next)
+    {
+        const __m128i first = _mm_set1_epi8(pattern[0]);
+        const __m128i last = _mm_set1_epi8(pattern[length - 1]);
+        int i = 0;
+        for (; i + length + 15 <= size; i += 16)
+        {
+            __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + length - 1));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast))));
+            while (mask != 0)
+            {
+                int bit = lowestBit(mask);
+                if (length <= 2 || memcmp(data + i + bit + 1, pattern + 1, length - 2) == 0)
+                {
+                    return i + bit;
+                }
+                mask &= mask - 1;
+            }
+        }
+        *next = i;
+        return -1;
+    }
+
+    static int lowestBit(unsigned mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long bit;
+        _BitScanForward(&bit, mask);
+        return static_cast<int>(bit);
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+#endif
+};
+
+}
+
+}
+
+#endif // NZMQT_BYTESEARCH_H
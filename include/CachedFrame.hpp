@@ -0,0 +1,126 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_CACHEDFRAME_H
+#define NZMQT_CACHEDFRAME_H
+
+#include "nzmqt/nzmqt.hpp"
+
+#include <QByteArray>
+
+#include <cstring>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Cached Frame:
+An encoded frame that is sent over and over again. The frame is turned into a ZeroMQ message once,
+when it is set, and every send passes a copy of that message. For frames of up to 33 bytes ZeroMQ
+keeps the bytes inside the message and the copy is a memcpy, larger frames live in one shared block
+and the copy only takes a reference on it; neither allocates. The block is allocated and filled once
+for frames below ZeroCopyThreshold, larger frames are handed to ZeroMQ without a copy. ZeroMQ drops
+its references from the I/O thread once a frame is on the wire, so replacing the frame never frees
+bytes that are still queued. Copies of a CachedFrame share the message the same way.
+*/
+class CachedFrame
+{
+public:
+    static const int ZeroCopyThreshold = 1024;
+
+    CachedFrame()
+    {
+        zmq_msg_init(&message_);
+    }
+
+    CachedFrame(const CachedFrame& other)
+        : bytes_(other.bytes_)
+    {
+        zmq_msg_init(&message_);
+        zmq_msg_copy(&message_, &other.message_);
+    }
+
+    CachedFrame& operator=(const CachedFrame& other)
+    {
+        if (this != &other)
+        {
+            // zmq_msg_copy() releases the message it overwrites
+            bytes_ = other.bytes_;
+            zmq_msg_copy(&message_, &other.message_);
+        }
+        return *this;
+    }
+
+    ~CachedFrame()
+    {
+        zmq_msg_close(&message_);
+    }
+
+    void reset(const QByteArray& bytes)
+    {
+        zmq_msg_close(&message_);
+        bytes_ = bytes;
+        if (bytes_.size() < ZeroCopyThreshold)
+        {
+            zmq_msg_init_size(&message_, bytes_.size());
+            memcpy(zmq_msg_data(&message_), bytes_.constData(), bytes_.size());
+        }
+        else
+        {
+            // The message keeps a reference on the bytes until ZeroMQ's last copy of it is gone
+            QByteArray* hold = new QByteArray(bytes_);
+            zmq_msg_init_data(&message_, const_cast<char*>(hold->constData()), hold->size(), &CachedFrame::free, hold);
+        }
+    }
+
+    const QByteArray& bytes() const
+    {
+        return bytes_;
+    }
+
+    int size() const
+    {
+        return bytes_.size();
+    }
+
+    /**
+     * @brief Sends the frame as part of a message.
+     * @param socket The socket to send on.
+     * @param flags The send flags, SND_MORE if further frames follow.
+     * @return False if the socket did not accept the frame.
+     */
+    bool send(ZMQSocket* socket, ZMQSocket::SendFlags flags) const
+    {
+        zmq_msg_t msg;
+        zmq_msg_init(&msg);
+        zmq_msg_copy(&msg, &message_);
+        if (zmq_msg_send(&msg, static_cast<void*>(*socket), static_cast<int>(flags)) < 0)
+        {
+            // A message ZeroMQ did not take is still ours
+            zmq_msg_close(&msg);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    // Called by ZeroMQ, possibly on its I/O thread
+    static void free(void* data, void* hint)
+    {
+        Q_UNUSED(data);
+        delete static_cast<QByteArray*>(hint);
+    }
+
+    QByteArray bytes_;
+    mutable zmq_msg_t message_;     // zmq_msg_copy() takes its source as non const
+};
+
+}
+
+}
+
+#endif // NZMQT_CACHEDFRAME_H
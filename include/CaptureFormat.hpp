@@ -0,0 +1,373 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_CAPTUREFORMAT_H
+#define NZMQT_CAPTUREFORMAT_H
+
+#include <QByteArray>
+#include <QRegularExpression>
+#include <QString>
+#include <QtEndian>
+#include <QtGlobal>
+
+#include <cstring>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Capture Format:
+A capture is a sequence of segment files named <prefix>.<index>.zcap, the index has five digits.
+Each segment starts with a file header followed by records.
+All integers are little endian and every record starts on an 8 byte boundary.
+
+File header (64 bytes):
+    offset  0  char[8]  magic           "ZMQCAP\0\1"
+    offset  8  quint32  version
+    offset 12  quint32  header size
+    offset 16  quint32  block size      writers flush whole blocks, 0 if unaligned
+    offset 20  quint32  segment index
+    offset 24  qint64   start time      monotonic clock in ns
+    offset 32  qint64   start time      UTC in ms since epoch, taken together with the monotonic time
+    offset 40  char[24] reserved
+
+Record header (24 bytes):
+    offset  0  quint32  record size     including header, frame table, data and padding
+    offset  4  quint16  record type
+    offset  6  quint16  frame count
+    offset  8  qint64   receive time    monotonic clock in ns
+    offset 16  quint32  topic id        assigned by the writer, see REC_TOPIC
+    offset 20  quint32  reserved
+
+A REC_MESSAGE record is followed by a table of frameCount quint32 frame sizes and the frame data.
+A REC_TOPIC record carries the topic bytes of a new topic id as its only frame.
+A REC_PADDING record fills the rest of a block and carries no data.
+Readers skip record types they do not know.
+
+Records are packed back to back and may span blocks; a writer with a block size pads the last block
+so that a segment is a whole number of blocks. Every segment announces the topics it uses itself.
+
+Index file <prefix>.<index>.zidx, written next to a segment when the segment is closed. It is sparse:
+the entries point at the first message record that starts in a block, and at the first message of
+each topic within a block. A segment without an index is still readable from the start.
+
+Index header (32 bytes):
+    offset  0  char[8]  magic           "ZMQIDX\0\1"
+    offset  8  quint32  version
+    offset 12  quint32  segment index
+    offset 16  quint32  block size
+    offset 20  quint32  time entry count
+    offset 24  quint32  topic entry count
+    offset 28  quint32  topic name count
+
+Time entry (16 bytes), in file order:
+    offset  0  qint64   receive time    of the first message that starts in a block
+    offset  8  quint64  record offset   from the start of the segment
+
+Topic entry (16 bytes), sorted by topic id and then by offset:
+    offset  0  quint32  topic id
+    offset  4  quint32  reserved
+    offset  8  quint64  record offset   of the first message of the topic within a block
+
+Topic name: quint32 topic id, quint32 size and the topic bytes, padded to 8 bytes.
+
+Search index file <prefix>.<index>.ztri, optional, written after the index. It lists for every
+trigram, three consecutive bytes of a payload frame, the blocks in which a message that contains it
+starts; frame 0, the topic, is left out.
+
+Search index header (32 bytes):
+    offset  0  char[8]  magic           "ZMQTRI\0\1"
+    offset  8  quint32  version
+    offset 12  quint32  segment index
+    offset 16  quint32  block size
+    offset 20  quint32  block count
+    offset 24  quint32  trigram count
+    offset 28  quint32  reserved
+
+Trigram entry (16 bytes), sorted by trigram:
+    offset  0  quint32  trigram         first byte in bits 16 to 23
+    offset  4  quint32  block count
+    offset  8  quint64  postings offset from the start of the file
+
+Postings: the block numbers in ascending order, each one as the LEB128 varint of its distance to the
+previous one, the first one as is.
+*/
+class CaptureFormat
+{
+public:
+    static const int FileHeaderSize = 64;
+    static const int RecordHeaderSize = 24;
+    static const int RecordAlignment = 8;
+    static const quint32 Version = 1;
+    static const int IndexHeaderSize = 32;
+    static const int IndexEntrySize = 16;
+    static const int TrigramHeaderSize = 32;
+    static const int TrigramEntrySize = 16;
+
+    enum RecordType
+    {
+        REC_PADDING = 0,
+        REC_MESSAGE = 1,
+        REC_TOPIC = 2
+    };
+
+    struct FileHeader
+    {
+        quint32 version;
+        quint32 blockSize;
+        quint32 segmentIndex;
+        qint64 startNs;
+        qint64 startUtcMs;
+    };
+
+    struct IndexHeader
+    {
+        quint32 segmentIndex;
+        quint32 blockSize;
+        quint32 timeCount;
+        quint32 topicCount;
+        quint32 nameCount;
+    };
+
+    struct TrigramHeader
+    {
+        quint32 segmentIndex;
+        quint32 blockSize;
+        quint32 blockCount;
+        quint32 trigramCount;
+    };
+
+    struct RecordHeader
+    {
+        quint32 size;
+        quint16 type;
+        quint16 frameCount;
+        qint64 receiveNs;
+        quint32 topicId;
+    };
+
+    static const char* magic()
+    {
+        return "ZMQCAP\0\1";
+    }
+
+    static const char* indexMagic()
+    {
+        return "ZMQIDX\0\1";
+    }
+
+    static const char* trigramMagic()
+    {
+        return "ZMQTRI\0\1";
+    }
+
+    static QString segmentPath(const QString& prefix, int index)
+    {
+        return QString("%1.%2.zcap").arg(prefix).arg(index, 5, 10, QChar('0'));
+    }
+
+    static QString indexPath(const QString& prefix, int index)
+    {
+        return QString("%1.%2.zidx").arg(prefix).arg(index, 5, 10, QChar('0'));
+    }
+
+    static QString trigramPath(const QString& prefix, int index)
+    {
+        return QString("%1.%2.ztri").arg(prefix).arg(index, 5, 10, QChar('0'));
+    }
+
+    /**
+     * @brief Splits a segment path into prefix and index.
+     * @param path The path of a segment file.
+     * @param prefix Receives the prefix shared by all segments of the capture.
+     * @param index Receives the segment index.
+     * @return False if the path does not follow the segment naming scheme.
+     */
+    static bool parseSegmentPath(const QString& path, QString* prefix, int* index)
+    {
+        QRegularExpressionMatch match = QRegularExpression("^(.*)\\.(\\d{5})\\.zcap$").match(path);
+        if (!match.hasMatch())
+        {
+            return false;
+        }
+
+        *prefix = match.captured(1);
+        *index = match.captured(2).toInt();
+        return true;
+    }
+
+    static quint32 align(quint32 size)
+    {
+        return (size + RecordAlignment - 1) & ~quint32(RecordAlignment - 1);
+    }
+
+    // Size of a record with the given frame sizes, including padding
+    static quint32 recordSize(int frameCount, quint64 dataSize)
+    {
+        return align(static_cast<quint32>(RecordHeaderSize + frameCount * 4 + dataSize));
+    }
+
+    static void writeFileHeader(char* dst, const FileHeader& header)
+    {
+        uchar* p = reinterpret_cast<uchar*>(dst);
+        memset(p, 0, FileHeaderSize);
+        memcpy(p, magic(), 8);
+        qToLittleEndian<quint32>(header.version, p + 8);
+        qToLittleEndian<quint32>(FileHeaderSize, p + 12);
+        qToLittleEndian<quint32>(header.blockSize, p + 16);
+        qToLittleEndian<quint32>(header.segmentIndex, p + 20);
+        qToLittleEndian<qint64>(header.startNs, p + 24);
+        qToLittleEndian<qint64>(header.startUtcMs, p + 32);
+    }
+
+    /**
+     * @brief Parses a file header.
+     * @param src At least FileHeaderSize bytes read from the start of a segment.
+     * @param header Receives the header fields.
+     * @return The size of the header, 0 if the data is not a capture file.
+     */
+    static int readFileHeader(const char* src, FileHeader* header)
+    {
+        const uchar* p = reinterpret_cast<const uchar*>(src);
+        if (memcmp(p, magic(), 8) != 0)
+        {
+            return 0;
+        }
+
+        header->version = qFromLittleEndian<quint32>(p + 8);
+        header->blockSize = qFromLittleEndian<quint32>(p + 16);
+        header->segmentIndex = qFromLittleEndian<quint32>(p + 20);
+        header->startNs = qFromLittleEndian<qint64>(p + 24);
+        header->startUtcMs = qFromLittleEndian<qint64>(p + 32);
+
+        quint32 size = qFromLittleEndian<quint32>(p + 12);
+        return size < FileHeaderSize ? 0 : static_cast<int>(size);
+    }
+
+    static void writeRecordHeader(char* dst, const RecordHeader& header)
+    {
+        uchar* p = reinterpret_cast<uchar*>(dst);
+        qToLittleEndian<quint32>(header.size, p);
+        qToLittleEndian<quint16>(header.type, p + 4);
+        qToLittleEndian<quint16>(header.frameCount, p + 6);
+        qToLittleEndian<qint64>(header.receiveNs, p + 8);
+        qToLittleEndian<quint32>(header.topicId, p + 16);
+        qToLittleEndian<quint32>(0, p + 20);
+    }
+
+    static void readRecordHeader(const char* src, RecordHeader* header)
+    {
+        const uchar* p = reinterpret_cast<const uchar*>(src);
+        header->size = qFromLittleEndian<quint32>(p);
+        header->type = qFromLittleEndian<quint16>(p + 4);
+        header->frameCount = qFromLittleEndian<quint16>(p + 6);
+        header->receiveNs = qFromLittleEndian<qint64>(p + 8);
+        header->topicId = qFromLittleEndian<quint32>(p + 16);
+    }
+
+    static void writeIndexHeader(char* dst, const IndexHeader& header)
+    {
+        uchar* p = reinterpret_cast<uchar*>(dst);
+        memcpy(p, indexMagic(), 8);
+        qToLittleEndian<quint32>(Version, p + 8);
+        qToLittleEndian<quint32>(header.segmentIndex, p + 12);
+        qToLittleEndian<quint32>(header.blockSize, p + 16);
+        qToLittleEndian<quint32>(header.timeCount, p + 20);
+        qToLittleEndian<quint32>(header.topicCount, p + 24);
+        qToLittleEndian<quint32>(header.nameCount, p + 28);
+    }
+
+    /**
+     * @brief Parses an index header.
+     * @param src At least IndexHeaderSize bytes read from the start of an index file.
+     * @param header Receives the header fields.
+     * @return False if the data is not a supported index file.
+     */
+    static bool readIndexHeader(const char* src, IndexHeader* header)
+    {
+        const uchar* p = reinterpret_cast<const uchar*>(src);
+        if (memcmp(p, indexMagic(), 8) != 0 || qFromLittleEndian<quint32>(p + 8) > Version)
+        {
+            return false;
+        }
+
+        header->segmentIndex = qFromLittleEndian<quint32>(p + 12);
+        header->blockSize = qFromLittleEndian<quint32>(p + 16);
+        header->timeCount = qFromLittleEndian<quint32>(p + 20);
+        header->topicCount = qFromLittleEndian<quint32>(p + 24);
+        header->nameCount = qFromLittleEndian<quint32>(p + 28);
+        return true;
+    }
+
+    static void writeTrigramHeader(char* dst, const TrigramHeader& header)
+    {
+        uchar* p = reinterpret_cast<uchar*>(dst);
+        memcpy(p, trigramMagic(), 8);
+        qToLittleEndian<quint32>(Version, p + 8);
+        qToLittleEndian<quint32>(header.segmentIndex, p + 12);
+        qToLittleEndian<quint32>(header.blockSize, p + 16);
+        qToLittleEndian<quint32>(header.blockCount, p + 20);
+        qToLittleEndian<quint32>(header.trigramCount, p + 24);
+        qToLittleEndian<quint32>(0, p + 28);
+    }
+
+    /**
+     * @brief Parses a search index header.
+     * @param src At least TrigramHeaderSize bytes read from the start of a search index file.
+     * @param header Receives the header fields.
+     * @return False if the data is not a supported search index file.
+     */
+    static bool readTrigramHeader(const char* src, TrigramHeader* header)
+    {
+        const uchar* p = reinterpret_cast<const uchar*>(src);
+        if (memcmp(p, trigramMagic(), 8) != 0 || qFromLittleEndian<quint32>(p + 8) > Version)
+        {
+            return false;
+        }
+
+        header->segmentIndex = qFromLittleEndian<quint32>(p + 12);
+        header->blockSize = qFromLittleEndian<quint32>(p + 16);
+        header->blockCount = qFromLittleEndian<quint32>(p + 20);
+        header->trigramCount = qFromLittleEndian<quint32>(p + 24);
+        return true;
+    }
+
+    // Writes a time or topic entry, the first field is a receive time or a topic id
+    static void writeIndexEntry(char* dst, qint64 key, quint64 offset)
+    {
+        uchar* p = reinterpret_cast<uchar*>(dst);
+        qToLittleEndian<qint64>(key, p);
+        qToLittleEndian<quint64>(offset, p + 8);
+    }
+
+    static void readIndexEntry(const char* src, qint64* key, quint64* offset)
+    {
+        const uchar* p = reinterpret_cast<const uchar*>(src);
+        *key = qFromLittleEndian<qint64>(p);
+        *offset = qFromLittleEndian<quint64>(p + 8);
+    }
+
+    /**
+     * @brief Checks that a record header describes a record that fits the available bytes.
+     * @param header The parsed record header.
+     * @param available The bytes available from the start of the record.
+     * @return True if the frame table and the record size are consistent.
+     */
+    static bool isValidRecord(const RecordHeader& header, quint64 available)
+    {
+        return header.size >= RecordHeaderSize
+            && header.size % RecordAlignment == 0
+            && header.size <= available
+            && RecordHeaderSize + quint64(header.frameCount) * 4 <= header.size;
+    }
+};
+
+}
+
+}
+
+#endif // NZMQT_CAPTUREFORMAT_H
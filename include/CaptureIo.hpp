@@ -0,0 +1,560 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_CAPTUREIO_H
+#define NZMQT_CAPTUREIO_H
+
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+#include <QtGlobal>
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(Q_OS_LINUX) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define NZMQT_CAPTUREIO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+// Headers of kernels before 5.4 lack it, the feature bit is the same everywhere
+#if defined(NZMQT_CAPTUREIO_URING) && !defined(IORING_FEAT_SINGLE_MMAP)
+#define IORING_FEAT_SINGLE_MMAP (1U << 0)
+#endif
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Capture File:
+A segment opened for positional writes, so that several blocks can be in flight at once. On Unix
+it is a plain descriptor, optionally opened with O_DIRECT, which needs the block buffers, offsets
+and sizes aligned to the device's logical block size; the capture blocks are 4096 byte aligned.
+Elsewhere a QFile serializes seek and write, and sync() only flushes to the operating system.
+*/
+class CaptureFile
+{
+    Q_DISABLE_COPY(CaptureFile)
+
+public:
+    CaptureFile()
+        : fd_(-1)
+    {
+    }
+
+    ~CaptureFile()
+    {
+        close();
+    }
+
+    /**
+     * @brief Creates or truncates the file.
+     * @param path The path of the file.
+     * @param direct Bypasses the page cache where the platform supports it.
+     * @param error Receives the reason if the file cannot be created.
+     * @return False on error.
+     */
+    bool open(const QString& path, bool direct, QString* error)
+    {
+#ifdef Q_OS_UNIX
+        int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+        flags |= direct ? O_DIRECT : 0;
+#else
+        Q_UNUSED(direct);
+#endif
+        fd_ = ::open(QFile::encodeName(path).constData(), flags, 0644);
+        if (fd_ < 0)
+        {
+            *error = QString("%1: %2").arg(path, QString::fromLocal8Bit(strerror(errno)));
+            return false;
+        }
+        return true;
+#else
+        Q_UNUSED(direct);
+        file_.setFileName(path);
+        if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            *error = QString("%1: %2").arg(path, file_.errorString());
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    // The descriptor for io_uring, -1 where there is none
+    int handle() const
+    {
+        return fd_;
+    }
+
+    // Writes size bytes at offset, may be called from several threads; returns the bytes written or -errno
+    qint64 write(const char* data, qint64 size, qint64 offset)
+    {
+#ifdef Q_OS_UNIX
+        qint64 done = 0;
+        while (done < size)
+        {
+            ssize_t n = ::pwrite(fd_, data + done, size - done, offset + done);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                return n < 0 ? -errno : -EIO;
+            }
+            done += n;
+        }
+        return done;
+#else
+        QMutexLocker locker(&mutex_);
+        if (!file_.seek(offset) || file_.write(data, size) != size)
+        {
+            return -EIO;
+        }
+        return size;
+#endif
+    }
+
+    // Waits until the data written so far is on the device, returns 0 or -errno
+    int sync()
+    {
+#if defined(Q_OS_LINUX)
+        return ::fdatasync(fd_) == 0 ? 0 : -errno;
+#elif defined(Q_OS_UNIX)
+        return ::fsync(fd_) == 0 ? 0 : -errno;
+#else
+        QMutexLocker locker(&mutex_);
+        return file_.flush() ? 0 : -EIO;
+#endif
+    }
+
+    void close()
+    {
+#ifdef Q_OS_UNIX
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+#else
+        file_.close();
+#endif
+    }
+
+private:
+    int fd_;
+#ifndef Q_OS_UNIX
+    QFile file_;
+    QMutex mutex_;
+#endif
+};
+
+// A finished write, result is the number of bytes written or -errno
+struct IoCompletion
+{
+    char* block;
+    qint64 result;
+};
+
+/*
+Capture IO:
+Writes capture blocks asynchronously with up to depth() writes in flight. submit() and reap() are
+called on the capture writer thread only. create() prefers io_uring and falls back to a pool of
+threads doing positional writes where io_uring is not compiled in or the kernel refuses it, e.g. a
+kernel older than 5.1 or a container that filters the system call.
+*/
+class CaptureIo
+{
+public:
+    virtual ~CaptureIo() {}
+
+    virtual QString name() const = 0;
+
+    int depth() const
+    {
+        return depth_;
+    }
+
+    int inFlight() const
+    {
+        return inFlight_;
+    }
+
+    /**
+     * @brief Starts writing a block, only called while inFlight() is below depth().
+     * @param file The segment, it must stay open until the write completed.
+     * @param block The data, it is returned by reap() once written.
+     * @param size The size of the block.
+     * @param offset The offset in the file.
+     * @return None
+     */
+    virtual void submit(CaptureFile* file, char* block, int size, qint64 offset) = 0;
+
+    /**
+     * @brief Collects finished writes.
+     * @param wait Waits for at least one write if none has finished, only if writes are in flight.
+     * @param completions Receives the finished writes.
+     * @return None
+     */
+    virtual void reap(bool wait, QVector<IoCompletion>* completions) = 0;
+
+    static CaptureIo* create(int depth, QString* fallbackReason);
+
+protected:
+    explicit CaptureIo(int depth)
+        : depth_(depth), inFlight_(0)
+    {
+    }
+
+    int depth_;
+    int inFlight_;
+};
+
+// Positional writes on depth threads of their own
+class PwriteCaptureIo : public CaptureIo
+{
+public:
+    explicit PwriteCaptureIo(int depth)
+        : CaptureIo(depth), stopping_(false)
+    {
+        for (int i = 0; i < depth; ++i)
+        {
+            QThread* thread = QThread::create([this]() { work(); });
+            thread->start();
+            threads_.append(thread);
+        }
+    }
+
+    ~PwriteCaptureIo() override
+    {
+        {
+            QMutexLocker locker(&mutex_);
+            stopping_ = true;
+            requested_.wakeAll();
+        }
+        for (QThread* thread : threads_)
+        {
+            thread->wait();
+            delete thread;
+        }
+    }
+
+    QString name() const override
+    {
+        return "pwrite";
+    }
+
+    void submit(CaptureFile* file, char* block, int size, qint64 offset) override
+    {
+        Request request;
+        request.file = file;
+        request.block = block;
+        request.size = size;
+        request.offset = offset;
+
+        QMutexLocker locker(&mutex_);
+        requests_.enqueue(request);
+        ++inFlight_;
+        requested_.wakeOne();
+    }
+
+    void reap(bool wait, QVector<IoCompletion>* completions) override
+    {
+        QMutexLocker locker(&mutex_);
+        while (wait && completed_.isEmpty() && inFlight_ > 0)
+        {
+            finished_.wait(&mutex_);
+        }
+        for (const IoCompletion& completion : completed_)
+        {
+            completions->append(completion);
+        }
+        inFlight_ -= completed_.size();
+        completed_.clear();
+    }
+
+private:
+    struct Request
+    {
+        CaptureFile* file;
+        char* block;
+        int size;
+        qint64 offset;
+    };
+
+    void work()
+    {
+        for (;;)
+        {
+            Request request;
+            {
+                QMutexLocker locker(&mutex_);
+                while (requests_.isEmpty() && !stopping_)
+                {
+                    requested_.wait(&mutex_);
+                }
+                if (requests_.isEmpty())
+                {
+                    return;
+                }
+                request = requests_.dequeue();
+            }
+
+            IoCompletion completion;
+            completion.block = request.block;
+            completion.result = request.file->write(request.block, request.size, request.offset);
+
+            QMutexLocker locker(&mutex_);
+            completed_.append(completion);
+            finished_.wakeOne();
+        }
+    }
+
+    QVector<QThread*> threads_;
+    QMutex mutex_;
+    QWaitCondition requested_;
+    QWaitCondition finished_;
+    QQueue<Request> requests_;
+    QVector<IoCompletion> completed_;
+    bool stopping_;
+};
+
+#ifdef NZMQT_CAPTUREIO_URING
+/*
+io_uring:
+Talks to the kernel through the system calls and the shared rings directly, so no liburing is
+needed. Each write is an IORING_OP_WRITEV of one buffer, which every io_uring kernel supports; the
+iovec of a write lives in its slot until the write completed. Submission and completion use the
+acquire and release ordering the ring protocol asks for. When the kernel does not take a submission,
+e.g. EAGAIN or EBUSY under memory or completion queue pressure, the entry is withdrawn and the block
+is written with pwrite instead; its completion is handed out by the next reap().
+*/
+class UringCaptureIo : public CaptureIo
+{
+public:
+    explicit UringCaptureIo(int depth)
+        : CaptureIo(depth), ring_(-1), sqRing_(MAP_FAILED), cqRing_(MAP_FAILED), sqes_(MAP_FAILED)
+        , sqRingSize_(0), cqRingSize_(0), sqesSize_(0)
+    {
+    }
+
+    ~UringCaptureIo() override
+    {
+        // Pending writes would write into freed blocks, the capture writer reaps them all before
+        if (sqes_ != MAP_FAILED)
+        {
+            munmap(sqes_, sqesSize_);
+        }
+        if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_)
+        {
+            munmap(cqRing_, cqRingSize_);
+        }
+        if (sqRing_ != MAP_FAILED)
+        {
+            munmap(sqRing_, sqRingSize_);
+        }
+        if (ring_ >= 0)
+        {
+            ::close(ring_);
+        }
+    }
+
+    // Sets up the rings, returns false with the reason if the kernel refuses
+    bool initialize(QString* error)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring_ = static_cast<int>(syscall(__NR_io_uring_setup, depth_, &params));
+        if (ring_ < 0)
+        {
+            *error = QString("io_uring_setup: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+            return false;
+        }
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single)
+        {
+            sqRingSize_ = cqRingSize_ = qMax(sqRingSize_, cqRingSize_);
+        }
+
+        sqRing_ = mmap(0, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQ_RING);
+        cqRing_ = single ? sqRing_ : mmap(0, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_CQ_RING);
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = mmap(0, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQES);
+        if (sqRing_ == MAP_FAILED || cqRing_ == MAP_FAILED || sqes_ == MAP_FAILED)
+        {
+            *error = QString("io_uring mmap: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sqRing_);
+        char* cq = static_cast<char*>(cqRing_);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        slots_.resize(depth_);
+        for (int i = depth_ - 1; i >= 0; --i)
+        {
+            freeSlots_.append(i);
+        }
+        return true;
+    }
+
+    QString name() const override
+    {
+        return "io_uring";
+    }
+
+    void submit(CaptureFile* file, char* block, int size, qint64 offset) override
+    {
+        int slot = freeSlots_.takeLast();
+        slots_[slot].block = block;
+        slots_[slot].iov.iov_base = block;
+        slots_[slot].iov.iov_len = size;
+
+        unsigned tail = *sqTail_;
+        unsigned index = tail & sqMask_;
+        io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_WRITEV;
+        sqe->fd = file->handle();
+        sqe->addr = reinterpret_cast<quint64>(&slots_[slot].iov);
+        sqe->len = 1;
+        sqe->off = offset;
+        sqe->user_data = slot;
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+
+        ++inFlight_;
+        if (enter(1, 0, 0) != 1)
+        {
+            // Without SQPOLL only io_uring_enter() consumes entries, so the one not taken can be withdrawn
+            __atomic_store_n(sqTail_, tail, __ATOMIC_RELEASE);
+            freeSlots_.append(slot);
+
+            IoCompletion completion;
+            completion.block = block;
+            completion.result = file->write(block, size, offset);
+            written_.append(completion);
+        }
+    }
+
+    void reap(bool wait, QVector<IoCompletion>* completions) override
+    {
+        for (;;)
+        {
+            unsigned head = *cqHead_;
+            unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            int found = written_.size();
+            for (const IoCompletion& completion : written_)
+            {
+                completions->append(completion);
+            }
+            written_.clear();
+            for (; head != tail; ++head, ++found)
+            {
+                const io_uring_cqe& cqe = cqes_[head & cqMask_];
+                int slot = static_cast<int>(cqe.user_data);
+                IoCompletion completion;
+                completion.block = slots_.at(slot).block;
+                completion.result = cqe.res == static_cast<int>(slots_.at(slot).iov.iov_len) || cqe.res < 0 ? cqe.res : -EIO;
+                completions->append(completion);
+                freeSlots_.append(slot);
+            }
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+            inFlight_ -= found;
+
+            if (found > 0 || !wait || inFlight_ == 0)
+            {
+                return;
+            }
+            enter(0, 1, IORING_ENTER_GETEVENTS);
+        }
+    }
+
+private:
+    // io_uring_enter() restarted after signals, returns the entries submitted or -1 with errno
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags)
+    {
+        long result;
+        while ((result = syscall(__NR_io_uring_enter, ring_, toSubmit, minComplete, flags, 0, 0)) < 0 && errno == EINTR)
+        {
+        }
+        return static_cast<int>(result);
+    }
+
+    struct Slot
+    {
+        char* block;
+        iovec iov;
+    };
+
+    int ring_;
+    void* sqRing_;
+    void* cqRing_;
+    void* sqes_;
+    size_t sqRingSize_;
+    size_t cqRingSize_;
+    size_t sqesSize_;
+    unsigned* sqTail_;
+    unsigned sqMask_;
+    unsigned* sqArray_;
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe* cqes_;
+    QVector<Slot> slots_;
+    QVector<int> freeSlots_;
+    QVector<IoCompletion> written_;     // Blocks written with pwrite because a submission failed, not reaped yet
+};
+#endif
+
+inline CaptureIo* CaptureIo::create(int depth, QString* fallbackReason)
+{
+    depth = qMax(1, depth);
+#ifdef NZMQT_CAPTUREIO_URING
+    UringCaptureIo* uring = new UringCaptureIo(depth);
+    if (uring->initialize(fallbackReason))
+    {
+        return uring;
+    }
+    delete uring;
+#else
+    *fallbackReason = "io_uring is not available on this platform";
+#endif
+    return new PwriteCaptureIo(depth);
+}
+
+}
+
+}
+
+#endif // NZMQT_CAPTUREIO_H
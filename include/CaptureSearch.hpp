@@ -0,0 +1,243 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_CAPTURESEARCH_H
+#define NZMQT_CAPTURESEARCH_H
+
+#include "ByteSearch.hpp"
+#include "CaptureFormat.hpp"
+#include "MappedCapture.hpp"
+#include "TrigramIndex.hpp"
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QMetaType>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QtConcurrent/QtConcurrent>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+// A message that contains the pattern, the position is valid for a MappedCapture opened on the same path
+struct CaptureMatch
+{
+    int segment;
+    quint64 offset;
+
+    CaptureMatch() : segment(0), offset(0) {}
+    CaptureMatch(int s, quint64 o) : segment(s), offset(o) {}
+};
+
+typedef QVector<CaptureMatch> CaptureMatches;
+
+struct CaptureSearchSummary
+{
+    quint64 matches;
+    bool truncated;             // The search stopped at MaxMatches
+    int segments;
+    int indexedSegments;        // Segments with a search index, the others were scanned
+    quint64 blocks;             // Blocks of all segments
+    quint64 candidateBlocks;    // Blocks read, those the indexes could not rule out
+    quint64 messages;           // Messages verified
+    qint64 elapsedNs;
+    QString error;
+
+    CaptureSearchSummary()
+        : matches(0), truncated(false), segments(0), indexedSegments(0), blocks(0), candidateBlocks(0), messages(0), elapsedNs(0)
+    {
+    }
+};
+
+/*
+Capture Search:
+Finds the messages of a capture whose payload frames contain a byte pattern, on the global thread
+pool. Per segment the search index narrows the blocks down to those that contain every trigram of the
+pattern, a segment without one is scanned whole, and the messages of the remaining blocks are verified
+with ByteSearch. Matches are handed to the GUI thread in batches while the search goes on, so the
+first ones show up long before a large capture is done. A new search or cancel() ends the running
+one; results still queued for it are dropped, every report is checked against the current search in
+the GUI thread before it is emitted.
+*/
+class CaptureSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int BatchSize = 256;
+    static const int BatchMsec = 100;
+    static const int MaxMatches = 100000;
+
+    explicit CaptureSearch(QObject* parent = 0)
+        : QObject(parent), generation_(0)
+    {
+    }
+
+    ~CaptureSearch()
+    {
+        cancel();
+    }
+
+    /**
+     * @brief Starts a search, a running one is cancelled first.
+     * @param path A segment of the capture, the following segments are searched too.
+     * @param pattern The bytes to find in the payload frames, the topic frame is not searched.
+     * @return None
+     */
+    void start(const QString& path, const QByteArray& pattern)
+    {
+        cancel();
+        int generation = generation_.fetchAndAddOrdered(1) + 1;
+        future_ = QtConcurrent::run([this, path, pattern, generation]() { run(path, pattern, generation); });
+    }
+
+    // Ends the running search and waits for it, nothing more is emitted for it
+    void cancel()
+    {
+        generation_.fetchAndAddOrdered(1);
+        future_.waitForFinished();
+    }
+
+    bool isRunning() const
+    {
+        return future_.isRunning();
+    }
+
+signals:
+    void matchesFound(const nzmqt::samples::CaptureMatches& matches);
+    void searchFinished(const nzmqt::samples::CaptureSearchSummary& summary);
+
+private:
+    bool isCurrent(int generation) const
+    {
+        return generation_.loadAcquire() == generation;
+    }
+
+    void run(const QString& path, const QByteArray& pattern, int generation)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        CaptureSearchSummary summary;
+        MappedCapture capture;
+        if (!capture.open(path, &summary.error))
+        {
+            post(generation, CaptureMatches(), &summary);
+            return;
+        }
+
+        QString prefix;
+        int first = 0;
+        bool named = CaptureFormat::parseSegmentPath(path, &prefix, &first);
+        summary.segments = capture.segmentCount();
+
+        CaptureMatches batch;
+        qint64 postedNs = 0;
+        for (int segment = 0; segment < capture.segmentCount(); ++segment)
+        {
+            const quint32 blockSize = capture.blockSize(segment);
+            const quint32 blockCount = capture.blockCount(segment);
+            summary.blocks += blockCount;
+
+            TrigramIndex index;
+            QVector<quint32> blocks;
+            if (named && index.open(CaptureFormat::trigramPath(prefix, capture.segmentIndex(segment)), capture.segmentIndex(segment))
+                && index.blockSize() == blockSize)
+            {
+                ++summary.indexedSegments;
+                blocks = index.candidates(pattern);
+            }
+            else
+            {
+                blocks.reserve(blockCount);
+                for (quint32 block = 0; block < blockCount; ++block)
+                {
+                    blocks.append(block);
+                }
+            }
+
+            for (quint32 block : blocks)
+            {
+                if (!isCurrent(generation))
+                {
+                    return;
+                }
+
+                ++summary.candidateBlocks;
+                const quint64 blockEnd = quint64(block + 1) * blockSize;
+                for (CaptureCursor cursor = capture.block(segment, block); cursor.isValid() && cursor.segment() == segment && cursor.offset() < blockEnd; cursor.next())
+                {
+                    ++summary.messages;
+                    for (int i = 1; i < cursor.frameCount(); ++i)
+                    {
+                        if (ByteSearch::contains(cursor.frame(i), pattern))
+                        {
+                            batch.append(CaptureMatch(segment, cursor.offset()));
+                            break;
+                        }
+                    }
+                }
+
+                if (summary.matches + batch.size() >= static_cast<quint64>(MaxMatches))
+                {
+                    summary.truncated = true;
+                    break;
+                }
+                if (batch.size() >= BatchSize || (!batch.isEmpty() && timer.nsecsElapsed() - postedNs > BatchMsec * 1000000LL))
+                {
+                    summary.matches += batch.size();
+                    post(generation, batch, 0);
+                    batch.clear();
+                    postedNs = timer.nsecsElapsed();
+                }
+            }
+            if (summary.truncated)
+            {
+                break;
+            }
+        }
+
+        summary.matches += batch.size();
+        summary.elapsedNs = timer.nsecsElapsed();
+        post(generation, batch, &summary);
+    }
+
+    // Emits in the GUI thread, unless another search started meanwhile
+    void post(int generation, const CaptureMatches& matches, const CaptureSearchSummary* summary)
+    {
+        bool finished = summary != 0;
+        CaptureSearchSummary result = finished ? *summary : CaptureSearchSummary();
+        QMetaObject::invokeMethod(this, [this, generation, matches, finished, result]() {
+            if (!isCurrent(generation))
+            {
+                return;
+            }
+            if (!matches.isEmpty())
+            {
+                emit matchesFound(matches);
+            }
+            if (finished)
+            {
+                emit searchFinished(result);
+            }
+        }, Qt::QueuedConnection);
+    }
+
+    QAtomicInt generation_;
+    QFuture<void> future_;
+};
+
+}
+
+}
+
+Q_DECLARE_METATYPE(nzmqt::samples::CaptureMatches)
+Q_DECLARE_METATYPE(nzmqt::samples::CaptureSearchSummary)
+
+#endif // NZMQT_CAPTURESEARCH_H
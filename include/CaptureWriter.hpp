@@ -0,0 +1,852 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_CAPTUREWRITER_H
+#define NZMQT_CAPTUREWRITER_H
+
+#include "CaptureFormat.hpp"
+#include "CaptureIo.hpp"
+#include "TrigramIndex.hpp"
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QScopedPointer>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+// How a recording writes to disk, fixed when it starts
+struct CaptureOptions
+{
+    enum Backpressure
+    {
+        DROP,               // Drops messages while every block is queued, the subscriber never waits
+        BLOCK               // Waits for a block, the socket's high water mark then pushes back on the publisher
+    };
+
+    int queueDepth;         // Writes in flight
+    bool directIo;          // O_DIRECT, falls back to the page cache where the file system refuses it
+    Backpressure backpressure;
+    bool searchIndex;       // Builds the search index of each closed segment, see TrigramIndex.hpp
+
+    CaptureOptions()
+        : queueDepth(8), directIo(false), backpressure(DROP), searchIndex(false)
+    {
+    }
+};
+
+// Progress of a recording, reported once per second while recording
+struct CaptureStatus
+{
+    bool recording;
+    QString path;           // Segment being written
+    QString io;             // Write backend, with the reason io_uring is not used
+    quint64 records;        // Messages accepted
+    quint64 bytes;          // Bytes written to disk, file headers and padding included
+    quint64 dropped;        // Messages not recorded because the disk fell behind or they do not fit a record
+    quint64 stalls;         // Times the subscriber waited for a block, see CaptureOptions::BLOCK
+    qint64 stalledNs;       // Time the subscriber waited in total
+    double throughput;      // Bytes/s written since the previous status
+    int queueDepth;
+    int peakInFlight;       // Most writes in flight since the previous status
+    qint64 lastSyncNs;      // Duration of the data sync of the last closed segment, -1 before the first
+    qint64 maxSyncNs;
+    int segments;
+    qint64 lastSearchIndexNs;   // Build time of the search index of the last closed segment, -1 before the first
+    QString searchIndexError;   // Why the last search index was not written, the segment is scanned instead
+    QString error;          // The first write error, recording stops writing on an error
+
+    CaptureStatus()
+        : recording(false), records(0), bytes(0), dropped(0), stalls(0), stalledNs(0), throughput(0.0)
+        , queueDepth(0), peakInFlight(0), lastSyncNs(-1), maxSyncNs(0), segments(0), lastSearchIndexNs(-1)
+    {
+    }
+};
+
+/*
+Capture Writer:
+Records received messages into a capture, see CaptureFormat.hpp. write() runs on the socket thread
+and only copies the record into the current block, one of PoolBlocks aligned buffers of BlockSize
+bytes, so memory is bounded whatever the disk does. A full block is queued to a writer thread that
+keeps up to queueDepth writes in flight through CaptureIo, io_uring or a pwrite pool, and hands each
+buffer back when its write completed. When all buffers are queued the backpressure policy decides:
+DROP counts the message as dropped and the subscriber never waits for the disk, BLOCK waits for a
+buffer and loses nothing as long as the disk keeps up on average.
+Segments are rotated after SegmentSize bytes; while a segment is written the writer notes the first
+record of every block and of every topic within a block, and writes that as the sidecar index when
+the segment is closed. The data sync of a closed segment runs on the global thread pool, so rotating
+does not stall the writes of the next segment, and its duration is reported. With searchIndex the
+search index of the segment is built there too, once its data is on disk, so recording never pays
+for it.
+*/
+class CaptureWriter
+{
+    Q_DISABLE_COPY(CaptureWriter)
+
+public:
+    static const int BlockSize = 1024 * 1024;
+    static const int PoolBlocks = 64;
+    static const qint64 SegmentSize = 1024LL * 1024 * 1024;
+    static const int MaxRecordSize = 64 * 1024 * 1024;  // The readers' limit
+
+    CaptureWriter()
+        : thread_(0), block_(0), used_(0), blockSerial_(0), blockIndexed_(false)
+        , segmentIndex_(0), segmentOffset_(0), records_(0), dropped_(0), stalls_(0), stalledNs_(0)
+        , reportedBytes_(0), reportedNs_(0)
+        , freeBlocks_(0), bytesWritten_(0), failed_(0), peakInFlight_(0), lastSyncNs_(-1), maxSyncNs_(0)
+    {
+    }
+
+    ~CaptureWriter()
+    {
+        close();
+    }
+
+    bool isOpen() const
+    {
+        return thread_ != 0;
+    }
+
+    /**
+     * @brief Starts a new capture and its writer thread.
+     * @param prefix The segments are named <prefix>.<index>.zcap.
+     * @param startNs The monotonic time, stored in the file header.
+     * @param options Queue depth, direct IO and backpressure policy.
+     * @param error Receives the reason if the capture cannot be started.
+     * @return False if the capture exists already or a file cannot be created.
+     */
+    bool open(const QString& prefix, qint64 startNs, const CaptureOptions& options, QString* error)
+    {
+        close();
+        if (QFile::exists(CaptureFormat::segmentPath(prefix, 0)))
+        {
+            *error = QString("%1 exists already").arg(CaptureFormat::segmentPath(prefix, 0));
+            return false;
+        }
+
+        QFile probe(CaptureFormat::segmentPath(prefix, 0));
+        if (!probe.open(QIODevice::WriteOnly))
+        {
+            *error = probe.errorString();
+            return false;
+        }
+        probe.close();
+
+        prefix_ = prefix;
+        options_ = options;
+        options_.queueDepth = qBound(1, options.queueDepth, PoolBlocks / 2);
+        segmentIndex_ = 0;
+        records_ = 0;
+        dropped_ = 0;
+        stalls_ = 0;
+        stalledNs_ = 0;
+        reportedBytes_ = 0;
+        reportedNs_ = startNs;
+        bytesWritten_.store(0);
+        failed_.store(0);
+        peakInFlight_.store(0);
+        lastSyncNs_.store(-1);
+        maxSyncNs_.store(0);
+        lastSearchIndexNs_.store(-1);
+        error_.clear();
+        searchIndexError_.clear();
+        io_.clear();
+        topicIds_.clear();
+        topicNames_.clear();
+        topicSegment_.clear();
+        topicBlock_.clear();
+
+        for (int i = 0; i < PoolBlocks; ++i)
+        {
+            pool_.append(static_cast<char*>(qMallocAligned(BlockSize, 4096)));
+        }
+        freeBlocks_.store(PoolBlocks);
+
+        thread_ = QThread::create([this]() { run(); });
+        thread_->start();
+        startSegment(startNs);
+        return true;
+    }
+
+    // Flushes the last block and the index and waits for the writer thread
+    void close()
+    {
+        if (!isOpen())
+        {
+            return;
+        }
+
+        finishSegment();
+        enqueue(Job(JOB_STOP));
+        thread_->wait();
+        delete thread_;
+        thread_ = 0;
+
+        qFreeAligned(block_);
+        block_ = 0;
+
+        for (char* block : pool_)
+        {
+            qFreeAligned(block);
+        }
+        pool_.clear();
+    }
+
+    /**
+     * @brief Records a message, called on the socket thread.
+     * @param msg The frames of the message, the topic first.
+     * @param receiveNs The monotonic receive time.
+     * @return None
+     */
+    void write(const QList<QByteArray>& msg, qint64 receiveNs)
+    {
+        if (!isOpen() || msg.isEmpty())
+        {
+            return;
+        }
+        if (failed_.load() != 0)
+        {
+            ++dropped_;
+            return;
+        }
+
+        quint64 dataSize = 0;
+        for (const QByteArray& frame : msg)
+        {
+            dataSize += frame.size();
+        }
+        if (msg.size() > 0xFFFF || CaptureFormat::recordSize(msg.size(), dataSize) > static_cast<quint32>(MaxRecordSize))
+        {
+            ++dropped_;
+            return;
+        }
+
+        // Padding the last block takes a buffer, with none free the segment grows a little longer
+        if (segmentOffset_ + used_ >= SegmentSize && freeBlocks_.load() > 0)
+        {
+            finishSegment();
+            startSegment(receiveNs);
+        }
+
+        // Announcing a new topic adds a record, the message is only accepted if both fit
+        quint32 topicId = internTopic(msg.first());
+        bool announce = topicSegment_.at(topicId) != segmentIndex_;
+        quint64 size = CaptureFormat::recordSize(msg.size(), dataSize);
+        if (announce)
+        {
+            size += CaptureFormat::recordSize(1, msg.first().size());
+        }
+        if (!reserve(size))
+        {
+            if (options_.backpressure == CaptureOptions::DROP)
+            {
+                ++dropped_;
+                return;
+            }
+            ++stalls_;      // takeBlock() waits for the writer thread
+        }
+
+        if (announce)
+        {
+            QList<QByteArray> topic;
+            topic.append(msg.first());
+            appendRecord(CaptureFormat::REC_TOPIC, topic, msg.first().size(), receiveNs, topicId);
+            topicSegment_[topicId] = segmentIndex_;
+        }
+
+        noteIndex(topicId, receiveNs);
+        appendRecord(CaptureFormat::REC_MESSAGE, msg, dataSize, receiveNs, topicId);
+        ++records_;
+    }
+
+    // Live changes of the policy are safe, the socket thread is the only one reading it
+    void setBackpressure(CaptureOptions::Backpressure backpressure)
+    {
+        options_.backpressure = backpressure;
+    }
+
+    /**
+     * @brief Takes the counters, called on the socket thread; the throughput and peak refer to the previous call.
+     * @param nowNs The monotonic time.
+     * @return The status of the recording.
+     */
+    CaptureStatus status(qint64 nowNs)
+    {
+        CaptureStatus status;
+        status.recording = isOpen() && failed_.load() == 0;
+        status.path = CaptureFormat::segmentPath(prefix_, segmentIndex_);
+        status.records = records_;
+        status.bytes = bytesWritten_.load();
+        status.dropped = dropped_;
+        status.stalls = stalls_;
+        status.stalledNs = stalledNs_;
+        status.queueDepth = options_.queueDepth;
+        status.peakInFlight = peakInFlight_.fetchAndStoreOrdered(0);
+        status.lastSyncNs = lastSyncNs_.load();
+        status.maxSyncNs = maxSyncNs_.load();
+        status.segments = segmentIndex_ + 1;
+        status.lastSearchIndexNs = lastSearchIndexNs_.load();
+        if (nowNs > reportedNs_)
+        {
+            status.throughput = (status.bytes - reportedBytes_) * 1e9 / (nowNs - reportedNs_);
+        }
+        reportedBytes_ = status.bytes;
+        reportedNs_ = nowNs;
+
+        QMutexLocker locker(&mutex_);
+        status.io = io_;
+        status.error = error_;
+        status.searchIndexError = searchIndexError_;
+        return status;
+    }
+
+private:
+    enum JobType
+    {
+        JOB_OPEN,           // Creates the segment file at path
+        JOB_BLOCK,          // Appends block to the segment and returns it to the pool
+        JOB_CLOSE,          // Closes the segment and writes data to the index file at path
+        JOB_STOP
+    };
+
+    struct Job
+    {
+        JobType type;
+        QString path;
+        char* block;
+        QByteArray data;
+
+        explicit Job(JobType t = JOB_STOP) : type(t), block(0) {}
+    };
+
+    struct IndexEntry
+    {
+        qint64 key;         // Receive time or topic id
+        quint64 offset;
+
+        IndexEntry() : key(0), offset(0) {}
+        IndexEntry(qint64 k, quint64 o) : key(k), offset(o) {}
+    };
+
+    quint32 internTopic(const QByteArray& topic)
+    {
+        auto it = topicIds_.find(topic);
+        if (it != topicIds_.end())
+        {
+            return it.value();
+        }
+
+        quint32 id = topicIds_.size();
+        topicIds_.insert(topic, id);
+        topicNames_.append(topic);
+        topicSegment_.append(-1);
+        topicBlock_.append(-1);
+        return id;
+    }
+
+    // Checks that the pool can take size more bytes; blocks are only taken on this thread, so the check cannot be outrun
+    bool reserve(quint64 size)
+    {
+        // A record header more covers what pad() may add
+        quint64 blocks = (used_ + size + CaptureFormat::RecordHeaderSize) / BlockSize;
+        return blocks <= static_cast<quint64>(freeBlocks_.load());
+    }
+
+    void appendRecord(CaptureFormat::RecordType type, const QList<QByteArray>& frames, quint64 dataSize, qint64 receiveNs, quint32 topicId)
+    {
+        CaptureFormat::RecordHeader header;
+        header.size = pad(CaptureFormat::recordSize(frames.size(), dataSize));
+        header.type = type;
+        header.frameCount = static_cast<quint16>(frames.size());
+        header.receiveNs = receiveNs;
+        header.topicId = topicId;
+
+        scratch_.resize(CaptureFormat::RecordHeaderSize + frames.size() * 4);
+        CaptureFormat::writeRecordHeader(scratch_.data(), header);
+        uchar* table = reinterpret_cast<uchar*>(scratch_.data() + CaptureFormat::RecordHeaderSize);
+        for (int i = 0; i < frames.size(); ++i)
+        {
+            qToLittleEndian<quint32>(frames.at(i).size(), table + i * 4);
+        }
+
+        append(scratch_.constData(), scratch_.size());
+        for (const QByteArray& frame : frames)
+        {
+            append(frame.constData(), frame.size());
+        }
+        appendZeros(header.size - scratch_.size() - dataSize);
+    }
+
+    // Grows a record that would leave less than a record header in its block, so the block can always be padded
+    quint32 pad(quint32 size) const
+    {
+        int left = BlockSize - static_cast<int>((used_ + size) % BlockSize);
+        return left != BlockSize && left < CaptureFormat::RecordHeaderSize ? size + left : size;
+    }
+
+    // Notes the record about to be appended in the sparse index
+    void noteIndex(quint32 topicId, qint64 receiveNs)
+    {
+        quint64 offset = segmentOffset_ + used_;
+        if (!blockIndexed_)
+        {
+            timeIndex_.append(IndexEntry(receiveNs, offset));
+            blockIndexed_ = true;
+        }
+        if (topicBlock_.at(topicId) != blockSerial_)
+        {
+            topicIndex_.append(IndexEntry(topicId, offset));
+            topicBlock_[topicId] = blockSerial_;
+        }
+    }
+
+    void append(const char* data, int size)
+    {
+        while (size > 0)
+        {
+            int n = qMin(size, BlockSize - used_);
+            memcpy(block_ + used_, data, n);
+            used_ += n;
+            data += n;
+            size -= n;
+            if (used_ == BlockSize)
+            {
+                submitBlock();
+            }
+        }
+    }
+
+    void appendZeros(int size)
+    {
+        while (size > 0)
+        {
+            int n = qMin(size, BlockSize - used_);
+            memset(block_ + used_, 0, n);
+            used_ += n;
+            size -= n;
+            if (used_ == BlockSize)
+            {
+                submitBlock();
+            }
+        }
+    }
+
+    void submitBlock()
+    {
+        Job job(JOB_BLOCK);
+        job.block = block_;
+        enqueue(job);
+
+        segmentOffset_ += BlockSize;
+        ++blockSerial_;
+        blockIndexed_ = false;
+        block_ = takeBlock();
+        used_ = 0;
+    }
+
+    char* takeBlock()
+    {
+        QMutexLocker locker(&mutex_);
+        if (pool_.isEmpty())
+        {
+            // Reached with the BLOCK policy and by close(), otherwise write() checks the pool before
+            QElapsedTimer timer;
+            timer.start();
+            while (pool_.isEmpty())
+            {
+                blockReturned_.wait(&mutex_);
+            }
+            stalledNs_ += timer.nsecsElapsed();
+        }
+        freeBlocks_.fetchAndAddOrdered(-1);
+        return pool_.takeLast();
+    }
+
+    void startSegment(qint64 startNs)
+    {
+        Job job(JOB_OPEN);
+        job.path = CaptureFormat::segmentPath(prefix_, segmentIndex_);
+        enqueue(job);
+
+        if (block_ == 0)
+        {
+            block_ = takeBlock();
+        }
+        CaptureFormat::FileHeader header;
+        header.version = CaptureFormat::Version;
+        header.blockSize = BlockSize;
+        header.segmentIndex = segmentIndex_;
+        header.startNs = startNs;
+        header.startUtcMs = QDateTime::currentMSecsSinceEpoch();
+        CaptureFormat::writeFileHeader(block_, header);
+        used_ = CaptureFormat::FileHeaderSize;
+        segmentOffset_ = 0;
+        blockIndexed_ = false;
+        ++blockSerial_;
+    }
+
+    // Pads the last block, queues it and the index; the next block is taken for the next segment
+    void finishSegment()
+    {
+        if (used_ != 0)
+        {
+            CaptureFormat::RecordHeader header;
+            header.size = BlockSize - used_;
+            header.type = CaptureFormat::REC_PADDING;
+            header.frameCount = 0;
+            header.receiveNs = 0;
+            header.topicId = 0;
+            CaptureFormat::writeRecordHeader(block_ + used_, header);
+            used_ += CaptureFormat::RecordHeaderSize;
+            appendZeros(BlockSize - used_);
+        }
+
+        Job job(JOB_CLOSE);
+        job.path = CaptureFormat::indexPath(prefix_, segmentIndex_);
+        job.data = indexData();
+        enqueue(job);
+
+        timeIndex_.clear();
+        topicIndex_.clear();
+        ++segmentIndex_;
+    }
+
+    QByteArray indexData()
+    {
+        std::stable_sort(topicIndex_.begin(), topicIndex_.end(), [](const IndexEntry& a, const IndexEntry& b) {
+            return a.key < b.key;
+        });
+
+        QList<quint32> names;
+        int namesSize = 0;
+        for (int id = 0; id < topicSegment_.size(); ++id)
+        {
+            if (topicSegment_.at(id) == segmentIndex_)
+            {
+                names.append(id);
+                namesSize += 8 + CaptureFormat::align(topicNames_.at(id).size());
+            }
+        }
+
+        CaptureFormat::IndexHeader header;
+        header.segmentIndex = segmentIndex_;
+        header.blockSize = BlockSize;
+        header.timeCount = timeIndex_.size();
+        header.topicCount = topicIndex_.size();
+        header.nameCount = names.size();
+
+        QByteArray data(CaptureFormat::IndexHeaderSize + (timeIndex_.size() + topicIndex_.size()) * CaptureFormat::IndexEntrySize + namesSize, '\0');
+        char* p = data.data();
+        CaptureFormat::writeIndexHeader(p, header);
+        p += CaptureFormat::IndexHeaderSize;
+        for (const IndexEntry& entry : timeIndex_)
+        {
+            CaptureFormat::writeIndexEntry(p, entry.key, entry.offset);
+            p += CaptureFormat::IndexEntrySize;
+        }
+        for (const IndexEntry& entry : topicIndex_)
+        {
+            CaptureFormat::writeIndexEntry(p, entry.key, entry.offset);
+            p += CaptureFormat::IndexEntrySize;
+        }
+        for (quint32 id : names)
+        {
+            const QByteArray& name = topicNames_.at(id);
+            qToLittleEndian<quint32>(id, reinterpret_cast<uchar*>(p));
+            qToLittleEndian<quint32>(name.size(), reinterpret_cast<uchar*>(p + 4));
+            memcpy(p + 8, name.constData(), name.size());
+            p += 8 + CaptureFormat::align(name.size());
+        }
+        return data;
+    }
+
+    void enqueue(const Job& job)
+    {
+        QMutexLocker locker(&mutex_);
+        jobs_.enqueue(job);
+        jobQueued_.wakeOne();
+    }
+
+    // A segment on the writer thread, deleted once its data is synced and the index is written
+    struct Segment
+    {
+        CaptureFile file;
+        QString path;
+        bool opened;
+        qint64 written;     // Offset of the next block
+        int pending;        // Blocks in flight
+        bool closing;
+        QString indexPath;
+        QByteArray index;
+
+        Segment() : opened(false), written(0), pending(0), closing(false) {}
+    };
+
+    // The writer thread, the only one touching the files
+    void run()
+    {
+        QString fallback;
+        QScopedPointer<CaptureIo> io(CaptureIo::create(options_.queueDepth, &fallback));
+        {
+            QMutexLocker locker(&mutex_);
+            io_ = fallback.isEmpty() ? io->name() : QString("%1 (%2)").arg(io->name(), fallback);
+        }
+
+        QHash<char*, Segment*> writing;     // Block in flight to its segment
+        QList<QFuture<void>> finishing;
+        QVector<IoCompletion> completions;
+        Segment* segment = 0;
+        bool stopping = false;
+        for (;;)
+        {
+            // Waits for a job only with no write in flight, otherwise for a write while every slot is busy
+            Job job;
+            bool haveJob = !stopping && io->inFlight() < io->depth() && takeJob(&job, io->inFlight() == 0);
+            if (!haveJob && io->inFlight() == 0)
+            {
+                break;
+            }
+
+            completions.clear();
+            io->reap(!haveJob, &completions);
+            for (const IoCompletion& completion : completions)
+            {
+                Segment* done = writing.take(completion.block);
+                --done->pending;
+                if (completion.result < 0)
+                {
+                    fail(QString("%1: %2").arg(done->path, QString::fromLocal8Bit(strerror(static_cast<int>(-completion.result)))));
+                }
+                else
+                {
+                    bytesWritten_.fetchAndAddRelaxed(completion.result);
+                }
+                releaseBlock(completion.block);
+                if (done->closing && done->pending == 0)
+                {
+                    finishing.append(finish(done));
+                }
+            }
+            if (!haveJob)
+            {
+                continue;
+            }
+
+            switch (job.type)
+            {
+            case JOB_OPEN:
+                segment = new Segment;
+                segment->path = job.path;
+                segment->opened = failed_.load() == 0 && openSegment(&segment->file, job.path);
+                break;
+            case JOB_BLOCK:
+                if (failed_.load() != 0 || !segment->opened)
+                {
+                    releaseBlock(job.block);
+                    break;
+                }
+                writing.insert(job.block, segment);
+                ++segment->pending;
+                io->submit(&segment->file, job.block, BlockSize, segment->written);
+                segment->written += BlockSize;
+                if (io->inFlight() > peakInFlight_.load())
+                {
+                    peakInFlight_.store(io->inFlight());
+                }
+                break;
+            case JOB_CLOSE:
+                segment->closing = true;
+                segment->indexPath = job.path;
+                segment->index = job.data;
+                if (segment->pending == 0)
+                {
+                    finishing.append(finish(segment));
+                }
+                segment = 0;
+                break;
+            case JOB_STOP:
+                stopping = true;
+                break;
+            }
+        }
+
+        for (QFuture<void>& future : finishing)
+        {
+            future.waitForFinished();
+        }
+    }
+
+    bool takeJob(Job* job, bool wait)
+    {
+        QMutexLocker locker(&mutex_);
+        while (wait && jobs_.isEmpty())
+        {
+            jobQueued_.wait(&mutex_);
+        }
+        if (jobs_.isEmpty())
+        {
+            return false;
+        }
+        *job = jobs_.dequeue();
+        return true;
+    }
+
+    bool openSegment(CaptureFile* file, const QString& path)
+    {
+        QString error;
+        if (file->open(path, options_.directIo, &error))
+        {
+            return true;
+        }
+
+        // tmpfs and some network file systems refuse O_DIRECT, the page cache still works there
+        if (options_.directIo && file->open(path, false, &error))
+        {
+            QMutexLocker locker(&mutex_);
+            if (!io_.contains("O_DIRECT"))
+            {
+                io_ += ", O_DIRECT refused by the file system";
+            }
+            return true;
+        }
+        fail(error);
+        return false;
+    }
+
+    // Syncs and closes a segment whose writes completed and writes its indexes, on the global thread pool
+    QFuture<void> finish(Segment* segment)
+    {
+        return QtConcurrent::run([this, segment]() {
+            if (segment->opened && failed_.load() == 0)
+            {
+                QElapsedTimer timer;
+                timer.start();
+                int result = segment->file.sync();
+                qint64 syncNs = timer.nsecsElapsed();
+                if (result < 0)
+                {
+                    fail(QString("%1: %2").arg(segment->path, QString::fromLocal8Bit(strerror(-result))));
+                }
+                lastSyncNs_.store(syncNs);
+                if (syncNs > maxSyncNs_.load())
+                {
+                    maxSyncNs_.store(syncNs);
+                }
+            }
+            segment->file.close();
+
+            if (segment->opened && failed_.load() == 0)
+            {
+                QFile index(segment->indexPath);
+                if (!index.open(QIODevice::WriteOnly | QIODevice::Truncate) || index.write(segment->index) != segment->index.size())
+                {
+                    fail(index.errorString());
+                }
+            }
+
+            QString prefix;
+            int segmentIndex = 0;
+            if (options_.searchIndex && segment->opened && failed_.load() == 0 && CaptureFormat::parseSegmentPath(segment->path, &prefix, &segmentIndex))
+            {
+                QElapsedTimer timer;
+                timer.start();
+                QString error;
+                bool built = TrigramIndex::build(segment->path, CaptureFormat::trigramPath(prefix, segmentIndex), &error);
+                lastSearchIndexNs_.store(timer.nsecsElapsed());
+                QMutexLocker locker(&mutex_);
+                searchIndexError_ = built ? QString() : error;
+            }
+            delete segment;
+        });
+    }
+
+    void releaseBlock(char* block)
+    {
+        QMutexLocker locker(&mutex_);
+        pool_.append(block);
+        freeBlocks_.fetchAndAddOrdered(1);
+        blockReturned_.wakeOne();
+    }
+
+    void fail(const QString& error)
+    {
+        QMutexLocker locker(&mutex_);
+        if (error_.isEmpty())
+        {
+            error_ = error;
+        }
+        failed_.store(1);
+    }
+
+    // Socket thread
+    QString prefix_;
+    CaptureOptions options_;
+    QThread* thread_;
+    char* block_;                           // The block being filled
+    int used_;
+    qint64 blockSerial_;                    // Counts blocks over all segments, for the topic index
+    bool blockIndexed_;                     // The time index has an entry for the current block
+    int segmentIndex_;
+    qint64 segmentOffset_;                  // File offset of the current block
+    quint64 records_;
+    quint64 dropped_;
+    quint64 stalls_;
+    qint64 stalledNs_;
+    quint64 reportedBytes_;                 // bytesWritten_ at the previous status()
+    qint64 reportedNs_;
+    QHash<QByteArray, quint32> topicIds_;
+    QVector<QByteArray> topicNames_;        // Per topic id
+    QVector<int> topicSegment_;             // Segment the topic was last announced in, per topic id
+    QVector<qint64> topicBlock_;            // Block the topic was last indexed in, per topic id
+    QVector<IndexEntry> timeIndex_;
+    QVector<IndexEntry> topicIndex_;
+    QByteArray scratch_;
+
+    // Shared with the writer thread
+    mutable QMutex mutex_;
+    QWaitCondition jobQueued_;
+    QWaitCondition blockReturned_;
+    QQueue<Job> jobs_;
+    QVector<char*> pool_;                   // Free blocks
+    QAtomicInt freeBlocks_;                 // pool_.size(), read without the mutex
+    QAtomicInteger<quint64> bytesWritten_;
+    QAtomicInt failed_;
+    QAtomicInt peakInFlight_;
+    QAtomicInteger<qint64> lastSyncNs_;     // Written on the global thread pool
+    QAtomicInteger<qint64> maxSyncNs_;
+    QAtomicInteger<qint64> lastSearchIndexNs_;
+    QString io_;
+    QString error_;
+    QString searchIndexError_;
+};
+
+}
+
+}
+
+Q_DECLARE_METATYPE(nzmqt::samples::CaptureStatus)
+
+#endif // NZMQT_CAPTUREWRITER_H
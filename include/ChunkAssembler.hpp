@@ -0,0 +1,293 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_CHUNKASSEMBLER_H
+#define NZMQT_CHUNKASSEMBLER_H
+
+#include "ChunkHeader.hpp"
+
+#include <QBitArray>
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMetaType>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#include <climits>
+#include <cstring>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+// Outcome of one received stream
+struct StreamResult
+{
+    quint32 publisherId;
+    quint32 streamId;
+    quint64 totalSize;
+    quint32 chunkCount;
+    quint32 missingChunks;      // 0 if the stream is complete
+    qint64 transferNs;          // From the first to the last received chunk
+    qint64 latencyNs;           // From the publisher sending the first chunk to the payload being reassembled
+    QString fileName;           // The reassembled file, empty when reassembling to memory
+
+    bool isComplete() const { return missingChunks == 0; }
+
+    // Bytes per second while the chunks arrived
+    double throughput() const
+    {
+        return transferNs > 0 ? totalSize * 1e9 / transferNs : 0.0;
+    }
+};
+
+// Streams that completed or were given up since the previous report
+typedef QVector<StreamResult> StreamReport;
+
+/*
+Chunk Assembler:
+Reassembles the chunk streams of ChunkSender on the Subscriber side, either in memory or directly in
+a file per stream. Chunks may arrive in any order and twice; each one is written to its offset and
+counted once. A stream is reported when its last missing chunk arrives, when the same publisher
+starts its next stream, or when no chunk arrived for StreamTimeoutNs; the latter two report the
+chunks that are still missing. Memory mode holds at most MaxMemory bytes of incomplete streams and
+drops a completed payload right after reporting it, the tool only measures the transfer.
+*/
+class ChunkAssembler
+{
+    Q_DISABLE_COPY(ChunkAssembler)
+
+public:
+    static const qint64 StreamTimeoutNs = 5 * 1000000000LL;
+    static const qint64 MaxMemory = 1024LL * 1024 * 1024;
+
+    ChunkAssembler()
+        : memoryUsed_(0)
+    {
+    }
+
+    ~ChunkAssembler()
+    {
+        qDeleteAll(streams_);
+    }
+
+    /**
+     * @brief Sets where streams are reassembled.
+     * @param directory The directory the payloads are written to, an empty string keeps them in memory.
+     * @return None
+     * @note Streams that already started keep their target.
+     */
+    void setDirectory(const QString& directory)
+    {
+        directory_ = directory;
+    }
+
+    /**
+     * @brief Adds a received chunk.
+     * @param header The chunk header.
+     * @param data The chunk's data.
+     * @param receiveNs The monotonic receive time.
+     * @return None
+     */
+    void add(const ChunkHeader::View& header, const QByteArray& data, qint64 receiveNs)
+    {
+        if (header.chunkCount() == 0 || header.chunkIndex() >= header.chunkCount()
+            || header.offset() + static_cast<quint64>(data.size()) > header.totalSize())
+        {
+            return;
+        }
+
+        StreamKey key(header.publisherId(), header.streamId());
+        Stream* stream = streams_.value(key);
+        if (stream == 0)
+        {
+            // Late chunks of a stream that was already reported would start it over
+            if (header.streamId() <= lastStreams_.value(header.publisherId()))
+            {
+                return;
+            }
+            finishPublisher(header.publisherId());
+            stream = open(header, receiveNs);
+            streams_.insert(key, stream);
+        }
+
+        stream->lastNs = receiveNs;
+        if (stream->failed || header.chunkCount() != static_cast<quint32>(stream->received.size())
+            || stream->received.testBit(header.chunkIndex()))
+        {
+            return;
+        }
+
+        if (stream->file)
+        {
+            stream->failed = !stream->file->seek(header.offset()) || stream->file->write(data) != data.size();
+        }
+        else
+        {
+            memcpy(stream->buffer.data() + header.offset(), data.constData(), data.size());
+        }
+        stream->received.setBit(header.chunkIndex());
+        if (!stream->failed && ++stream->receivedCount == stream->received.size())
+        {
+            finish(key, receiveNs);
+        }
+    }
+
+    /**
+     * @brief Gives up streams that did not receive a chunk for StreamTimeoutNs.
+     * @param nowNs The monotonic time.
+     * @return None
+     */
+    void expire(qint64 nowNs)
+    {
+        QList<StreamKey> expired;
+        for (auto it = streams_.cbegin(); it != streams_.cend(); ++it)
+        {
+            if (nowNs - it.value()->lastNs > StreamTimeoutNs)
+            {
+                expired.append(it.key());
+            }
+        }
+        for (const StreamKey& key : expired)
+        {
+            finish(key, nowNs);
+        }
+    }
+
+    bool hasReport() const { return !report_.isEmpty(); }
+
+    StreamReport takeReport()
+    {
+        StreamReport report;
+        report.swap(report_);
+        return report;
+    }
+
+private:
+    typedef QPair<quint32, quint32> StreamKey;
+
+    struct Stream
+    {
+        QByteArray buffer;
+        QFile* file;
+        QBitArray received;
+        int receivedCount;
+        quint64 totalSize;
+        qint64 startNs;
+        qint64 firstNs;
+        qint64 lastNs;
+        bool failed;            // The payload could not be stored, the stream is reported incomplete
+
+        Stream()
+            : file(0), receivedCount(0), totalSize(0), startNs(0), firstNs(0), lastNs(0), failed(false)
+        {
+        }
+
+        ~Stream()
+        {
+            delete file;
+        }
+    };
+
+    Stream* open(const ChunkHeader::View& header, qint64 receiveNs)
+    {
+        Stream* stream = new Stream;
+        stream->received.resize(static_cast<int>(qMin<quint32>(header.chunkCount(), INT_MAX)));
+        stream->totalSize = header.totalSize();
+        stream->startNs = header.streamStartNs();
+        stream->firstNs = receiveNs;
+        stream->lastNs = receiveNs;
+
+        if (!directory_.isEmpty())
+        {
+            QString name = QString("stream-%1-%2.part").arg(header.publisherId(), 8, 16, QChar('0')).arg(header.streamId());
+            stream->file = new QFile(QDir(directory_).filePath(name));
+            stream->failed = !stream->file->open(QIODevice::WriteOnly | QIODevice::Truncate)
+                || !stream->file->resize(static_cast<qint64>(header.totalSize()));
+        }
+        else if (header.totalSize() > static_cast<quint64>(qMin<qint64>(MaxMemory - memoryUsed_, INT_MAX)))
+        {
+            // A QByteArray cannot hold it or the incomplete streams would exceed the limit
+            stream->failed = true;
+        }
+        else
+        {
+            stream->buffer.resize(static_cast<int>(header.totalSize()));
+            memoryUsed_ += stream->buffer.size();
+        }
+        return stream;
+    }
+
+    // The chunks of a publisher's earlier streams will not arrive any more once it started a new one
+    void finishPublisher(quint32 publisherId)
+    {
+        QList<StreamKey> earlier;
+        for (auto it = streams_.cbegin(); it != streams_.cend(); ++it)
+        {
+            if (it.key().first == publisherId)
+            {
+                earlier.append(it.key());
+            }
+        }
+        for (const StreamKey& key : earlier)
+        {
+            finish(key, streams_.value(key)->lastNs);
+        }
+    }
+
+    void finish(const StreamKey& key, qint64 nowNs)
+    {
+        Stream* stream = streams_.take(key);
+        quint32& lastStream = lastStreams_[key.first];
+        lastStream = qMax(lastStream, key.second);
+
+        StreamResult result;
+        result.publisherId = key.first;
+        result.streamId = key.second;
+        result.totalSize = stream->totalSize;
+        result.chunkCount = stream->received.size();
+        result.missingChunks = stream->failed ? result.chunkCount : result.chunkCount - stream->receivedCount;
+        result.transferNs = stream->lastNs - stream->firstNs;
+        result.latencyNs = nowNs - stream->startNs;
+
+        if (stream->file)
+        {
+            stream->file->close();
+            if (result.isComplete())
+            {
+                // The payload is complete, it loses the .part suffix
+                QString fileName = stream->file->fileName();
+                fileName.chop(5);
+                QFile::remove(fileName);
+                if (stream->file->rename(fileName))
+                {
+                    result.fileName = fileName;
+                }
+            }
+        }
+        memoryUsed_ -= stream->buffer.size();
+
+        report_.append(result);
+        delete stream;
+    }
+
+    QString directory_;
+    QHash<StreamKey, Stream*> streams_;
+    QHash<quint32, quint32> lastStreams_;   // Highest stream id reported per publisher
+    qint64 memoryUsed_;
+    StreamReport report_;
+};
+
+}
+
+}
+
+Q_DECLARE_METATYPE(nzmqt::samples::StreamReport)
+
+#endif // NZMQT_CHUNKASSEMBLER_H
@@ -0,0 +1,170 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_CHUNKHEADER_H
+#define NZMQT_CHUNKHEADER_H
+
+#include <QByteArray>
+#include <QtEndian>
+#include <QtGlobal>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Chunk Header:
+The frame between the topic frame and the data frame of a streamed chunk. A large payload is sent as
+a stream of chunks, each message carries one chunk and tells where it belongs in the payload.
+Wire layout (little endian, 56 bytes):
+    offset  0  quint32  magic           'ZMQC'
+    offset  4  quint8   version
+    offset  5  quint8   flags           FLAG_LAST on the last chunk of a stream
+    offset  6  quint16  header size     size of this frame, newer versions may append fields
+    offset  8  quint32  publisher id    random per Publisher instance
+    offset 12  quint32  stream id       per publisher, starts at 1
+    offset 16  quint32  chunk index
+    offset 20  quint32  chunk count
+    offset 24  quint64  total size      size of the payload in bytes
+    offset 32  quint64  offset          position of the chunk's data in the payload
+    offset 40  qint64   stream start    monotonic clock in ns, when the first chunk was sent
+    offset 48  qint64   send time       monotonic clock in ns, taken right before sending this chunk
+*/
+class ChunkHeader
+{
+public:
+    static const quint32 Magic = 0x43514D5A; // "ZMQC" in memory order
+    static const quint8 Version = 1;
+    static const int Size = 56;
+
+    enum Flag
+    {
+        FLAG_LAST = 0x01
+    };
+
+    enum Offset
+    {
+        OFF_MAGIC = 0,
+        OFF_VERSION = 4,
+        OFF_FLAGS = 5,
+        OFF_HEADER_SIZE = 6,
+        OFF_PUBLISHER_ID = 8,
+        OFF_STREAM_ID = 12,
+        OFF_CHUNK_INDEX = 16,
+        OFF_CHUNK_COUNT = 20,
+        OFF_TOTAL_SIZE = 24,
+        OFF_OFFSET = 32,
+        OFF_STREAM_START = 40,
+        OFF_SEND_TIME = 48
+    };
+
+    /**
+     * @brief Allocates a header frame with the constant fields filled in.
+     * @param publisherId The id of the publisher that owns the frame.
+     * @return A frame of Size bytes, the per stream and per chunk fields are set with patchStream() and patchChunk().
+     */
+    static QByteArray makeFrame(quint32 publisherId)
+    {
+        QByteArray frame(Size, '\0');
+        uchar* p = reinterpret_cast<uchar*>(frame.data());
+        qToLittleEndian<quint32>(Magic, p + OFF_MAGIC);
+        p[OFF_VERSION] = Version;
+        qToLittleEndian<quint16>(Size, p + OFF_HEADER_SIZE);
+        qToLittleEndian<quint32>(publisherId, p + OFF_PUBLISHER_ID);
+        return frame;
+    }
+
+    /**
+     * @brief Writes the fields that are the same for all chunks of a stream.
+     * @param frame Pointer to the first byte of the header frame.
+     * @param streamId The id of the stream.
+     * @param chunkCount The number of chunks of the stream.
+     * @param totalSize The size of the payload in bytes.
+     * @param streamStartNs The monotonic time the first chunk was sent.
+     * @return None
+     */
+    static void patchStream(char* frame, quint32 streamId, quint32 chunkCount, quint64 totalSize, qint64 streamStartNs)
+    {
+        uchar* p = reinterpret_cast<uchar*>(frame);
+        qToLittleEndian<quint32>(streamId, p + OFF_STREAM_ID);
+        qToLittleEndian<quint32>(chunkCount, p + OFF_CHUNK_COUNT);
+        qToLittleEndian<quint64>(totalSize, p + OFF_TOTAL_SIZE);
+        qToLittleEndian<qint64>(streamStartNs, p + OFF_STREAM_START);
+    }
+
+    /**
+     * @brief Writes the per chunk fields.
+     * @param frame Pointer to the first byte of the header frame.
+     * @param chunkIndex The index of the chunk in the stream.
+     * @param offset The position of the chunk's data in the payload.
+     * @param sendTimeNs The monotonic send time in nanoseconds.
+     * @param last True for the last chunk of the stream.
+     * @return None
+     */
+    static void patchChunk(char* frame, quint32 chunkIndex, quint64 offset, qint64 sendTimeNs, bool last)
+    {
+        uchar* p = reinterpret_cast<uchar*>(frame);
+        p[OFF_FLAGS] = last ? FLAG_LAST : 0;
+        qToLittleEndian<quint32>(chunkIndex, p + OFF_CHUNK_INDEX);
+        qToLittleEndian<quint64>(offset, p + OFF_OFFSET);
+        qToLittleEndian<qint64>(sendTimeNs, p + OFF_SEND_TIME);
+    }
+
+    // Read only view on a received header frame. It never copies the frame, so the
+    // QByteArray it was parsed from must outlive the view.
+    class View
+    {
+    public:
+        View() : data_(0) {}
+
+        bool isValid() const { return data_ != 0; }
+
+        quint8 version() const { return static_cast<quint8>(data_[OFF_VERSION]); }
+        bool isLast() const { return (data_[OFF_FLAGS] & FLAG_LAST) != 0; }
+        quint32 publisherId() const { return qFromLittleEndian<quint32>(data_ + OFF_PUBLISHER_ID); }
+        quint32 streamId() const { return qFromLittleEndian<quint32>(data_ + OFF_STREAM_ID); }
+        quint32 chunkIndex() const { return qFromLittleEndian<quint32>(data_ + OFF_CHUNK_INDEX); }
+        quint32 chunkCount() const { return qFromLittleEndian<quint32>(data_ + OFF_CHUNK_COUNT); }
+        quint64 totalSize() const { return qFromLittleEndian<quint64>(data_ + OFF_TOTAL_SIZE); }
+        quint64 offset() const { return qFromLittleEndian<quint64>(data_ + OFF_OFFSET); }
+        qint64 streamStartNs() const { return qFromLittleEndian<qint64>(data_ + OFF_STREAM_START); }
+        qint64 sendTimeNs() const { return qFromLittleEndian<qint64>(data_ + OFF_SEND_TIME); }
+
+    private:
+        friend class ChunkHeader;
+        const uchar* data_;
+    };
+
+    /**
+     * @brief Checks whether a frame is a chunk header frame and maps a view onto it.
+     * @param frame The frame to be checked.
+     * @param view Receives the view if the frame is a chunk header frame.
+     * @return True if the frame is a chunk header frame, false otherwise.
+     */
+    static bool parse(const QByteArray& frame, View* view)
+    {
+        if (frame.size() < Size)
+        {
+            return false;
+        }
+
+        const uchar* p = reinterpret_cast<const uchar*>(frame.constData());
+        if (qFromLittleEndian<quint32>(p + OFF_MAGIC) != Magic
+            || qFromLittleEndian<quint16>(p + OFF_HEADER_SIZE) != frame.size())
+        {
+            return false;
+        }
+
+        view->data_ = p;
+        return true;
+    }
+};
+
+}
+
+}
+
+#endif // NZMQT_CHUNKHEADER_H
@@ -0,0 +1,309 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_CHUNKSENDER_H
+#define NZMQT_CHUNKSENDER_H
+
+#include "ChunkHeader.hpp"
+
+#include "nzmqt/nzmqt.hpp"
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Chunk Sender:
+Sends a large payload as a stream of fixed size chunks, see ChunkHeader.hpp. The payload is a memory
+mapped file or a byte array, chunks point into it and are handed to ZeroMQ without a copy.
+Flow control is a credit window: at most Window chunks may be queued in ZeroMQ at a time. A chunk
+returns its credit when ZeroMQ releases its data, which happens once the chunk is on the wire or has
+been dropped. A PUB socket has no way back from the subscribers, so this bounds what the publisher
+piles up in its own queues: memory stays at Window chunks instead of the whole payload, and the
+socket's high water mark is not reached in a burst that would drop the rest of the stream.
+A chunk is a message of three frames. A chunk is only started when the socket reports that it can
+send, and if a frame is refused anyway the next call resumes with that frame, so a retry never puts
+a second topic frame into a half sent message.
+*/
+class ChunkSender
+{
+    Q_DISABLE_COPY(ChunkSender)
+
+public:
+    enum Result
+    {
+        RESULT_SENT,            // A chunk was sent
+        RESULT_WINDOW_FULL,     // All credits are taken, try again later
+        RESULT_FAILED,          // The socket did not accept the chunk, try again later
+        RESULT_IDLE             // No stream is active
+    };
+
+    ChunkSender()
+        : source_(0), chunkSize_(1024 * 1024), window_(8)
+        , streamId_(0), chunkCount_(0), nextChunk_(0), nextFrame_(FRAME_TOPIC), active_(false)
+    {
+    }
+
+    ~ChunkSender()
+    {
+        close();
+    }
+
+    /**
+     * @brief Sets the chunking of the following streams.
+     * @param chunkSize The size of a chunk's data in bytes.
+     * @param window The number of chunks that may be queued in ZeroMQ at a time.
+     * @return None
+     */
+    void setChunking(qint64 chunkSize, int window)
+    {
+        chunkSize_ = qMax<qint64>(1, chunkSize);
+        window_ = qMax(1, window);
+    }
+
+    // Streams the bytes, they are kept until the last chunk pointing into them is released
+    void setSource(const QByteArray& bytes)
+    {
+        close();
+        source_ = new Source;
+        source_->bytes = bytes;
+        source_->data = reinterpret_cast<const uchar*>(source_->bytes.constData());
+        source_->size = source_->bytes.size();
+    }
+
+    /**
+     * @brief Streams the contents of a file, it is mapped instead of read.
+     * @param path The file to stream.
+     * @param error Receives a description of the problem if the file cannot be mapped.
+     * @return False if the file cannot be mapped.
+     */
+    bool setSource(const QString& path, QString* error)
+    {
+        close();
+        Source* source = new Source;
+        source->file.setFileName(path);
+        if (!source->file.open(QIODevice::ReadOnly))
+        {
+            *error = QString("Could not open %1: %2").arg(path, source->file.errorString());
+            release(source);
+            return false;
+        }
+
+        source->size = source->file.size();
+        source->mapped = source->size > 0 ? source->file.map(0, source->size) : 0;
+        if (source->mapped == 0)
+        {
+            *error = QString("Could not map %1: %2").arg(path, source->size > 0 ? source->file.errorString() : QString("The file is empty"));
+            release(source);
+            return false;
+        }
+        source->data = source->mapped;
+        source_ = source;
+        return true;
+    }
+
+    // A chunk that is half sent must be finished with finish() first, the socket expects its remaining frames
+    void close()
+    {
+        active_ = false;
+        nextFrame_ = FRAME_TOPIC;
+        if (source_)
+        {
+            release(source_);
+            source_ = 0;
+        }
+    }
+
+    bool hasSource() const { return source_ != 0 && source_->size > 0; }
+
+    qint64 totalSize() const { return source_ ? source_->size : 0; }
+
+    quint32 chunkCount() const { return chunkCount_; }
+
+    quint32 streamId() const { return streamId_; }
+
+    // A stream is active until its last chunk has been handed to ZeroMQ
+    bool isActive() const { return active_; }
+
+    // Chunks queued in ZeroMQ, over all streams of the current source
+    int inFlight() const { return source_ ? source_->inFlight.loadAcquire() : 0; }
+
+    /**
+     * @brief Starts the next stream of the source.
+     * @param publisherId The id of the publisher, written into every chunk header.
+     * @param nowNs The monotonic start time of the stream.
+     * @return False if there is no source.
+     */
+    bool begin(quint32 publisherId, qint64 nowNs)
+    {
+        if (!hasSource())
+        {
+            return false;
+        }
+
+        if (headerFrame_.isEmpty())
+        {
+            headerFrame_ = ChunkHeader::makeFrame(publisherId);
+        }
+        chunkCount_ = static_cast<quint32>((source_->size + chunkSize_ - 1) / chunkSize_);
+        nextChunk_ = 0;
+        nextFrame_ = FRAME_TOPIC;
+        ChunkHeader::patchStream(headerFrame_.data(), ++streamId_, chunkCount_, source_->size, nowNs);
+        active_ = true;
+        return true;
+    }
+
+    /**
+     * @brief Sends the next chunk of the active stream if a credit is available.
+     * @param socket The socket to send on.
+     * @param topic The topic frame sent in front of the chunk.
+     * @param nowNs The monotonic send time written into the chunk header.
+     * @param bytes Receives the size of the message if a chunk was sent.
+     * @return What happened, see Result.
+     */
+    Result sendNext(ZMQSocket* socket, const QByteArray& topic, qint64 nowNs, quint64* bytes)
+    {
+        if (!active_)
+        {
+            return RESULT_IDLE;
+        }
+        return sendFrames(socket, topic, nowNs, ZMQSocket::SND_DONTWAIT, bytes);
+    }
+
+    /**
+     * @brief Sends the remaining frames of a chunk that is half sent, so that the socket can take other messages.
+     * @param socket The socket the chunk was started on.
+     * @param topic The topic frame the chunk was started with.
+     * @param nowNs The monotonic time.
+     * @return False if the socket still did not accept them within its send timeout.
+     */
+    bool finish(ZMQSocket* socket, const QByteArray& topic, qint64 nowNs)
+    {
+        quint64 bytes = 0;
+        return !active_ || nextFrame_ == FRAME_TOPIC || sendFrames(socket, topic, nowNs, ZMQSocket::SendFlags(), &bytes) == RESULT_SENT;
+    }
+
+private:
+    enum Frame
+    {
+        FRAME_TOPIC,
+        FRAME_HEADER,
+        FRAME_DATA
+    };
+
+    // Sends the current chunk from nextFrame_ on
+    Result sendFrames(ZMQSocket* socket, const QByteArray& topic, qint64 nowNs, ZMQSocket::SendFlags flags, quint64* bytes)
+    {
+        qint64 offset = static_cast<qint64>(nextChunk_) * chunkSize_;
+        qint64 size = qMin(chunkSize_, source_->size - offset);
+        if (nextFrame_ == FRAME_TOPIC)
+        {
+            if (source_->inFlight.loadAcquire() >= window_)
+            {
+                return RESULT_WINDOW_FULL;
+            }
+            if (!(socket->events() & ZMQSocket::EVT_POLLOUT))
+            {
+                return RESULT_FAILED;
+            }
+
+            bool last = nextChunk_ + 1 == chunkCount_;
+            ChunkHeader::patchChunk(headerFrame_.data(), nextChunk_, offset, nowNs, last);
+            if (!socket->sendMessage(topic, flags | ZMQSocket::SND_MORE))
+            {
+                return RESULT_FAILED;
+            }
+            nextFrame_ = FRAME_HEADER;
+        }
+        if (nextFrame_ == FRAME_HEADER)
+        {
+            if (!socket->sendMessage(headerFrame_, flags | ZMQSocket::SND_MORE))
+            {
+                return RESULT_FAILED;
+            }
+            nextFrame_ = FRAME_DATA;
+        }
+
+        // The message returns the credit and releases the source through free() even if sending fails
+        source_->refs.ref();
+        source_->inFlight.ref();
+        ZMQMessage msg(const_cast<uchar*>(source_->data) + offset, static_cast<size_t>(size), &ChunkSender::free, source_);
+        if (!socket->sendMessage(msg, flags))
+        {
+            return RESULT_FAILED;
+        }
+
+        nextFrame_ = FRAME_TOPIC;
+        *bytes = topic.size() + headerFrame_.size() + size;
+        if (++nextChunk_ == chunkCount_)
+        {
+            active_ = false;
+        }
+        return RESULT_SENT;
+    }
+
+    struct Source
+    {
+        QAtomicInt refs;
+        QAtomicInt inFlight;
+        QByteArray bytes;
+        QFile file;
+        uchar* mapped;
+        const uchar* data;
+        qint64 size;
+
+        Source()
+            : refs(1), inFlight(0), mapped(0), data(0), size(0)
+        {
+        }
+
+        ~Source()
+        {
+            if (mapped)
+            {
+                file.unmap(mapped);
+            }
+        }
+    };
+
+    static void release(Source* source)
+    {
+        if (!source->refs.deref())
+        {
+            delete source;
+        }
+    }
+
+    // Called by ZeroMQ, possibly on its I/O thread
+    static void free(void* data, void* hint)
+    {
+        Q_UNUSED(data);
+        Source* source = static_cast<Source*>(hint);
+        source->inFlight.deref();
+        release(source);
+    }
+
+    Source* source_;
+    qint64 chunkSize_;
+    int window_;
+    QByteArray headerFrame_;    // Patched in place for every chunk
+    quint32 streamId_;
+    quint32 chunkCount_;
+    quint32 nextChunk_;
+    Frame nextFrame_;           // The frame of the current chunk to send next, not FRAME_TOPIC while it is half sent
+    bool active_;
+};
+
+}
+
+}
+
+#endif // NZMQT_CHUNKSENDER_H
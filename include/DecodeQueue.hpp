@@ -0,0 +1,215 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_DECODEQUEUE_H
+#define NZMQT_DECODEQUEUE_H
+
+#include "DisplayRing.hpp"
+#include "PayloadDecoder.hpp"
+
+#include <QAtomicInteger>
+#include <QMetaType>
+#include <QObject>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent/QtConcurrent>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Decode Queue:
+Runs the payload decoder of the message views on one worker thread, away from both the subscriber
+and the GUI. It only ever sees what a view is about to show: the messages the live view took from
+the display ring in a frame, and the capture rows the table paints or the one selected, so the
+decoding cost follows the screen and not the message rate. One thread keeps the batches of the live
+view in order. Only payloads as received are decoded, not hex dumps or the summary of a seeded
+payload. The batches waiting for the worker are bounded by the bytes they would decode: a batch that
+would take them beyond MaxPendingBytes is shown right away as it is, together with every batch
+still waiting before it, and counted in undecoded, so the view is never held back by a slow format
+and nothing queues up behind it. Results of a batch that was shown meanwhile are dropped.
+*/
+class DecodeQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int MaxPayloadSize = 1 << 20;      // Larger payloads are not decoded
+    static const qint64 MaxPendingBytes = 64 << 20;
+
+    explicit DecodeQueue(QObject* parent = 0)
+        : QObject(parent), lastBatch_(0), shownBatch_(0), pendingBytes_(0)
+    {
+        pool_.setMaxThreadCount(1);
+    }
+
+    ~DecodeQueue()
+    {
+        pool_.clear();
+        pool_.waitForDone();
+    }
+
+    // Null shows the payloads as they are, the change applies to requests made afterwards
+    void setDecoder(const QSharedPointer<const PayloadDecoder>& decoder)
+    {
+        decoder_ = decoder;
+        emit decoderChanged();
+    }
+
+    QSharedPointer<const PayloadDecoder> decoder() const
+    {
+        return decoder_;
+    }
+
+    /**
+     * @brief Decodes the payload frames of messages for the live view, the topic frame is kept.
+     * @param messages The messages as taken from the display ring, they come back through messagesDecoded() in order.
+     * @return None
+     */
+    void decodeMessages(const QVector<DisplayMessage>& messages)
+    {
+        Batch batch;
+        batch.id = ++lastBatch_;
+        batch.messages = messages;
+        batch.bytes = 0;
+        for (const DisplayMessage& message : messages)
+        {
+            batch.bytes += decodedBytes(message);
+        }
+
+        // Nothing to decode, or the worker is too far behind: the waiting batches go out first to keep the order
+        QSharedPointer<const PayloadDecoder> decoder = decoder_;
+        if (!decoder || (batch.bytes == 0 && batches_.isEmpty()) || (!batches_.isEmpty() && pendingBytes_ + batch.bytes > MaxPendingBytes))
+        {
+            QVector<DisplayMessage> shown;
+            int undecoded = 0;
+            while (!batches_.isEmpty())
+            {
+                Batch waiting = batches_.dequeue();
+                shown += waiting.messages;
+                undecoded += waiting.bytes == 0 ? 0 : waiting.messages.size();
+            }
+            shown += messages;
+            undecoded += decoder && batch.bytes != 0 ? messages.size() : 0;
+            pendingBytes_ = 0;
+            shownBatch_.storeRelease(batch.id);
+            emit messagesDecoded(shown, undecoded);
+            return;
+        }
+
+        batches_.enqueue(batch);
+        pendingBytes_ += batch.bytes;
+        quint64 id = batch.id;
+        QtConcurrent::run(&pool_, [this, id, messages, decoder]() {
+            // Shown undecoded while it waited, the work is saved
+            if (id <= shownBatch_.loadAcquire())
+            {
+                return;
+            }
+
+            QVector<DisplayMessage> decoded = messages;
+            QString text;
+            QString error;
+            for (DisplayMessage& message : decoded)
+            {
+                for (int i = 1; message.raw && i < message.frames.size(); ++i)
+                {
+                    const QByteArray& frame = message.frames.at(i);
+                    if (frame.size() <= MaxPayloadSize && decoder->decode(frame, &text, &error))
+                    {
+                        message.frames[i] = text.toUtf8();
+                    }
+                }
+            }
+            QMetaObject::invokeMethod(this, [this, id, decoded]() {
+                batchDecoded(id, decoded);
+            }, Qt::QueuedConnection);
+        });
+    }
+
+    /**
+     * @brief Decodes one payload, for a row of the capture view.
+     * @param key Passed back with payloadDecoded() to tell the requests apart.
+     * @param payload The payload frame.
+     * @return None
+     */
+    void decodePayload(quint64 key, const QByteArray& payload)
+    {
+        QSharedPointer<const PayloadDecoder> decoder = decoder_;
+        if (!decoder)
+        {
+            return;
+        }
+        QtConcurrent::run(&pool_, [this, key, payload, decoder]() {
+            QString text;
+            QString error;
+            bool ok = payload.size() <= MaxPayloadSize && decoder->decode(payload, &text, &error);
+            if (!ok)
+            {
+                text = payload.size() > MaxPayloadSize ? QString("Larger than %1 bytes, not decoded").arg(MaxPayloadSize)
+                    : QString("Not %1: %2").arg(decoder->name(), error);
+            }
+            QMetaObject::invokeMethod(this, [this, key, text, ok]() {
+                emit payloadDecoded(key, text, ok);
+            }, Qt::QueuedConnection);
+        });
+    }
+
+signals:
+    void decoderChanged();
+
+    // The messages with their payload frames replaced by the decoded text where the decoder understood them
+    void messagesDecoded(const QVector<nzmqt::samples::DisplayMessage>& messages, int undecoded);
+
+    // The decoded text, or why the payload could not be decoded
+    void payloadDecoded(quint64 key, const QString& text, bool ok);
+
+private:
+    struct Batch
+    {
+        quint64 id;
+        QVector<DisplayMessage> messages;
+        qint64 bytes;       // Payload bytes the decoder reads
+    };
+
+    static qint64 decodedBytes(const DisplayMessage& message)
+    {
+        qint64 bytes = 0;
+        for (int i = 1; message.raw && i < message.frames.size(); ++i)
+        {
+            int size = message.frames.at(i).size();
+            bytes += size <= MaxPayloadSize ? size : 0;
+        }
+        return bytes;
+    }
+
+    // The worker finishes the batches in the order they were queued, unless they were shown meanwhile
+    void batchDecoded(quint64 id, const QVector<DisplayMessage>& decoded)
+    {
+        if (batches_.isEmpty() || batches_.head().id != id)
+        {
+            return;
+        }
+        pendingBytes_ -= batches_.dequeue().bytes;
+        emit messagesDecoded(decoded, 0);
+    }
+
+    QThreadPool pool_;
+    QSharedPointer<const PayloadDecoder> decoder_;     // Only touched by the GUI thread
+    QQueue<Batch> batches_;                             // Live view batches the worker has not returned yet, GUI thread only
+    quint64 lastBatch_;
+    QAtomicInteger<quint64> shownBatch_;                // Batches up to this one were shown undecoded
+    qint64 pendingBytes_;                               // Bytes of batches_
+};
+
+}
+
+}
+
+#endif // NZMQT_DECODEQUEUE_H
@@ -0,0 +1,212 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_DISPLAYRING_H
+#define NZMQT_DISPLAYRING_H
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QVector>
+
+#include <utility>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+// A received message waiting to be shown
+struct DisplayMessage
+{
+    QString timeStamp;
+    QList<QByteArray> frames;   // Topic first, as formatted by the subscriber
+    bool raw;                   // The payload frames are as received, not hex or a summary, so a decoder may read them
+
+    DisplayMessage()
+        : raw(false)
+    {
+    }
+};
+
+struct DisplayCounters
+{
+    quint64 counted;        // Every message offered to the ring, shown or not
+    quint64 displayed;      // Taken by the view
+    quint64 dropped;        // Lost because the ring was full
+    quint64 sampledOut;     // Skipped by the Sample policy before they reached the ring
+    int capacity;
+    int stride;             // The Sample policy keeps one message out of stride
+
+    DisplayCounters()
+        : counted(0), displayed(0), dropped(0), sampledOut(0), capacity(0), stride(1)
+    {
+    }
+
+    quint64 notDisplayed() const { return dropped + sampledOut; }
+};
+
+/*
+Display Ring:
+The fixed capacity buffer between the subscriber thread and the message view. A firehose used to
+queue one signal per message into the GUI event loop and collect the text in an unbounded list, now
+the subscriber offers each message to the ring and the GUI takes what is there once per frame. When
+the ring is full the policy decides: DropOldest keeps the latest messages, DropNewest keeps the ones
+that arrived first, Sample keeps one message out of a stride that doubles whenever the ring
+overflowed between two takes and halves again once the view keeps up, so the view stays spread over
+the whole time. Only the display is lossy: the statistics are taken before a message is offered and
+every offered message is counted, dropped ones included.
+admit() decides before the subscriber formats a message, so rejected messages cost a lock and a
+counter. take() swaps the slots with a spare set and orders them outside the lock.
+*/
+class DisplayRing
+{
+    Q_DISABLE_COPY(DisplayRing)
+
+public:
+    enum Policy
+    {
+        DropOldest,
+        DropNewest,
+        Sample
+    };
+
+    static const int MaxStride = 1 << 20;
+
+    explicit DisplayRing(int capacity, Policy policy = DropOldest)
+        : slots_(qMax(capacity, 1)), spare_(qMax(capacity, 1))
+        , head_(0), size_(0), policy_(policy), overflowed_(false)
+    {
+        counters_.capacity = slots_.size();
+    }
+
+    // May be called from any thread, the stride starts over
+    void setPolicy(Policy policy)
+    {
+        QMutexLocker locker(&mutex_);
+        policy_ = policy;
+        counters_.stride = 1;
+    }
+
+    /**
+     * @brief Counts a message and decides whether it is shown, called on the subscriber thread.
+     * @return True if the message is to be passed to store().
+     */
+    bool admit()
+    {
+        QMutexLocker locker(&mutex_);
+        ++counters_.counted;
+        if (policy_ == Sample && counters_.counted % counters_.stride != 0)
+        {
+            ++counters_.sampledOut;
+            return false;
+        }
+        if (size_ == slots_.size() && policy_ != DropOldest)
+        {
+            ++counters_.dropped;
+            overflowed_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Stores an admitted message, called on the subscriber thread right after admit().
+     * @param timeStamp The receive time as shown.
+     * @param frames The topic and the formatted payload frames.
+     * @param raw True if the payload frames are as received.
+     * @return None
+     */
+    void store(const QString& timeStamp, const QList<QByteArray>& frames, bool raw)
+    {
+        QMutexLocker locker(&mutex_);
+        if (size_ == slots_.size())
+        {
+            // Only DropOldest gets here, the oldest slot is reused
+            ++counters_.dropped;
+            overflowed_ = true;
+            head_ = (head_ + 1) % slots_.size();
+            --size_;
+        }
+        DisplayMessage& slot = slots_[(head_ + size_) % slots_.size()];
+        slot.timeStamp = timeStamp;
+        slot.frames = frames;
+        slot.raw = raw;
+        ++size_;
+    }
+
+    /**
+     * @brief Takes all stored messages, called on the GUI thread only.
+     * @param messages Receives the messages, oldest first; pass the same vector every time to reuse its memory.
+     * @return The counters after the take.
+     */
+    DisplayCounters take(QVector<DisplayMessage>* messages)
+    {
+        int head;
+        int size;
+        DisplayCounters counters;
+        {
+            QMutexLocker locker(&mutex_);
+            std::swap(slots_, spare_);
+            head = head_;
+            size = size_;
+            head_ = 0;
+            size_ = 0;
+            counters_.displayed += size;
+
+            if (policy_ == Sample)
+            {
+                if (overflowed_)
+                {
+                    counters_.stride = qMin(counters_.stride * 2, static_cast<int>(MaxStride));
+                }
+                else if (size < spare_.size() / 4 && counters_.stride > 1)
+                {
+                    counters_.stride /= 2;
+                }
+            }
+            overflowed_ = false;
+            counters = counters_;
+        }
+
+        // spare_ now holds the taken slots, the subscriber only writes to slots_
+        messages->resize(size);
+        for (int i = 0; i < size; ++i)
+        {
+            DisplayMessage& slot = spare_[(head + i) % spare_.size()];
+            (*messages)[i].timeStamp.swap(slot.timeStamp);
+            (*messages)[i].frames.swap(slot.frames);
+            (*messages)[i].raw = slot.raw;
+            slot.timeStamp.clear();
+            slot.frames.clear();
+        }
+        return counters;
+    }
+
+    // May be called from any thread
+    DisplayCounters counters() const
+    {
+        QMutexLocker locker(&mutex_);
+        return counters_;
+    }
+
+private:
+    QVector<DisplayMessage> slots_;     // Written by the subscriber under mutex_
+    QVector<DisplayMessage> spare_;     // Emptied by take() outside the lock
+    int head_;
+    int size_;
+    Policy policy_;
+    bool overflowed_;                   // A message was dropped since the previous take()
+    DisplayCounters counters_;
+    mutable QMutex mutex_;
+};
+
+}
+
+}
+
+#endif // NZMQT_DISPLAYRING_H
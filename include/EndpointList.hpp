@@ -0,0 +1,142 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_ENDPOINTLIST_H
+#define NZMQT_ENDPOINTLIST_H
+
+#include <QFile>
+#include <QRegularExpression>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Endpoint List:
+The publishers a subscriber connects to, typed into the UI, passed on the command line or read from a
+file. Endpoints are separated by whitespace, commas or semicolons and a '#' starts a comment up to the
+end of the line, so a file can list one publisher per line. "host:port" is short for "tcp://host:port"
+and a port range "host:5550-5589" stands for one endpoint per port, the usual way a fan-in test
+starts its publishers. Other transports such as ipc:// are taken as they are. Duplicates are dropped,
+the first occurrence keeps its place.
+*/
+class EndpointList
+{
+public:
+    static const int MaxEndpoints = 4096;
+
+    /**
+     * @brief Parses an endpoint list.
+     * @param text The endpoints, see above.
+     * @param endpoints Receives the endpoints in the order they were listed.
+     * @param error Receives a description of the first malformed endpoint.
+     * @return False if an endpoint is malformed or the list is longer than MaxEndpoints.
+     */
+    static bool parse(const QString& text, QStringList* endpoints, QString* error)
+    {
+        static const QRegularExpression separators("[\\s,;]+");
+        static const QRegularExpression tcp("^(?:tcp://)?(.+):(\\d+)(?:-(\\d+))?$");
+
+        QStringList result;
+        QSet<QString> seen;
+        const QStringList lines = text.split('\n');
+        for (const QString& line : lines)
+        {
+            const QStringList tokens = line.section('#', 0, 0).split(separators, Qt::SkipEmptyParts);
+            for (const QString& token : tokens)
+            {
+                QStringList expanded;
+                if (token.contains("://") && !token.startsWith("tcp://"))
+                {
+                    expanded.append(token);
+                }
+                else
+                {
+                    QRegularExpressionMatch match = tcp.match(token);
+                    int first = match.hasMatch() ? match.captured(2).toInt() : 0;
+                    int last = match.hasMatch() && match.capturedLength(3) > 0 ? match.captured(3).toInt() : first;
+                    if (first < 1 || last > 65535 || last < first)
+                    {
+                        *error = QString("%1 is not an endpoint, expected host:port, host:port-port or transport://address").arg(token);
+                        return false;
+                    }
+                    if (last - first >= MaxEndpoints)
+                    {
+                        *error = QString("%1 has more than %2 ports").arg(token).arg(MaxEndpoints);
+                        return false;
+                    }
+                    for (int port = first; port <= last; ++port)
+                    {
+                        expanded.append(QString("tcp://%1:%2").arg(match.captured(1)).arg(port));
+                    }
+                }
+
+                for (const QString& endpoint : expanded)
+                {
+                    if (seen.contains(endpoint))
+                    {
+                        continue;
+                    }
+                    if (result.size() == MaxEndpoints)
+                    {
+                        *error = QString("More than %1 endpoints").arg(MaxEndpoints);
+                        return false;
+                    }
+                    seen.insert(endpoint);
+                    result.append(endpoint);
+                }
+            }
+        }
+
+        *endpoints = result;
+        return true;
+    }
+
+    /**
+     * @brief Reads an endpoint list from a file.
+     * @param path The file, in the format parse() accepts.
+     * @param endpoints Receives the endpoints in the order they were listed.
+     * @param error Receives a description of the problem.
+     * @return False if the file cannot be read or parse() fails.
+     */
+    static bool load(const QString& path, QStringList* endpoints, QString* error)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            *error = QString("%1: %2").arg(path, file.errorString());
+            return false;
+        }
+        return parse(QString::fromUtf8(file.readAll()), endpoints, error);
+    }
+
+    /**
+     * @brief Distributes endpoints over sockets round robin.
+     * @param endpoints The endpoints.
+     * @param sockets The number of sockets, 0 for one socket per endpoint.
+     * @return The endpoints of each socket, no socket is left without one.
+     */
+    static QVector<QStringList> shard(const QStringList& endpoints, int sockets)
+    {
+        int count = sockets <= 0 ? endpoints.size() : qMin(sockets, endpoints.size());
+        QVector<QStringList> shards(count);
+        for (int i = 0; i < endpoints.size(); ++i)
+        {
+            shards[i % count].append(endpoints.at(i));
+        }
+        return shards;
+    }
+};
+
+}
+
+}
+
+#endif // NZMQT_ENDPOINTLIST_H
@@ -0,0 +1,291 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_ENDPOINTSTATS_H
+#define NZMQT_ENDPOINTSTATS_H
+
+#include "HdrHistogram.hpp"
+#include "LatencyStats.hpp"
+#include "cppzmq/zmq.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <cstring>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+// Connection of one publisher endpoint, as told by the monitor events of its socket
+struct EndpointState
+{
+    enum State
+    {
+        CONNECTING,         // Connect called, no event yet
+        CONNECTED,
+        RETRYING,           // The last attempt failed, ZeroMQ retries after the reconnect interval
+        DISCONNECTED        // The connection broke, ZeroMQ reconnects
+    };
+
+    QString endpoint;
+    int socket;
+    State state;
+    quint32 connects;
+    quint32 disconnects;
+    quint32 retries;
+    qint64 changedNs;       // Monotonic time of the last state change, 0 before the first event
+
+    EndpointState()
+        : socket(0), state(CONNECTING), connects(0), disconnects(0), retries(0), changedNs(0)
+    {
+    }
+};
+
+// Traffic of one subscriber socket, shared by the endpoints it connects to
+struct SocketTraffic
+{
+    int endpoints;
+    quint64 messages;       // Messages as delivered by the socket, before the wildcard filter
+    quint64 bytes;
+    double messageRate;     // Since the previous report
+    double byteRate;
+    quint64 stamped;
+    quint64 missing;        // Sequence numbers skipped by the stamped messages of this socket
+    LatencySummary latency; // Measured latency of the stamped messages since the previous report
+    qint64 idleNs;          // Time since the last message, -1 before the first
+
+    SocketTraffic()
+        : endpoints(0), messages(0), bytes(0), messageRate(0.0), byteRate(0.0), stamped(0), missing(0), idleNs(-1)
+    {
+    }
+
+    double lossRate() const
+    {
+        quint64 expected = stamped + missing;
+        return expected == 0 ? 0.0 : static_cast<double>(missing) / expected;
+    }
+};
+
+struct EndpointReport
+{
+    QVector<EndpointState> endpoints;
+    QVector<SocketTraffic> sockets;
+
+    int connected() const
+    {
+        int count = 0;
+        for (const EndpointState& endpoint : endpoints)
+        {
+            count += endpoint.state == EndpointState::CONNECTED ? 1 : 0;
+        }
+        return count;
+    }
+};
+
+/*
+Endpoint Stats:
+The per endpoint view of a subscriber that connects to many publishers. A SUB socket does not tell
+which of its connections delivered a message, so traffic, latency and loss are counted per socket;
+with one socket per endpoint, the default, that is the per endpoint breakdown. The connection state
+of every endpoint comes from the socket monitor, connects, retries and disconnects are counted even
+when several endpoints share a socket. record() only indexes a vector, the latency histograms are
+allocated by setEndpoints() and reset by every report.
+*/
+class EndpointStats
+{
+    Q_DISABLE_COPY(EndpointStats)
+
+public:
+    // The events monitorEvent() understands, pass them to zmq_socket_monitor()
+    static const int MonitorEvents = ZMQ_EVENT_CONNECTED | ZMQ_EVENT_CONNECT_RETRIED | ZMQ_EVENT_DISCONNECTED;
+
+    EndpointStats()
+        : reportedNs_(0)
+    {
+    }
+
+    /**
+     * @brief Sets the endpoints of every socket, all counters start over.
+     * @param sockets The endpoints each socket connects to, see EndpointList::shard().
+     * @param nowNs The monotonic time.
+     * @return None
+     */
+    void setEndpoints(const QVector<QStringList>& sockets, qint64 nowNs)
+    {
+        endpoints_.clear();
+        sockets_.clear();
+        lastReceiveNs_.clear();
+        reportedMessages_.clear();
+        reportedBytes_.clear();
+        histograms_.clear();
+        lookup_.clear();
+        for (int socket = 0; socket < sockets.size(); ++socket)
+        {
+            for (const QString& endpoint : sockets.at(socket))
+            {
+                EndpointState state;
+                state.endpoint = endpoint;
+                state.socket = socket;
+                lookup_.insert(qMakePair(socket, endpoint.toUtf8()), endpoints_.size());
+                endpoints_.append(state);
+            }
+            SocketTraffic traffic;
+            traffic.endpoints = sockets.at(socket).size();
+            sockets_.append(traffic);
+            lastReceiveNs_.append(-1);
+            reportedMessages_.append(0);
+            reportedBytes_.append(0);
+            histograms_.append(HdrHistogram(60LL * 1000000000LL, 2));
+        }
+        reportedNs_ = nowNs;
+    }
+
+    bool isEmpty() const
+    {
+        return endpoints_.isEmpty();
+    }
+
+    void record(int socket, quint64 size, qint64 receiveNs)
+    {
+        SocketTraffic& traffic = sockets_[socket];
+        ++traffic.messages;
+        traffic.bytes += size;
+        lastReceiveNs_[socket] = receiveNs;
+    }
+
+    void recordLatency(int socket, qint64 latencyNs)
+    {
+        ++sockets_[socket].stamped;
+        histograms_[socket].record(latencyNs);
+    }
+
+    void addMissing(int socket, quint64 missing)
+    {
+        sockets_[socket].missing += missing;
+    }
+
+    /**
+     * @brief Applies a message of a socket monitor.
+     * @param socket The socket that is monitored.
+     * @param frames The event frame, 16 bit event and 32 bit value in host order, and the endpoint frame.
+     * @param nowNs The monotonic time.
+     * @return None
+     */
+    void monitorEvent(int socket, const QList<QByteArray>& frames, qint64 nowNs)
+    {
+        if (frames.size() != 2 || frames.at(0).size() < 6)
+        {
+            return;
+        }
+        quint16 event;
+        memcpy(&event, frames.at(0).constData(), sizeof(event));
+
+        int index = find(socket, frames.at(1));
+        if (index < 0)
+        {
+            return;
+        }
+
+        EndpointState& endpoint = endpoints_[index];
+        switch (event)
+        {
+        case ZMQ_EVENT_CONNECTED:
+            ++endpoint.connects;
+            endpoint.state = EndpointState::CONNECTED;
+            break;
+        case ZMQ_EVENT_CONNECT_RETRIED:
+            // Every failed attempt is counted, the state changes with the first one
+            ++endpoint.retries;
+            if (endpoint.state == EndpointState::RETRYING)
+            {
+                return;
+            }
+            endpoint.state = EndpointState::RETRYING;
+            break;
+        case ZMQ_EVENT_DISCONNECTED:
+            ++endpoint.disconnects;
+            endpoint.state = EndpointState::DISCONNECTED;
+            break;
+        default:
+            return;
+        }
+        endpoint.changedNs = nowNs;
+    }
+
+    /**
+     * @brief Takes the counters of all endpoints and sockets, the rates and latencies cover the time since the previous report.
+     * @param nowNs The monotonic time.
+     * @return The report.
+     */
+    EndpointReport report(qint64 nowNs)
+    {
+        EndpointReport report;
+        report.endpoints = endpoints_;
+        report.sockets = sockets_;
+
+        double seconds = (nowNs - reportedNs_) / 1e9;
+        for (int socket = 0; socket < sockets_.size(); ++socket)
+        {
+            SocketTraffic& traffic = report.sockets[socket];
+            if (seconds > 0.0)
+            {
+                traffic.messageRate = (traffic.messages - reportedMessages_.at(socket)) / seconds;
+                traffic.byteRate = (traffic.bytes - reportedBytes_.at(socket)) / seconds;
+            }
+            traffic.latency = LatencySummary::fromHistogram(histograms_.at(socket));
+            traffic.idleNs = lastReceiveNs_.at(socket) < 0 ? -1 : nowNs - lastReceiveNs_.at(socket);
+
+            reportedMessages_[socket] = traffic.messages;
+            reportedBytes_[socket] = traffic.bytes;
+            histograms_[socket].reset();
+        }
+        reportedNs_ = nowNs;
+        return report;
+    }
+
+private:
+    // ZeroMQ reports the endpoint as it was connected, a resolved host name only differs in the address
+    int find(int socket, const QByteArray& endpoint) const
+    {
+        int index = lookup_.value(qMakePair(socket, endpoint), -1);
+        if (index >= 0 || socket >= sockets_.size() || sockets_.at(socket).endpoints != 1)
+        {
+            return index;
+        }
+        for (int i = 0; i < endpoints_.size(); ++i)
+        {
+            if (endpoints_.at(i).socket == socket)
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    QVector<EndpointState> endpoints_;
+    QVector<SocketTraffic> sockets_;
+    QVector<qint64> lastReceiveNs_;         // Per socket
+    QVector<quint64> reportedMessages_;     // SocketTraffic::messages at the previous report, per socket
+    QVector<quint64> reportedBytes_;
+    QVector<HdrHistogram> histograms_;      // Latency since the previous report, per socket
+    QHash<QPair<int, QByteArray>, int> lookup_;     // (socket, endpoint) to index in endpoints_
+    qint64 reportedNs_;
+};
+
+}
+
+}
+
+Q_DECLARE_METATYPE(nzmqt::samples::EndpointReport)
+
+#endif // NZMQT_ENDPOINTSTATS_H
@@ -0,0 +1,82 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_FASTRANDOM_H
+#define NZMQT_FASTRANDOM_H
+
+#include <QtGlobal>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Fast Random:
+xoshiro256** by Blackman and Vigna, seeded through splitmix64. A few shifts and multiplications per
+number and no shared state, so every sender owns its generator and draws in the send loop without
+locking. Not suitable for anything security related.
+*/
+class FastRandom
+{
+public:
+    explicit FastRandom(quint64 seed = 0x9E3779B97F4A7C15ULL)
+    {
+        seedWith(seed);
+    }
+
+    void seedWith(quint64 seed)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            seed += 0x9E3779B97F4A7C15ULL;
+            quint64 z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            state_[i] = z ^ (z >> 31);
+        }
+    }
+
+    quint64 next()
+    {
+        const quint64 result = rotl(state_[1] * 5, 7) * 9;
+        const quint64 t = state_[1] << 17;
+
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+
+        return result;
+    }
+
+    // Uniform in [0, bound), multiply and shift instead of a division, bias is below 2^-32 for any bound
+    quint32 bounded(quint32 bound)
+    {
+        return static_cast<quint32>(((next() >> 32) * bound) >> 32);
+    }
+
+    // Uniform in [0, 1)
+    double uniform()
+    {
+        return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+private:
+    static quint64 rotl(quint64 x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    quint64 state_[4];
+};
+
+}
+
+}
+
+#endif // NZMQT_FASTRANDOM_H
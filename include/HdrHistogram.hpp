@@ -0,0 +1,222 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_HDRHISTOGRAM_H
+#define NZMQT_HDRHISTOGRAM_H
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+#include <QVector>
+
+#include <cmath>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+HDR Histogram:
+A log-linear histogram in the spirit of Gil Tene's HdrHistogram. Values are grouped in buckets whose
+width doubles from one bucket to the next, each bucket is split into a fixed number of linear sub buckets.
+This keeps the relative error below 10^-significantDigits over the whole trackable range while the
+memory is allocated once in the constructor and record() is a handful of integer operations.
+The lowest discernible value is 1, so latencies should be recorded in nanoseconds.
+*/
+class HdrHistogram
+{
+public:
+    explicit HdrHistogram(qint64 highestTrackableValue = 60LL * 1000000000LL, int significantDigits = 3)
+        : highestTrackableValue_(qMax<qint64>(highestTrackableValue, 2))
+        , totalCount_(0), minValue_(0), maxValue_(0)
+    {
+        significantDigits = qBound(1, significantDigits, 5);
+
+        // Enough sub buckets to tell apart two values that differ in the last significant digit
+        qint64 largestSingleUnitResolution = 2;
+        for (int i = 0; i < significantDigits; ++i)
+        {
+            largestSingleUnitResolution *= 10;
+        }
+        subBucketCountMagnitude_ = static_cast<int>(std::ceil(std::log2(static_cast<double>(largestSingleUnitResolution))));
+        subBucketHalfCountMagnitude_ = subBucketCountMagnitude_ - 1;
+        subBucketCount_ = 1LL << subBucketCountMagnitude_;
+        subBucketHalfCount_ = subBucketCount_ / 2;
+        subBucketMask_ = subBucketCount_ - 1;
+
+        // Buckets needed until the top of the last one reaches the highest trackable value
+        int bucketCount = 1;
+        qint64 smallestUntrackableValue = subBucketCount_;
+        while (smallestUntrackableValue <= highestTrackableValue_)
+        {
+            smallestUntrackableValue <<= 1;
+            ++bucketCount;
+        }
+        counts_.fill(0, static_cast<int>((bucketCount + 1) * subBucketHalfCount_));
+    }
+
+    /**
+     * @brief Records a single value, values outside of the trackable range are clamped.
+     * @param value The value to be recorded.
+     * @return None
+     */
+    void record(qint64 value)
+    {
+        recordCount(value, 1);
+    }
+
+    /**
+     * @brief Records a value count times.
+     * @param value The value to be recorded.
+     * @param count How often the value occurred.
+     * @return None
+     */
+    void recordCount(qint64 value, qint64 count)
+    {
+        value = qBound<qint64>(0, value, highestTrackableValue_);
+        counts_[countsIndex(value)] += count;
+
+        if (totalCount_ == 0 || value < minValue_)
+        {
+            minValue_ = value;
+        }
+        if (value > maxValue_)
+        {
+            maxValue_ = value;
+        }
+        totalCount_ += count;
+    }
+
+    /**
+     * @brief Records a value and back-fills the samples a stalled sender would have produced meanwhile.
+     * @param value The value to be recorded.
+     * @param expectedInterval The expected interval between two samples, 0 disables back-filling.
+     * @return None
+     * @note This is HdrHistogram's recordValueWithExpectedInterval(): a value of 10 intervals means nine
+     *       samples were held back, they are recorded with the latencies they would have seen.
+     */
+    void recordCorrected(qint64 value, qint64 expectedInterval)
+    {
+        record(value);
+        if (expectedInterval <= 0)
+        {
+            return;
+        }
+
+        for (qint64 missing = value - expectedInterval; missing >= expectedInterval; missing -= expectedInterval)
+        {
+            record(missing);
+        }
+    }
+
+    /**
+     * @brief Adds all counts of another histogram with the same layout.
+     * @param other The histogram to be added.
+     * @return None
+     */
+    void add(const HdrHistogram& other)
+    {
+        Q_ASSERT(other.counts_.size() == counts_.size());
+        if (other.totalCount_ == 0)
+        {
+            return;
+        }
+
+        qint64* dst = counts_.data();
+        const qint64* src = other.counts_.constData();
+        for (int i = 0, n = counts_.size(); i < n; ++i)
+        {
+            dst[i] += src[i];
+        }
+
+        if (totalCount_ == 0 || other.minValue_ < minValue_)
+        {
+            minValue_ = other.minValue_;
+        }
+        maxValue_ = qMax(maxValue_, other.maxValue_);
+        totalCount_ += other.totalCount_;
+    }
+
+    void reset()
+    {
+        if (totalCount_ != 0)
+        {
+            counts_.fill(0);
+        }
+        totalCount_ = 0;
+        minValue_ = 0;
+        maxValue_ = 0;
+    }
+
+    qint64 totalCount() const { return totalCount_; }
+    qint64 min() const { return minValue_; }
+    qint64 max() const { return maxValue_; }
+
+    /**
+     * @brief Returns the value below which the given percentage of recorded values fall.
+     * @param percentile The percentile in the range 0 to 100.
+     * @return The highest value equivalent to the bucket holding the percentile, 0 if the histogram is empty.
+     */
+    qint64 valueAtPercentile(double percentile) const
+    {
+        if (totalCount_ == 0)
+        {
+            return 0;
+        }
+
+        percentile = qBound(0.0, percentile, 100.0);
+        qint64 countAtPercentile = qMax<qint64>(1, static_cast<qint64>(std::ceil(percentile / 100.0 * totalCount_)));
+
+        qint64 cumulative = 0;
+        const qint64* counts = counts_.constData();
+        for (int i = 0, n = counts_.size(); i < n; ++i)
+        {
+            cumulative += counts[i];
+            if (cumulative >= countAtPercentile)
+            {
+                return qMin(highestEquivalentValue(i), maxValue_);
+            }
+        }
+        return maxValue_;
+    }
+
+private:
+    int countsIndex(qint64 value) const
+    {
+        // Position of the highest set bit selects the bucket, the bits below it the sub bucket
+        int bucketIndex = 63 - qCountLeadingZeroBits(static_cast<quint64>(value | subBucketMask_)) - subBucketHalfCountMagnitude_;
+        int subBucketIndex = static_cast<int>(value >> bucketIndex);
+        return ((bucketIndex + 1) << subBucketHalfCountMagnitude_) + (subBucketIndex - static_cast<int>(subBucketHalfCount_));
+    }
+
+    qint64 highestEquivalentValue(int index) const
+    {
+        int bucketIndex = (index >> subBucketHalfCountMagnitude_) - 1;
+        qint64 subBucketIndex = (index & (subBucketHalfCount_ - 1)) + subBucketHalfCount_;
+        if (bucketIndex < 0)
+        {
+            subBucketIndex -= subBucketHalfCount_;
+            bucketIndex = 0;
+        }
+        return ((subBucketIndex + 1) << bucketIndex) - 1;
+    }
+
+    qint64 highestTrackableValue_;
+    int subBucketCountMagnitude_;
+    int subBucketHalfCountMagnitude_;
+    qint64 subBucketCount_;
+    qint64 subBucketHalfCount_;
+    qint64 subBucketMask_;
+    qint64 totalCount_;
+    qint64 minValue_;
+    qint64 maxValue_;
+    QVector<qint64> counts_;
+};
+
+}
+
+}
+
+#endif // NZMQT_HDRHISTOGRAM_H
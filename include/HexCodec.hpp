@@ -0,0 +1,331 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_HEXCODEC_H
+#define NZMQT_HEXCODEC_H
+
+#include <QByteArray>
+#include <QString>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NZMQT_HEXCODEC_SSE2
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define NZMQT_HEXCODEC_TARGET_SSSE3
+#else
+#define NZMQT_HEXCODEC_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#endif
+
+#include <cstring>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Hex Codec:
+Turns a hex dump into binary, e.g. to publish frames of a binary protocol that are typed or pasted into
+the message field. Digits are case insensitive and read in pairs, whitespace anywhere is skipped, so
+both "0a1b2c" and the "0A 1B 2C" of the subscriber's hex display are accepted.
+Runs of 32 digits without whitespace are decoded 16 bytes at a time with SSE2, which covers dumps
+of several MB; whitespace and the tail go through a lookup table one character at a time.
+The other direction writes the "0A 1B 2C " text of the hex display into one presized buffer: 16 bytes
+at a time with SSSE3 where the CPU has it, checked once at run time, otherwise 3 characters per byte
+from a lookup table. bench/hexbench.cpp measures both.
+*/
+class HexCodec
+{
+public:
+    /**
+     * @brief Decodes a hex dump.
+     * @param text The hex digits, whitespace is ignored.
+     * @param bytes Receives the decoded bytes.
+     * @param error Receives a description of the problem, with the offset of the first bad character.
+     * @return False if the text contains a character that is neither a hex digit nor whitespace, or an odd number of digits.
+     */
+    static bool decode(const QByteArray& text, QByteArray* bytes, QString* error)
+    {
+        const signed char* table = lookupTable();
+        const uchar* begin = reinterpret_cast<const uchar*>(text.constData());
+        const uchar* end = begin + text.size();
+        const uchar* p = begin;
+
+        QByteArray result(text.size() / 2, Qt::Uninitialized);
+        uchar* out = reinterpret_cast<uchar*>(result.data());
+        int high = -1;                  // First digit of a pair whose second digit is still to come
+        qint64 highOffset = 0;
+
+        while (p < end)
+        {
+#ifdef NZMQT_HEXCODEC_SSE2
+            while (high < 0 && end - p >= 32 && decodeBlock(p, out))
+            {
+                p += 32;
+                out += 16;
+            }
+#endif
+            // Whitespace or the tail, at most one block before trying the fast path again
+            const uchar* stop = end - p > 32 ? p + 32 : end;
+            for (; p < stop; ++p)
+            {
+                int value = table[*p];
+                if (value == Space)
+                {
+                    continue;
+                }
+                if (value == Invalid)
+                {
+                    *error = QString("Invalid character '%1' at offset %2 of the hex message")
+                        .arg(QChar(*p)).arg(p - begin);
+                    return false;
+                }
+                if (high < 0)
+                {
+                    high = value;
+                    highOffset = p - begin;
+                }
+                else
+                {
+                    *out++ = static_cast<uchar>(high << 4 | value);
+                    high = -1;
+                }
+            }
+        }
+
+        if (high >= 0)
+        {
+            *error = QString("The hex message has an odd number of digits, the digit at offset %1 has no pair").arg(highOffset);
+            return false;
+        }
+
+        result.resize(static_cast<int>(out - reinterpret_cast<uchar*>(result.data())));
+        *bytes = result;
+        return true;
+    }
+
+    /**
+     * @brief Formats bytes as upper case hex pairs, each one followed by a space.
+     * @param bytes The bytes to format.
+     * @return The text, 3 characters per byte.
+     */
+    static QByteArray toSpacedHex(const QByteArray& bytes)
+    {
+        QByteArray text(bytes.size() * 3, Qt::Uninitialized);
+        toSpacedHex(bytes.constData(), bytes.size(), text.data());
+        return text;
+    }
+
+    // Writes size * 3 characters to out
+    static void toSpacedHex(const char* data, int size, char* out)
+    {
+#ifdef NZMQT_HEXCODEC_SSE2
+        if (hasSsse3())
+        {
+            toSpacedHexSsse3(data, size, out);
+            return;
+        }
+#endif
+        toSpacedHexScalar(data, size, out);
+    }
+
+    static void toSpacedHexScalar(const char* data, int size, char* out)
+    {
+        const char* table = spacedTable();
+        for (int i = 0; i < size; ++i)
+        {
+            memcpy(out + i * 3, table + static_cast<uchar>(data[i]) * 3, 3);
+        }
+    }
+
+#ifdef NZMQT_HEXCODEC_SSE2
+    static bool hasSsse3()
+    {
+        static const bool supported = detectSsse3();
+        return supported;
+    }
+
+    NZMQT_HEXCODEC_TARGET_SSSE3
+    static void toSpacedHexSsse3(const char* data, int size, char* out)
+    {
+        const SpacedMasks& masks = spacedMasks();
+        const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F');
+        const __m128i low = _mm_set1_epi8(0x0F);
+
+        int i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), low));
+            __m128i lowDigits = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, low));
+
+            // The pairs of the first and the last 8 bytes, spread to 3 characters per byte with a space in between
+            __m128i first = _mm_unpacklo_epi8(high, lowDigits);
+            __m128i second = _mm_unpackhi_epi8(high, lowDigits);
+            for (int j = 0; j < 3; ++j)
+            {
+                __m128i text = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(first, masks.first[j]), _mm_shuffle_epi8(second, masks.second[j])), masks.spaces[j]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 3 + j * 16), text);
+            }
+        }
+        toSpacedHexScalar(data + i, size - i, out + i * 3);
+    }
+#endif
+
+private:
+    enum
+    {
+        Space = -1,
+        Invalid = -2
+    };
+
+    static const signed char* lookupTable()
+    {
+        struct Table
+        {
+            signed char values[256];
+
+            Table()
+            {
+                for (int c = 0; c < 256; ++c)
+                {
+                    values[c] = Invalid;
+                }
+                for (int c = 0; c < 10; ++c)
+                {
+                    values['0' + c] = static_cast<signed char>(c);
+                }
+                for (int c = 0; c < 6; ++c)
+                {
+                    values['a' + c] = static_cast<signed char>(10 + c);
+                    values['A' + c] = static_cast<signed char>(10 + c);
+                }
+                values[' '] = values['\t'] = values['\n'] = values['\r'] = values['\v'] = values['\f'] = Space;
+            }
+        };
+        static const Table table;
+        return table.values;
+    }
+
+    static const char* spacedTable()
+    {
+        struct Table
+        {
+            char text[256 * 3];
+
+            Table()
+            {
+                static const char digits[] = "0123456789ABCDEF";
+                for (int b = 0; b < 256; ++b)
+                {
+                    text[b * 3] = digits[b >> 4];
+                    text[b * 3 + 1] = digits[b & 0xF];
+                    text[b * 3 + 2] = ' ';
+                }
+            }
+        };
+        static const Table table;
+        return table.text;
+    }
+
+#ifdef NZMQT_HEXCODEC_SSE2
+    static bool detectSsse3()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+#else
+        return __builtin_cpu_supports("ssse3");
+#endif
+    }
+
+    // Shuffles that turn 32 digits of 16 bytes into 48 characters: output character k belongs to byte k / 3,
+    // its third character is a space. Indexes with the high bit set make pshufb write 0.
+    struct SpacedMasks
+    {
+        __m128i first[3];
+        __m128i second[3];
+        __m128i spaces[3];
+    };
+
+    static const SpacedMasks& spacedMasks()
+    {
+        struct Masks
+        {
+            SpacedMasks masks;
+
+            Masks()
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    alignas(16) char first[16];
+                    alignas(16) char second[16];
+                    alignas(16) char spaces[16];
+                    for (int k = 0; k < 16; ++k)
+                    {
+                        int position = j * 16 + k;
+                        int byte = position / 3;
+                        int digit = byte * 2 + position % 3;
+                        bool space = position % 3 == 2;
+                        first[k] = !space && byte < 8 ? static_cast<char>(digit) : static_cast<char>(0x80);
+                        second[k] = !space && byte >= 8 ? static_cast<char>(digit - 16) : static_cast<char>(0x80);
+                        spaces[k] = space ? ' ' : 0;
+                    }
+                    masks.first[j] = _mm_load_si128(reinterpret_cast<const __m128i*>(first));
+                    masks.second[j] = _mm_load_si128(reinterpret_cast<const __m128i*>(second));
+                    masks.spaces[j] = _mm_load_si128(reinterpret_cast<const __m128i*>(spaces));
+                }
+            }
+        };
+        static const Masks masks;
+        return masks.masks;
+    }
+
+    // The nibbles of 16 digits as 8 bytes in the low bytes of 16 bit lanes, false if any of them is not a digit
+    static bool decodeHalf(const uchar* p, __m128i* lanes)
+    {
+        __m128i text = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i lower = _mm_or_si128(text, _mm_set1_epi8(0x20));
+
+        // Signed compares, bytes >= 0x80 are negative and fail both ranges
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(text, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(text, _mm_set1_epi8('9' + 1)));
+        __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+        if (_mm_movemask_epi8(_mm_or_si128(digit, alpha)) != 0xFFFF)
+        {
+            return false;
+        }
+
+        __m128i nibbles = _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(text, _mm_set1_epi8('0'))),
+                                       _mm_and_si128(alpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+
+        // Little endian lanes hold the first digit of a pair in the low byte and the second one in the high byte
+        __m128i high = _mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0x00F0));
+        *lanes = _mm_or_si128(high, _mm_srli_epi16(nibbles, 8));
+        return true;
+    }
+
+    static bool decodeBlock(const uchar* p, uchar* out)
+    {
+        __m128i first;
+        __m128i second;
+        if (!decodeHalf(p, &first) || !decodeHalf(p + 16, &second))
+        {
+            return false;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(first, second));
+        return true;
+    }
+#endif
+};
+
+}
+
+}
+
+#endif // NZMQT_HEXCODEC_H
@@ -0,0 +1,222 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_LATENCYSTATS_H
+#define NZMQT_LATENCYSTATS_H
+
+#include "HdrHistogram.hpp"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMetaType>
+#include <QVector>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+// Percentiles of one histogram, in nanoseconds
+struct LatencySummary
+{
+    qint64 count;
+    qint64 p50;
+    qint64 p90;
+    qint64 p99;
+    qint64 p999;
+    qint64 p9999;
+    qint64 max;
+
+    LatencySummary()
+        : count(0), p50(0), p90(0), p99(0), p999(0), p9999(0), max(0)
+    {
+    }
+
+    static LatencySummary fromHistogram(const HdrHistogram& histogram)
+    {
+        LatencySummary summary;
+        summary.count = histogram.totalCount();
+        summary.p50 = histogram.valueAtPercentile(50.0);
+        summary.p90 = histogram.valueAtPercentile(90.0);
+        summary.p99 = histogram.valueAtPercentile(99.0);
+        summary.p999 = histogram.valueAtPercentile(99.9);
+        summary.p9999 = histogram.valueAtPercentile(99.99);
+        summary.max = histogram.max();
+        return summary;
+    }
+};
+
+// Sliding window and cumulative percentiles of one topic, an empty topic denotes all topics
+struct LatencyReport
+{
+    QByteArray topic;
+    LatencySummary window;
+    LatencySummary total;
+};
+
+// The first report always covers all topics
+typedef QVector<LatencyReport> LatencyReports;
+
+/*
+Latency Stats:
+Keeps a cumulative histogram and a ring of interval histograms for all topics and for each of the
+first MaxTopics topics seen. Merging the ring gives the sliding window, rotate() drops the oldest
+interval. All memory is allocated when a topic is first seen, record() never allocates.
+*/
+class LatencyStats
+{
+    Q_DISABLE_COPY(LatencyStats)
+
+public:
+    static const int MaxTopics = 64;
+
+    explicit LatencyStats(int windowSlots = 10)
+        : windowSlots_(qMax(1, windowSlots))
+        , overall_(windowSlots_, 3)
+    {
+    }
+
+    ~LatencyStats()
+    {
+        qDeleteAll(topics_);
+    }
+
+    /**
+     * @brief Records one latency sample for the given topic.
+     * @param topic The topic frame of the message.
+     * @param latencyNs The latency in nanoseconds.
+     * @param expectedIntervalNs The expected interval between messages of the stream, back-fills
+     *        the samples of held back messages if not 0, see HdrHistogram::recordCorrected().
+     * @return None
+     */
+    void record(const QByteArray& topic, qint64 latencyNs, qint64 expectedIntervalNs = 0)
+    {
+        overall_.record(latencyNs, expectedIntervalNs);
+
+        Histograms* histograms = topicHistograms(topic);
+        if (histograms)
+        {
+            histograms->record(latencyNs, expectedIntervalNs);
+        }
+    }
+
+    /**
+     * @brief Starts a new interval of the sliding window, the oldest interval is discarded.
+     * @param None
+     * @return None
+     */
+    void rotate()
+    {
+        overall_.rotate();
+        for (Histograms* histograms : topics_)
+        {
+            histograms->rotate();
+        }
+    }
+
+    void reset()
+    {
+        qDeleteAll(topics_);
+        topics_.clear();
+        topicOrder_.clear();
+        overall_.reset();
+    }
+
+    /**
+     * @brief Summarizes all histograms, the first report covers all topics.
+     * @param None
+     * @return The reports, ordered as the topics were first seen.
+     */
+    LatencyReports reports()
+    {
+        LatencyReports reports;
+        reports.reserve(topicOrder_.size() + 1);
+        reports.append(overall_.report(QByteArray()));
+        for (const QByteArray& topic : topicOrder_)
+        {
+            reports.append(topics_.value(topic)->report(topic));
+        }
+        return reports;
+    }
+
+private:
+    struct Histograms
+    {
+        HdrHistogram total;
+        QVector<HdrHistogram> slots;
+        HdrHistogram scratch;   // Merged sliding window, only used by report()
+        int current;
+
+        Histograms(int windowSlots, int significantDigits)
+            : total(60LL * 1000000000LL, significantDigits)
+            , slots(windowSlots, HdrHistogram(60LL * 1000000000LL, significantDigits))
+            , scratch(60LL * 1000000000LL, significantDigits)
+            , current(0)
+        {
+        }
+
+        void record(qint64 latencyNs, qint64 expectedIntervalNs)
+        {
+            total.recordCorrected(latencyNs, expectedIntervalNs);
+            slots[current].recordCorrected(latencyNs, expectedIntervalNs);
+        }
+
+        void rotate()
+        {
+            current = (current + 1) % slots.size();
+            slots[current].reset();
+        }
+
+        void reset()
+        {
+            total.reset();
+            for (HdrHistogram& slot : slots)
+            {
+                slot.reset();
+            }
+        }
+
+        LatencyReport report(const QByteArray& topic)
+        {
+            scratch.reset();
+            for (const HdrHistogram& slot : slots)
+            {
+                scratch.add(slot);
+            }
+
+            LatencyReport report;
+            report.topic = topic;
+            report.window = LatencySummary::fromHistogram(scratch);
+            report.total = LatencySummary::fromHistogram(total);
+            return report;
+        }
+    };
+
+    Histograms* topicHistograms(const QByteArray& topic)
+    {
+        Histograms* histograms = topics_.value(topic, 0);
+        if (histograms == 0 && topics_.size() < MaxTopics)
+        {
+            // Per topic histograms use two significant digits to keep the memory per topic small
+            histograms = new Histograms(windowSlots_, 2);
+            topics_.insert(topic, histograms);
+            topicOrder_.append(topic);
+        }
+        return histograms;
+    }
+
+    int windowSlots_;
+    Histograms overall_;
+    QHash<QByteArray, Histograms*> topics_;
+    QVector<QByteArray> topicOrder_;
+};
+
+}
+
+}
+
+Q_DECLARE_METATYPE(nzmqt::samples::LatencyReports)
+
+#endif // NZMQT_LATENCYSTATS_H
@@ -0,0 +1,241 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_LOADPROFILE_H
+#define NZMQT_LOADPROFILE_H
+
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+
+#include <cmath>
+#include <cstring>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Load Profile:
+The publish rate as a function of the time since the start. A profile is written as one line:
+    const RATE                      a constant rate
+    ramp FROM TO OVER               linear ramp, holds TO afterwards
+    step FROM INCREMENT DWELL [MAX] adds INCREMENT every DWELL, up to MAX
+    burst BASE PEAK LENGTH EVERY    PEAK for LENGTH at the start of every EVERY, BASE in between
+    sine MEAN AMPLITUDE PERIOD      MEAN + AMPLITUDE * sin(2 pi t / PERIOD)
+followed by an optional "for DURATION" after which the profile ends. A ramp without one ends when
+it reaches TO. Rates take a k or M suffix, PEAK may also be given as a factor of BASE such as 10x,
+durations need one of the units us, ms, s or m.
+Examples: "ramp 1k 1M 60s", "step 10k 10k 30s 200k", "burst 5k 10x 100ms 1s for 5m".
+While a profile runs its rate never drops below 1 msg/s, so the next due time is never infinite.
+*/
+class LoadProfile
+{
+public:
+    enum Shape
+    {
+        SHAPE_CONSTANT,
+        SHAPE_RAMP,
+        SHAPE_STEP,
+        SHAPE_BURST,
+        SHAPE_SINE
+    };
+
+    LoadProfile()
+        : shape_(SHAPE_CONSTANT), base_(0.0), second_(0.0), limit_(0.0)
+        , periodNs_(0), activeNs_(0), durationNs_(0)
+    {
+    }
+
+    static LoadProfile constant(double rate)
+    {
+        LoadProfile profile;
+        profile.base_ = qMax(0.0, rate);
+        return profile;
+    }
+
+    /**
+     * @brief Parses a profile, see the description of the class for the syntax.
+     * @param spec The profile.
+     * @param error Receives a description of the problem if parsing fails.
+     * @return False if the profile is malformed, the profile is left unchanged then.
+     */
+    bool parse(const QString& spec, QString* error)
+    {
+        QStringList words = spec.simplified().toLower().split(' ', Qt::SkipEmptyParts);
+        LoadProfile profile;
+
+        int forIndex = words.indexOf("for");
+        if (forIndex >= 0)
+        {
+            if (forIndex != words.size() - 2 || !parseDuration(words.last(), &profile.durationNs_))
+            {
+                *error = QString("Expected \"for DURATION\" at the end of the load profile");
+                return false;
+            }
+            words = words.mid(0, forIndex);
+        }
+
+        bool ok = !words.isEmpty();
+        QString shape = ok ? words.first() : QString();
+        int arguments = words.size() - 1;
+        if (shape == "const" && arguments == 1)
+        {
+            profile.shape_ = SHAPE_CONSTANT;
+            ok = parseRate(words.at(1), &profile.base_);
+        }
+        else if (shape == "ramp" && arguments == 3)
+        {
+            profile.shape_ = SHAPE_RAMP;
+            ok = parseRate(words.at(1), &profile.base_) && parseRate(words.at(2), &profile.second_)
+                && parseDuration(words.at(3), &profile.periodNs_);
+            if (profile.durationNs_ == 0)
+            {
+                profile.durationNs_ = profile.periodNs_;
+            }
+        }
+        else if (shape == "step" && (arguments == 3 || arguments == 4))
+        {
+            profile.shape_ = SHAPE_STEP;
+            ok = parseRate(words.at(1), &profile.base_) && parseRate(words.at(2), &profile.second_)
+                && parseDuration(words.at(3), &profile.periodNs_)
+                && (arguments == 3 || parseRate(words.at(4), &profile.limit_));
+        }
+        else if (shape == "burst" && arguments == 4)
+        {
+            profile.shape_ = SHAPE_BURST;
+            ok = parseRate(words.at(1), &profile.base_)
+                && parseDuration(words.at(3), &profile.activeNs_) && parseDuration(words.at(4), &profile.periodNs_);
+            if (ok && words.at(2).endsWith('x'))
+            {
+                double factor = 0.0;
+                ok = parseRate(words.at(2).chopped(1), &factor);
+                profile.second_ = profile.base_ * factor;
+            }
+            else
+            {
+                ok = ok && parseRate(words.at(2), &profile.second_);
+            }
+            ok = ok && profile.activeNs_ <= profile.periodNs_;
+        }
+        else if (shape == "sine" && arguments == 3)
+        {
+            profile.shape_ = SHAPE_SINE;
+            ok = parseRate(words.at(1), &profile.base_) && parseRate(words.at(2), &profile.second_)
+                && parseDuration(words.at(3), &profile.periodNs_);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok || (profile.shape_ != SHAPE_CONSTANT && profile.periodNs_ <= 0))
+        {
+            *error = QString("Invalid load profile \"%1\", expected const, ramp, step, burst or sine with their arguments").arg(spec);
+            return false;
+        }
+
+        *this = profile;
+        return true;
+    }
+
+    Shape shape() const { return shape_; }
+
+    // A constant profile without an end keeps its rate, the sender does not need to ask again
+    bool isConstant() const { return shape_ == SHAPE_CONSTANT && durationNs_ == 0; }
+
+    /**
+     * @brief Returns the rate at the given time.
+     * @param elapsedNs The time since the profile started.
+     * @return The rate in messages per second, 0 once the profile has ended or for a constant profile of rate 0.
+     */
+    double rateAt(qint64 elapsedNs) const
+    {
+        if (durationNs_ > 0 && elapsedNs >= durationNs_)
+        {
+            return 0.0;
+        }
+
+        double rate = base_;
+        switch (shape_)
+        {
+        case SHAPE_RAMP:
+            rate = elapsedNs >= periodNs_ ? second_ : base_ + (second_ - base_) * elapsedNs / periodNs_;
+            break;
+        case SHAPE_STEP:
+            rate = base_ + second_ * (elapsedNs / periodNs_);
+            if (limit_ > 0.0)
+            {
+                rate = qMin(rate, limit_);
+            }
+            break;
+        case SHAPE_BURST:
+            rate = elapsedNs % periodNs_ < activeNs_ ? second_ : base_;
+            break;
+        case SHAPE_SINE:
+            rate = base_ + second_ * std::sin(6.283185307179586 * (elapsedNs % periodNs_) / periodNs_);
+            break;
+        default:
+            return base_;
+        }
+        return qMax(1.0, rate);
+    }
+
+private:
+    static bool parseRate(const QString& word, double* rate)
+    {
+        double factor = 1.0;
+        QString number = word;
+        if (number.endsWith('k'))
+        {
+            factor = 1e3;
+            number.chop(1);
+        }
+        else if (number.endsWith('m'))
+        {
+            // Words are lower case at this point, there is no rate in milli messages
+            factor = 1e6;
+            number.chop(1);
+        }
+
+        bool ok = false;
+        *rate = number.toDouble(&ok) * factor;
+        return ok && *rate >= 0.0 && std::isfinite(*rate);
+    }
+
+    static bool parseDuration(const QString& word, qint64* durationNs)
+    {
+        static const struct { const char* suffix; double factor; } units[] = {
+            { "us", 1e3 }, { "ms", 1e6 }, { "s", 1e9 }, { "m", 60e9 }
+        };
+
+        for (const auto& unit : units)
+        {
+            if (word.endsWith(unit.suffix))
+            {
+                bool ok = false;
+                double value = word.chopped(static_cast<int>(strlen(unit.suffix))).toDouble(&ok);
+                *durationNs = static_cast<qint64>(value * unit.factor);
+                return ok && value >= 0.0;
+            }
+        }
+        return false;
+    }
+
+    Shape shape_;
+    double base_;           // Rate, start, base or mean
+    double second_;         // Target, increment, peak or amplitude
+    double limit_;          // Upper bound of a step profile, 0 if unbounded
+    qint64 periodNs_;       // Ramp time, dwell, burst period or sine period
+    qint64 activeNs_;       // Burst length
+    qint64 durationNs_;     // 0 if the profile runs until it is stopped
+};
+
+}
+
+}
+
+#endif // NZMQT_LOADPROFILE_H
@@ -0,0 +1,711 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_MAPPEDCAPTURE_H
+#define NZMQT_MAPPEDCAPTURE_H
+
+#include "CaptureFormat.hpp"
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <QtEndian>
+
+#include <algorithm>
+#include <limits>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#endif
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+class MappedCapture;
+
+/*
+Capture Cursor:
+Points at one message of a MappedCapture. Moving the cursor only parses record headers, the frame
+table is read when a frame is asked for and frame() is a view into the mapping, so walking over a
+million messages to find one copies nothing. Views stay valid while the capture is open; a frame
+that must outlive it is copied with QByteArray(view.constData(), view.size()).
+A cursor with a topic only stops at messages of that topic and skips blocks without it, see
+MappedCapture::seek().
+*/
+class CaptureCursor
+{
+public:
+    CaptureCursor()
+        : capture_(0), segment_(0), offset_(0), block_(-1), record_(0), topicId_(0)
+    {
+    }
+
+    // False once the cursor moved past the last message, or if the seek found none
+    bool isValid() const
+    {
+        return record_ != 0;
+    }
+
+    /**
+     * @brief Moves to the next message that passes the topic filter of the cursor.
+     * @param None
+     * @return False at the end of the capture, the cursor is invalid then.
+     */
+    bool next();
+
+    qint64 receiveNs() const
+    {
+        return header_.receiveNs;
+    }
+
+    quint32 topicId() const
+    {
+        return header_.topicId;
+    }
+
+    // The topic of the message, announced by the segment the message is in
+    QByteArray topic() const;
+
+    int segment() const
+    {
+        return segment_;
+    }
+
+    // Offset of the record from the start of its segment
+    quint64 offset() const
+    {
+        return offset_;
+    }
+
+    int frameCount() const
+    {
+        return header_.frameCount;
+    }
+
+    quint32 frameSize(int frame) const
+    {
+        return qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(record_ + CaptureFormat::RecordHeaderSize + frame * 4));
+    }
+
+    // The size of all frames together
+    quint64 dataSize() const
+    {
+        quint64 size = 0;
+        for (int i = 0; i < header_.frameCount; ++i)
+        {
+            size += frameSize(i);
+        }
+        return size;
+    }
+
+    /**
+     * @brief A view of one frame, nothing is copied.
+     * @param frame The frame number, 0 is the topic.
+     * @return The frame data, an empty array if the frame table is damaged.
+     */
+    QByteArray frame(int frame) const
+    {
+        quint64 offset = CaptureFormat::RecordHeaderSize + quint64(header_.frameCount) * 4;
+        for (int i = 0; i < frame; ++i)
+        {
+            offset += frameSize(i);
+        }
+        quint32 size = frameSize(frame);
+        if (offset + size > header_.size)
+        {
+            return QByteArray();
+        }
+        return QByteArray::fromRawData(record_ + offset, static_cast<int>(size));
+    }
+
+    // Views of all frames, empty if the frame table is damaged
+    QList<QByteArray> frames() const
+    {
+        QList<QByteArray> frames;
+        quint64 offset = CaptureFormat::RecordHeaderSize + quint64(header_.frameCount) * 4;
+        for (int i = 0; i < header_.frameCount; ++i)
+        {
+            quint32 size = frameSize(i);
+            if (offset + size > header_.size)
+            {
+                return QList<QByteArray>();
+            }
+            frames.append(QByteArray::fromRawData(record_ + offset, static_cast<int>(size)));
+            offset += size;
+        }
+        return frames;
+    }
+
+private:
+    friend class MappedCapture;
+
+    const MappedCapture* capture_;
+    int segment_;
+    quint64 offset_;
+    qint64 block_;              // Block of the current record, the block after it is prefetched on entry
+    const char* record_;        // 0 if the cursor is invalid
+    CaptureFormat::RecordHeader header_;
+    QByteArray topic_;          // Empty for all topics
+    quint32 topicId_;           // Id of topic_ in the current segment
+};
+
+/*
+Mapped Capture:
+Random access to a capture for the viewer, replay and offline analysis. Every segment is mapped
+read only, so the kernel pages in what is looked at and nothing else, and the sparse index written
+next to each segment is loaded at open. A segment without one, e.g. the one still being recorded or
+left behind by a crash, is scanned once at open to build the same index in memory.
+seek() finds the segment by the start time in the file headers, then the last block that starts
+before the time by a binary search over the time index, and walks the records of that one block, so
+finding a moment costs a few page faults whatever the size of the capture. A topic filter jumps from
+block to block through the topic index.
+Segments are opened from the given one on, so replay can start at any segment, and a damaged segment is read
+up to the damage.
+*/
+class MappedCapture
+{
+    Q_DISABLE_COPY(MappedCapture)
+
+public:
+    // Grid of the index built for segments written without a block size
+    static const quint32 ScanBlockSize = 1024 * 1024;
+
+    MappedCapture()
+        : lastNs_(0)
+    {
+    }
+
+    ~MappedCapture()
+    {
+        close();
+    }
+
+    /**
+     * @brief Maps a segment and the following segments of its capture.
+     * @param path The path of a segment, a file outside the naming scheme is opened alone.
+     * @param error Receives a description of the problem if the capture cannot be opened.
+     * @param following False maps the given segment only.
+     * @return False if the first segment cannot be mapped or is not a capture file.
+     */
+    bool open(const QString& path, QString* error, bool following = true)
+    {
+        close();
+
+        QString prefix;
+        int index = -1;
+        if (!CaptureFormat::parseSegmentPath(path, &prefix, &index))
+        {
+            index = -1;
+        }
+
+        QString segmentPath = path;
+        while (Segment* segment = openSegment(segmentPath, error))
+        {
+            loadIndex(segment, index < 0 ? QString() : CaptureFormat::indexPath(prefix, index));
+            segments_.append(segment);
+            if (index < 0 || !following)
+            {
+                break;
+            }
+
+            segmentPath = CaptureFormat::segmentPath(prefix, ++index);
+            if (!QFile::exists(segmentPath))
+            {
+                break;
+            }
+        }
+        if (segments_.isEmpty())
+        {
+            return false;
+        }
+
+        // The last time entry is at most a block before the end of the capture
+        const Segment* last = segments_.last();
+        lastNs_ = last->header.startNs;
+        quint64 offset = last->times.isEmpty() ? last->begin : last->times.last().offset;
+        CaptureFormat::RecordHeader header;
+        while (recordAt(*last, offset, &header))
+        {
+            if (header.type == CaptureFormat::REC_MESSAGE)
+            {
+                lastNs_ = qMax(lastNs_, header.receiveNs);
+            }
+            offset += header.size;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        for (Segment* segment : segments_)
+        {
+            segment->file.unmap(const_cast<uchar*>(reinterpret_cast<const uchar*>(segment->data)));
+            delete segment;
+        }
+        segments_.clear();
+        lastNs_ = 0;
+    }
+
+    bool isOpen() const
+    {
+        return !segments_.isEmpty();
+    }
+
+    int segmentCount() const
+    {
+        return segments_.size();
+    }
+
+    QString segmentPath(int segment) const
+    {
+        return segments_.at(segment)->file.fileName();
+    }
+
+    // The segment index in the file header, the number in the file name
+    int segmentIndex(int segment) const
+    {
+        return static_cast<int>(segments_.at(segment)->header.segmentIndex);
+    }
+
+    quint32 blockSize(int segment) const
+    {
+        return segments_.at(segment)->blockSize;
+    }
+
+    quint32 blockCount(int segment) const
+    {
+        const Segment* s = segments_.at(segment);
+        return static_cast<quint32>((s->size + s->blockSize - 1) / s->blockSize);
+    }
+
+    // True if the segment was read without its index file, e.g. because it was still being recorded
+    bool isScanned(int segment) const
+    {
+        return segments_.at(segment)->scanned;
+    }
+
+    // Mapped bytes of all segments
+    qint64 size() const
+    {
+        qint64 size = 0;
+        for (const Segment* segment : segments_)
+        {
+            size += segment->size;
+        }
+        return size;
+    }
+
+    // The start of the recording, monotonic clock in ns
+    qint64 firstNs() const
+    {
+        return segments_.isEmpty() ? 0 : segments_.first()->header.startNs;
+    }
+
+    // The receive time of the last message
+    qint64 lastNs() const
+    {
+        return lastNs_;
+    }
+
+    // Wall clock time of a receive time, in ms since epoch
+    qint64 toUtcMs(qint64 ns) const
+    {
+        const CaptureFormat::FileHeader& header = segments_.first()->header;
+        return header.startUtcMs + (ns - header.startNs) / 1000000;
+    }
+
+    // Receive time of a wall clock time in ms since epoch
+    qint64 fromUtcMs(qint64 utcMs) const
+    {
+        const CaptureFormat::FileHeader& header = segments_.first()->header;
+        return header.startNs + (utcMs - header.startUtcMs) * 1000000;
+    }
+
+    // All topics of the capture, in the order they were first recorded
+    QList<QByteArray> topics() const
+    {
+        QList<QByteArray> topics;
+        QHash<QByteArray, bool> seen;
+        for (const Segment* segment : segments_)
+        {
+            QList<quint32> ids = segment->names.keys();
+            std::sort(ids.begin(), ids.end());
+            for (quint32 id : ids)
+            {
+                const QByteArray& name = segment->names.value(id);
+                if (!seen.contains(name))
+                {
+                    seen.insert(name, true);
+                    topics.append(name);
+                }
+            }
+        }
+        return topics;
+    }
+
+    // The first message of the capture, or of a topic
+    CaptureCursor first(const QByteArray& topic = QByteArray()) const
+    {
+        return seek(std::numeric_limits<qint64>::min(), topic);
+    }
+
+    /**
+     * @brief Finds the first message received at or after a time.
+     * @param ns The receive time, monotonic clock in ns.
+     * @param topic Only messages of this topic are visited, all if empty.
+     * @return The cursor, invalid if no message matches.
+     */
+    CaptureCursor seek(qint64 ns, const QByteArray& topic = QByteArray()) const
+    {
+        CaptureCursor cursor;
+        cursor.capture_ = this;
+        cursor.topic_ = topic;
+        if (segments_.isEmpty())
+        {
+            return cursor;
+        }
+
+        // Segments are started in time order, the one that was being written at ns holds the message
+        auto segment = std::upper_bound(segments_.cbegin(), segments_.cend(), ns, [](qint64 t, const Segment* s) {
+            return t < s->header.startNs;
+        });
+        cursor.segment_ = segment == segments_.cbegin() ? 0 : static_cast<int>(segment - segments_.cbegin()) - 1;
+
+        // The last block that starts with a message before ns, the messages in front of ns are walked over
+        const QVector<TimeEntry>& times = segments_.at(cursor.segment_)->times;
+        auto entry = std::lower_bound(times.cbegin(), times.cend(), ns, [](const TimeEntry& e, qint64 t) {
+            return e.ns < t;
+        });
+        cursor.offset_ = entry == times.cbegin() ? segments_.at(cursor.segment_)->begin : (entry - 1)->offset;
+        settle(&cursor, ns);
+        return cursor;
+    }
+
+    // The message at a position a cursor had, or the first one after it
+    CaptureCursor at(int segment, quint64 offset) const
+    {
+        CaptureCursor cursor;
+        cursor.capture_ = this;
+        cursor.segment_ = segment;
+        cursor.offset_ = offset;
+        settle(&cursor, std::numeric_limits<qint64>::min());
+        return cursor;
+    }
+
+    /**
+     * @brief Finds the first message that starts in a block, the messages of the block follow it.
+     * @param segment The segment.
+     * @param block The block number, the offset divided by the block size of the segment.
+     * @return The cursor, invalid if no message starts in the block.
+     */
+    CaptureCursor block(int segment, quint32 block) const
+    {
+        const Segment* s = segments_.at(segment);
+        quint64 start = quint64(block) * s->blockSize;
+        auto entry = std::lower_bound(s->times.cbegin(), s->times.cend(), start, [](const TimeEntry& e, quint64 offset) {
+            return e.offset < offset;
+        });
+        if (entry == s->times.cend() || entry->offset >= start + s->blockSize)
+        {
+            CaptureCursor cursor;
+            cursor.capture_ = this;
+            return cursor;
+        }
+        return at(segment, entry->offset);
+    }
+
+private:
+    friend class CaptureCursor;
+
+    struct TimeEntry
+    {
+        qint64 ns;
+        quint64 offset;
+
+        TimeEntry() : ns(0), offset(0) {}
+        TimeEntry(qint64 n, quint64 o) : ns(n), offset(o) {}
+    };
+
+    struct Segment
+    {
+        QFile file;
+        const char* data;
+        quint64 size;
+        quint64 begin;                              // Offset of the first record
+        CaptureFormat::FileHeader header;
+        quint32 blockSize;
+        bool scanned;                               // The index was built by scanning the segment
+        QVector<TimeEntry> times;
+        QHash<quint32, QVector<quint64>> topics;    // Topic id to the offsets of its first message in each block
+        QHash<quint32, QByteArray> names;
+        QHash<QByteArray, quint32> ids;
+
+        explicit Segment(const QString& path)
+            : file(path), data(0), size(0), begin(0), blockSize(0), scanned(false)
+        {
+        }
+    };
+
+    Segment* openSegment(const QString& path, QString* error)
+    {
+        Segment* segment = new Segment(path);
+        if (!segment->file.open(QIODevice::ReadOnly))
+        {
+            *error = QString("Could not open %1: %2").arg(path, segment->file.errorString());
+            delete segment;
+            return 0;
+        }
+
+        segment->size = segment->file.size();
+        uchar* data = segment->size >= CaptureFormat::FileHeaderSize ? segment->file.map(0, segment->size) : 0;
+        int headerSize = data ? CaptureFormat::readFileHeader(reinterpret_cast<const char*>(data), &segment->header) : 0;
+        if (headerSize == 0 || segment->header.version > CaptureFormat::Version || static_cast<quint64>(headerSize) > segment->size)
+        {
+            *error = data ? QString("%1 is not a supported capture file").arg(path)
+                          : QString("Could not map %1: %2").arg(path, segment->file.errorString());
+            if (data)
+            {
+                segment->file.unmap(data);
+            }
+            delete segment;
+            return 0;
+        }
+
+        segment->data = reinterpret_cast<const char*>(data);
+        segment->begin = headerSize;
+        return segment;
+    }
+
+    // Loads the index file of a segment, a missing or damaged one is rebuilt by scanning the segment
+    void loadIndex(Segment* segment, const QString& path)
+    {
+        QFile file(path);
+        QByteArray data = !path.isEmpty() && file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+        if (!parseIndex(segment, data))
+        {
+            scan(segment);
+        }
+
+        for (auto it = segment->names.cbegin(); it != segment->names.cend(); ++it)
+        {
+            segment->ids.insert(it.value(), it.key());
+        }
+    }
+
+    static bool parseIndex(Segment* segment, const QByteArray& data)
+    {
+        CaptureFormat::IndexHeader header;
+        if (data.size() < CaptureFormat::IndexHeaderSize || !CaptureFormat::readIndexHeader(data.constData(), &header)
+            || header.segmentIndex != segment->header.segmentIndex || header.blockSize == 0
+            || CaptureFormat::IndexHeaderSize + (quint64(header.timeCount) + header.topicCount) * CaptureFormat::IndexEntrySize > quint64(data.size()))
+        {
+            return false;
+        }
+
+        segment->blockSize = header.blockSize;
+        const char* p = data.constData() + CaptureFormat::IndexHeaderSize;
+        segment->times.reserve(header.timeCount);
+        for (quint32 i = 0; i < header.timeCount; ++i, p += CaptureFormat::IndexEntrySize)
+        {
+            TimeEntry entry;
+            CaptureFormat::readIndexEntry(p, &entry.ns, &entry.offset);
+            segment->times.append(entry);
+        }
+        for (quint32 i = 0; i < header.topicCount; ++i, p += CaptureFormat::IndexEntrySize)
+        {
+            qint64 key;
+            quint64 offset;
+            CaptureFormat::readIndexEntry(p, &key, &offset);
+            segment->topics[static_cast<quint32>(key)].append(offset);
+        }
+
+        const char* end = data.constData() + data.size();
+        for (quint32 i = 0; i < header.nameCount; ++i)
+        {
+            if (end - p < 8)
+            {
+                return false;
+            }
+            quint32 id = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(p));
+            quint32 size = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(p + 4));
+            if (quint64(end - p) < 8 + quint64(size))
+            {
+                return false;
+            }
+            segment->names.insert(id, QByteArray(p + 8, static_cast<int>(size)));
+            p += qMin<quint64>(end - p, 8 + CaptureFormat::align(size));
+        }
+        return true;
+    }
+
+    // Builds the sparse index the writer would have written, up to the first damaged record
+    static void scan(Segment* segment)
+    {
+        segment->blockSize = segment->header.blockSize > 0 ? segment->header.blockSize : ScanBlockSize;
+        segment->scanned = true;
+        segment->times.clear();
+        segment->topics.clear();
+        segment->names.clear();
+
+        qint64 timeBlock = -1;
+        QHash<quint32, qint64> topicBlocks;
+        quint64 offset = segment->begin;
+        CaptureFormat::RecordHeader header;
+        while (const char* record = recordAt(*segment, offset, &header))
+        {
+            qint64 block = static_cast<qint64>(offset / segment->blockSize);
+            if (header.type == CaptureFormat::REC_MESSAGE)
+            {
+                if (block != timeBlock)
+                {
+                    segment->times.append(TimeEntry(header.receiveNs, offset));
+                    timeBlock = block;
+                }
+                auto it = topicBlocks.find(header.topicId);
+                if (it == topicBlocks.end() || it.value() != block)
+                {
+                    segment->topics[header.topicId].append(offset);
+                    topicBlocks.insert(header.topicId, block);
+                }
+            }
+            else if (header.type == CaptureFormat::REC_TOPIC && header.frameCount > 0)
+            {
+                quint32 size = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(record + CaptureFormat::RecordHeaderSize));
+                quint64 data = CaptureFormat::RecordHeaderSize + quint64(header.frameCount) * 4;
+                if (data + size <= header.size)
+                {
+                    segment->names.insert(header.topicId, QByteArray(record + data, static_cast<int>(size)));
+                }
+            }
+            offset += header.size;
+        }
+    }
+
+    // The record at an offset, 0 at the end of the segment or if the record is damaged
+    static const char* recordAt(const Segment& segment, quint64 offset, CaptureFormat::RecordHeader* header)
+    {
+        if (offset + CaptureFormat::RecordHeaderSize > segment.size)
+        {
+            return 0;
+        }
+        const char* record = segment.data + offset;
+        CaptureFormat::readRecordHeader(record, header);
+        return CaptureFormat::isValidRecord(*header, segment.size - offset) ? record : 0;
+    }
+
+    // Moves the cursor to the first message at or after its offset that passes its filter and is not older than ns
+    void settle(CaptureCursor* cursor, qint64 ns) const
+    {
+        for (; cursor->segment_ < segments_.size(); nextSegment(cursor))
+        {
+            const Segment& segment = *segments_.at(cursor->segment_);
+            const QVector<quint64>* blocks = 0;
+            if (!cursor->topic_.isEmpty())
+            {
+                auto id = segment.ids.find(cursor->topic_);
+                auto offsets = id == segment.ids.end() ? segment.topics.end() : segment.topics.find(id.value());
+                if (offsets == segment.topics.end())
+                {
+                    continue;
+                }
+                cursor->topicId_ = id.value();
+                blocks = &offsets.value();
+            }
+
+            quint64 offset = cursor->offset_;
+            quint64 blockEnd = (offset / segment.blockSize + 1) * segment.blockSize;
+            CaptureFormat::RecordHeader header;
+            for (;;)
+            {
+                // The rest of the messages of a topic in a block follow its first one, other blocks are skipped
+                if (blocks && offset >= blockEnd)
+                {
+                    auto next = std::lower_bound(blocks->cbegin(), blocks->cend(), blockEnd);
+                    if (next == blocks->cend())
+                    {
+                        break;
+                    }
+                    offset = *next;
+                    blockEnd = (offset / segment.blockSize + 1) * segment.blockSize;
+                }
+
+                const char* record = recordAt(segment, offset, &header);
+                if (!record)
+                {
+                    break;
+                }
+                if (header.type == CaptureFormat::REC_MESSAGE && header.receiveNs >= ns && (!blocks || header.topicId == cursor->topicId_))
+                {
+                    cursor->record_ = record;
+                    cursor->header_ = header;
+                    cursor->offset_ = offset;
+                    prefetch(segment, cursor);
+                    return;
+                }
+                offset += header.size;
+            }
+        }
+        cursor->record_ = 0;
+    }
+
+    void nextSegment(CaptureCursor* cursor) const
+    {
+        if (++cursor->segment_ < segments_.size())
+        {
+            cursor->offset_ = segments_.at(cursor->segment_)->begin;
+            cursor->block_ = -1;
+        }
+    }
+
+    // Asks the kernel to read the block after the cursor's while its block is walked
+    static void prefetch(const Segment& segment, CaptureCursor* cursor)
+    {
+        qint64 block = static_cast<qint64>(cursor->offset_ / segment.blockSize);
+        if (block == cursor->block_)
+        {
+            return;
+        }
+        cursor->block_ = block;
+#ifdef Q_OS_UNIX
+        // The mapping starts on a page boundary and block sizes are multiples of the page size
+        quint64 start = (block + 1) * segment.blockSize;
+        if (start < segment.size && segment.blockSize % 4096 == 0)
+        {
+            madvise(const_cast<char*>(segment.data + start), qMin<quint64>(segment.blockSize, segment.size - start), MADV_WILLNEED);
+        }
+#endif
+    }
+
+    QVector<Segment*> segments_;
+    qint64 lastNs_;
+};
+
+inline bool CaptureCursor::next()
+{
+    if (!record_)
+    {
+        return false;
+    }
+
+    offset_ += header_.size;
+    capture_->settle(this, std::numeric_limits<qint64>::min());
+    return record_ != 0;
+}
+
+inline QByteArray CaptureCursor::topic() const
+{
+    return record_ ? capture_->segments_.at(segment_)->names.value(header_.topicId) : QByteArray();
+}
+
+}
+
+}
+
+#endif // NZMQT_MAPPEDCAPTURE_H
@@ -0,0 +1,182 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_MAPPEDPAYLOAD_H
+#define NZMQT_MAPPEDPAYLOAD_H
+
+#include "nzmqt/nzmqt.hpp"
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Mapped Payload:
+Publishes the contents of a file as the payload frame without reading it into memory. The file is
+mapped once and every message points into the mapping: either the whole file or, if a slice size is
+given, one slice after the other, starting over at the end. Frames are handed to ZeroMQ without a
+copy, which costs ZeroMQ a small allocation per message for its reference count: every message holds
+a reference on the mapping and ZeroMQ drops it once the frame is on the wire, so the file stays
+mapped while frames are queued even if another file is opened meanwhile. Pages are read by the kernel on demand and can be dropped again
+under memory pressure, so a 100 MB frame does not add 100 MB to the resident size of the tool.
+*/
+class MappedPayload
+{
+    Q_DISABLE_COPY(MappedPayload)
+
+public:
+    static const int PreviewSize = 64;
+
+    MappedPayload()
+        : mapping_(0), sliceSize_(0), next_(0)
+    {
+    }
+
+    ~MappedPayload()
+    {
+        close();
+    }
+
+    /**
+     * @brief Maps a file for publishing.
+     * @param path The file to publish.
+     * @param sliceSize The size of the frames the file is split into, 0 sends the whole file in every message.
+     * @param error Receives a description of the problem if the file cannot be mapped.
+     * @return False if the file cannot be mapped, the previous file is closed in any case.
+     */
+    bool open(const QString& path, qint64 sliceSize, QString* error)
+    {
+        close();
+
+        Mapping* mapping = new Mapping(path);
+        if (!mapping->file.open(QIODevice::ReadOnly))
+        {
+            *error = QString("Could not open %1: %2").arg(path, mapping->file.errorString());
+            release(mapping);
+            return false;
+        }
+
+        // An empty file cannot be mapped, and a frame without bytes is better typed into the message field
+        mapping->size = mapping->file.size();
+        mapping->data = mapping->size > 0 ? mapping->file.map(0, mapping->size) : 0;
+        if (mapping->data == 0)
+        {
+            *error = QString("Could not map %1: %2").arg(path, mapping->size > 0 ? mapping->file.errorString() : QString("The file is empty"));
+            release(mapping);
+            return false;
+        }
+
+        mapping_ = mapping;
+        sliceSize_ = sliceSize > 0 && sliceSize < mapping->size ? sliceSize : mapping->size;
+        next_ = 0;
+        return true;
+    }
+
+    void close()
+    {
+        if (mapping_)
+        {
+            release(mapping_);
+            mapping_ = 0;
+        }
+    }
+
+    bool isOpen() const { return mapping_ != 0; }
+
+    QString fileName() const { return mapping_ ? mapping_->file.fileName() : QString(); }
+
+    qint64 fileSize() const { return mapping_ ? mapping_->size : 0; }
+
+    qint64 sliceSize() const { return sliceSize_; }
+
+    qint64 sliceCount() const { return mapping_ ? (mapping_->size + sliceSize_ - 1) / sliceSize_ : 0; }
+
+    // The size of the frame the next call to send() publishes
+    qint64 nextSize() const
+    {
+        return mapping_ ? qMin(sliceSize_, mapping_->size - next_) : 0;
+    }
+
+    /**
+     * @brief Sends the next slice as part of a message and moves on to the following one.
+     * @param socket The socket to send on.
+     * @param flags The send flags, SND_MORE if further frames follow.
+     * @return False if the socket did not accept the frame.
+     */
+    bool send(ZMQSocket* socket, ZMQSocket::SendFlags flags)
+    {
+        qint64 offset = next_;
+        qint64 size = nextSize();
+        next_ = offset + size < mapping_->size ? offset + size : 0;
+
+        // The message releases its reference through free() even if sending fails
+        mapping_->refs.ref();
+        ZMQMessage msg(mapping_->data + offset, static_cast<size_t>(size), &MappedPayload::free, mapping_);
+        return socket->sendMessage(msg, flags);
+    }
+
+    // A copy of the first bytes of the next slice, shown instead of the frame that may be huge
+    QByteArray preview() const
+    {
+        if (!mapping_)
+        {
+            return QByteArray();
+        }
+        return QByteArray(reinterpret_cast<const char*>(mapping_->data + next_), static_cast<int>(qMin<qint64>(PreviewSize, nextSize())));
+    }
+
+private:
+    struct Mapping
+    {
+        QAtomicInt refs;
+        QFile file;
+        uchar* data;
+        qint64 size;
+
+        explicit Mapping(const QString& path)
+            : refs(1), file(path), data(0), size(0)
+        {
+        }
+
+        ~Mapping()
+        {
+            if (data)
+            {
+                file.unmap(data);
+            }
+        }
+    };
+
+    static void release(Mapping* mapping)
+    {
+        if (!mapping->refs.deref())
+        {
+            delete mapping;
+        }
+    }
+
+    // Called by ZeroMQ, possibly on its I/O thread
+    static void free(void* data, void* hint)
+    {
+        Q_UNUSED(data);
+        release(static_cast<Mapping*>(hint));
+    }
+
+    Mapping* mapping_;
+    qint64 sliceSize_;
+    qint64 next_;           // Offset of the next slice
+};
+
+}
+
+}
+
+#endif // NZMQT_MAPPEDPAYLOAD_H
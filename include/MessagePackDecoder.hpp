@@ -0,0 +1,301 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_MESSAGEPACKDECODER_H
+#define NZMQT_MESSAGEPACKDECODER_H
+
+#include "HexCodec.hpp"
+#include "PayloadDecoder.hpp"
+
+#include <QtEndian>
+
+#include <cstring>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+MessagePack Decoder:
+Shows MessagePack as indented JSON like text: maps and arrays as in JSON, binaries as hex and
+extension types as ext(type, hex). Several values in a row, a stream, are shown one after the other.
+Every length is checked against the remaining bytes before anything is read, so a damaged payload
+fails with the offset of the problem instead of reading past its end.
+*/
+class MessagePackDecoder : public PayloadDecoder
+{
+public:
+    static const int MaxDepth = 64;
+
+    QString name() const override
+    {
+        return "MessagePack";
+    }
+
+    bool decode(const QByteArray& payload, QString* text, QString* error) const override
+    {
+        Reader reader;
+        reader.begin = reinterpret_cast<const uchar*>(payload.constData());
+        reader.p = reader.begin;
+        reader.end = reader.begin + payload.size();
+
+        text->clear();
+        if (payload.isEmpty())
+        {
+            *error = "Empty payload";
+            return false;
+        }
+        while (reader.p < reader.end && text->size() < MaxTextSize)
+        {
+            if (!text->isEmpty())
+            {
+                text->append('\n');
+            }
+            if (!value(&reader, 0, text))
+            {
+                *error = QString("%1 at offset %2").arg(reader.error).arg(reader.p - reader.begin);
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    struct Reader
+    {
+        const uchar* begin;
+        const uchar* p;
+        const uchar* end;
+        const char* error;
+
+        bool has(quint64 size)
+        {
+            if (static_cast<quint64>(end - p) < size)
+            {
+                error = "Truncated value";
+                return false;
+            }
+            return true;
+        }
+
+        // A big endian unsigned integer of 1, 2, 4 or 8 bytes
+        bool unsignedInt(int size, quint64* value)
+        {
+            if (!has(size))
+            {
+                return false;
+            }
+            switch (size)
+            {
+            case 1: *value = *p; break;
+            case 2: *value = qFromBigEndian<quint16>(p); break;
+            case 4: *value = qFromBigEndian<quint32>(p); break;
+            default: *value = qFromBigEndian<quint64>(p); break;
+            }
+            p += size;
+            return true;
+        }
+    };
+
+    static void indent(QString* text, int depth)
+    {
+        text->append(QString(depth * 2, ' '));
+    }
+
+    static bool value(Reader* reader, int depth, QString* text)
+    {
+        if (depth > MaxDepth)
+        {
+            reader->error = "Nested too deep";
+            return false;
+        }
+        if (!reader->has(1))
+        {
+            return false;
+        }
+
+        const uchar type = *reader->p++;
+        quint64 size = 0;
+        if (type <= 0x7F)
+        {
+            text->append(QString::number(type));
+            return true;
+        }
+        if (type >= 0xE0)
+        {
+            text->append(QString::number(static_cast<qint8>(type)));
+            return true;
+        }
+        if (type >= 0x80 && type <= 0x8F)
+        {
+            return container(reader, type & 0x0F, true, depth, text);
+        }
+        if (type >= 0x90 && type <= 0x9F)
+        {
+            return container(reader, type & 0x0F, false, depth, text);
+        }
+        if (type >= 0xA0 && type <= 0xBF)
+        {
+            return string(reader, type & 0x1F, text);
+        }
+
+        switch (type)
+        {
+        case 0xC0:
+            text->append("null");
+            return true;
+        case 0xC2:
+            text->append("false");
+            return true;
+        case 0xC3:
+            text->append("true");
+            return true;
+        case 0xC4: case 0xC5: case 0xC6:
+            if (!reader->unsignedInt(1 << (type - 0xC4), &size) || !reader->has(size))
+            {
+                return false;
+            }
+            text->append(QString("bin(%1)").arg(hex(reader, size)));
+            return true;
+        case 0xC7: case 0xC8: case 0xC9:
+            return reader->unsignedInt(1 << (type - 0xC7), &size) && extension(reader, size, text);
+        case 0xCA:
+        {
+            quint64 bits;
+            if (!reader->unsignedInt(4, &bits))
+            {
+                return false;
+            }
+            quint32 bits32 = static_cast<quint32>(bits);
+            float f;
+            memcpy(&f, &bits32, sizeof(f));
+            text->append(QString::number(f, 'g', 9));
+            return true;
+        }
+        case 0xCB:
+        {
+            quint64 bits;
+            if (!reader->unsignedInt(8, &bits))
+            {
+                return false;
+            }
+            double d;
+            memcpy(&d, &bits, sizeof(d));
+            text->append(QString::number(d, 'g', 17));
+            return true;
+        }
+        case 0xCC: case 0xCD: case 0xCE: case 0xCF:
+            if (!reader->unsignedInt(1 << (type - 0xCC), &size))
+            {
+                return false;
+            }
+            text->append(QString::number(size));
+            return true;
+        case 0xD0: case 0xD1: case 0xD2: case 0xD3:
+        {
+            int bytes = 1 << (type - 0xD0);
+            if (!reader->unsignedInt(bytes, &size))
+            {
+                return false;
+            }
+            // Sign extension from the width of the value
+            qint64 signedValue = bytes == 8 ? static_cast<qint64>(size) : static_cast<qint64>(size << (64 - bytes * 8)) >> (64 - bytes * 8);
+            text->append(QString::number(signedValue));
+            return true;
+        }
+        case 0xD4: case 0xD5: case 0xD6: case 0xD7: case 0xD8:
+            return extension(reader, 1 << (type - 0xD4), text);
+        case 0xD9: case 0xDA: case 0xDB:
+            return reader->unsignedInt(1 << (type - 0xD9), &size) && string(reader, size, text);
+        case 0xDC: case 0xDD:
+            return reader->unsignedInt(2 << (type - 0xDC), &size) && container(reader, size, false, depth, text);
+        case 0xDE: case 0xDF:
+            return reader->unsignedInt(2 << (type - 0xDE), &size) && container(reader, size, true, depth, text);
+        default:
+            reader->error = "Unused type byte 0xc1";
+            --reader->p;
+            return false;
+        }
+    }
+
+    // The next size bytes as hex, the caller checked that they are there
+    static QString hex(Reader* reader, quint64 size)
+    {
+        QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(reader->p), static_cast<int>(size));
+        reader->p += size;
+        return QString::fromLatin1(HexCodec::toSpacedHex(bytes)).trimmed();
+    }
+
+    static bool string(Reader* reader, quint64 size, QString* text)
+    {
+        if (!reader->has(size))
+        {
+            return false;
+        }
+        text->append(quote(QByteArray::fromRawData(reinterpret_cast<const char*>(reader->p), static_cast<int>(size))));
+        reader->p += size;
+        return true;
+    }
+
+    static bool extension(Reader* reader, quint64 size, QString* text)
+    {
+        if (!reader->has(size + 1))
+        {
+            return false;
+        }
+        qint8 type = static_cast<qint8>(*reader->p++);
+        text->append(QString("ext(%1, %2)").arg(type).arg(hex(reader, size)));
+        return true;
+    }
+
+    static bool container(Reader* reader, quint64 count, bool map, int depth, QString* text)
+    {
+        // Every element takes at least one byte, a larger count is damage
+        if (!reader->has(count * (map ? 2 : 1)))
+        {
+            return false;
+        }
+        if (count == 0)
+        {
+            text->append(map ? "{}" : "[]");
+            return true;
+        }
+
+        text->append(map ? "{\n" : "[\n");
+        for (quint64 i = 0; i < count; ++i)
+        {
+            if (text->size() >= MaxTextSize)
+            {
+                reader->p = reader->end;
+                text->append("...");
+                return true;
+            }
+            indent(text, depth + 1);
+            if (map)
+            {
+                if (!value(reader, depth + 1, text))
+                {
+                    return false;
+                }
+                text->append(": ");
+            }
+            if (!value(reader, depth + 1, text))
+            {
+                return false;
+            }
+            text->append(i + 1 < count ? ",\n" : "\n");
+        }
+        indent(text, depth);
+        text->append(map ? '}' : ']');
+        return true;
+    }
+};
+
+}
+
+}
+
+#endif // NZMQT_MESSAGEPACKDECODER_H
@@ -0,0 +1,174 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_MESSAGESTAMP_H
+#define NZMQT_MESSAGESTAMP_H
+
+#include <QByteArray>
+#include <QtEndian>
+#include <QtGlobal>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Message Stamp:
+An optional binary frame the Publisher inserts between the topic frame and the payload frames.
+It allows the Subscriber to measure loss, reordering and latency without touching the payload.
+Wire layout (little endian, 48 bytes):
+    offset  0  quint32  magic           'ZMQS'
+    offset  4  quint8   version
+    offset  5  quint8   flags           FLAG_SEEDED if the payload frame is a SeededPayload
+    offset  6  quint16  header size     size of this frame, newer versions may append fields
+    offset  8  quint32  publisher id    random per Publisher instance
+    offset 12  quint32  target rate     msg/s the load profile asked for when the message was due, 0 if unknown
+    offset 16  quint64  sequence        per topic, starts at 0
+    offset 24  qint64   send time       monotonic clock in ns, taken right before sending
+    offset 32  qint64   intended time   monotonic clock in ns, when the scheduler wanted it sent
+    offset 40  quint64  payload size    size of a seeded payload frame, 0 otherwise (version 2)
+Version 1 stamps end after the intended time and are still accepted.
+*/
+class MessageStamp
+{
+public:
+    static const quint32 Magic = 0x53514D5A; // "ZMQS" in memory order
+    static const quint8 Version = 2;
+    static const int Size = 48;
+    static const int MinSize = 40;      // Size of a version 1 stamp
+
+    enum Flag
+    {
+        FLAG_SEEDED = 0x01
+    };
+
+    enum Offset
+    {
+        OFF_MAGIC = 0,
+        OFF_VERSION = 4,
+        OFF_FLAGS = 5,
+        OFF_HEADER_SIZE = 6,
+        OFF_PUBLISHER_ID = 8,
+        OFF_TARGET_RATE = 12,
+        OFF_SEQUENCE = 16,
+        OFF_SEND_TIME = 24,
+        OFF_INTENDED_TIME = 32,
+        OFF_PAYLOAD_SIZE = 40
+    };
+
+    /**
+     * @brief Allocates a stamp frame with the constant fields filled in.
+     * @param publisherId The id of the publisher that owns the frame.
+     * @return A frame of Size bytes, the per message fields are set with patch().
+     */
+    static QByteArray makeFrame(quint32 publisherId)
+    {
+        QByteArray frame(Size, '\0');
+        uchar* p = reinterpret_cast<uchar*>(frame.data());
+        qToLittleEndian<quint32>(Magic, p + OFF_MAGIC);
+        p[OFF_VERSION] = Version;
+        p[OFF_FLAGS] = 0;
+        qToLittleEndian<quint16>(Size, p + OFF_HEADER_SIZE);
+        qToLittleEndian<quint32>(publisherId, p + OFF_PUBLISHER_ID);
+        return frame;
+    }
+
+    /**
+     * @brief Writes the per message fields into a frame created by makeFrame().
+     * @param frame Pointer to the first byte of the stamp frame.
+     * @param sequence The per topic sequence number.
+     * @param sendTimeNs The monotonic send time in nanoseconds.
+     * @param intendedTimeNs The monotonic time the scheduler intended the message to be sent.
+     * @return None
+     */
+    static void patch(char* frame, quint64 sequence, qint64 sendTimeNs, qint64 intendedTimeNs)
+    {
+        uchar* p = reinterpret_cast<uchar*>(frame);
+        qToLittleEndian<quint64>(sequence, p + OFF_SEQUENCE);
+        qToLittleEndian<qint64>(sendTimeNs, p + OFF_SEND_TIME);
+        qToLittleEndian<qint64>(intendedTimeNs, p + OFF_INTENDED_TIME);
+    }
+
+    /**
+     * @brief Writes the target rate into a frame created by makeFrame().
+     * @param frame Pointer to the first byte of the stamp frame.
+     * @param targetRate The aggregate rate of all publisher workers in messages per second.
+     * @return None
+     */
+    static void patchTargetRate(char* frame, quint32 targetRate)
+    {
+        qToLittleEndian<quint32>(targetRate, reinterpret_cast<uchar*>(frame) + OFF_TARGET_RATE);
+    }
+
+    /**
+     * @brief Marks the payload frame of the messages as a SeededPayload.
+     * @param frame Pointer to the first byte of the stamp frame.
+     * @param payloadSize The size of the seeded payload frame, 0 for a payload that is not seeded.
+     * @return None
+     */
+    static void patchSeeded(char* frame, quint64 payloadSize)
+    {
+        uchar* p = reinterpret_cast<uchar*>(frame);
+        p[OFF_FLAGS] = payloadSize != 0 ? FLAG_SEEDED : 0;
+        qToLittleEndian<quint64>(payloadSize, p + OFF_PAYLOAD_SIZE);
+    }
+
+    // Read only view on a received stamp frame. It never copies the frame, so the
+    // QByteArray it was parsed from must outlive the view.
+    class View
+    {
+    public:
+        View() : data_(0), size_(0) {}
+
+        bool isValid() const { return data_ != 0; }
+
+        quint8 version() const { return static_cast<quint8>(data_[OFF_VERSION]); }
+        quint8 flags() const { return static_cast<quint8>(data_[OFF_FLAGS]); }
+        quint32 publisherId() const { return qFromLittleEndian<quint32>(data_ + OFF_PUBLISHER_ID); }
+        quint32 targetRate() const { return qFromLittleEndian<quint32>(data_ + OFF_TARGET_RATE); }
+        quint64 sequence() const { return qFromLittleEndian<quint64>(data_ + OFF_SEQUENCE); }
+        qint64 sendTimeNs() const { return qFromLittleEndian<qint64>(data_ + OFF_SEND_TIME); }
+        qint64 intendedTimeNs() const { return qFromLittleEndian<qint64>(data_ + OFF_INTENDED_TIME); }
+        bool isSeeded() const { return (data_[OFF_FLAGS] & FLAG_SEEDED) != 0 && size_ >= Size; }
+        quint64 payloadSize() const { return size_ >= Size ? qFromLittleEndian<quint64>(data_ + OFF_PAYLOAD_SIZE) : 0; }
+
+    private:
+        friend class MessageStamp;
+        const uchar* data_;
+        int size_;
+    };
+
+    /**
+     * @brief Checks whether a frame is a stamp frame and maps a view onto it.
+     * @param frame The frame to be checked.
+     * @param view Receives the view if the frame is a stamp frame.
+     * @return True if the frame is a stamp frame, false otherwise.
+     */
+    static bool parse(const QByteArray& frame, View* view)
+    {
+        if (frame.size() < MinSize)
+        {
+            return false;
+        }
+
+        const uchar* p = reinterpret_cast<const uchar*>(frame.constData());
+        if (qFromLittleEndian<quint32>(p + OFF_MAGIC) != Magic
+            || qFromLittleEndian<quint16>(p + OFF_HEADER_SIZE) != frame.size())
+        {
+            return false;
+        }
+
+        view->data_ = p;
+        view->size_ = frame.size();
+        return true;
+    }
+};
+
+}
+
+}
+
+#endif // NZMQT_MESSAGESTAMP_H
@@ -0,0 +1,391 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_MESSAGETEMPLATE_H
+#define NZMQT_MESSAGETEMPLATE_H
+
+#include "FastRandom.hpp"
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include <cstring>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Message Template:
+A publish message with fields that change from message to message, e.g.
+    {"seq":${seq},"ts":${ts},"id":"${rand:8}"}
+Fields:
+    ${seq}          message counter of the publisher, starts at 0
+    ${ts}           wall clock time the message is due, in milliseconds since the epoch, ${ts:us} and ${ts:ns} for finer units
+    ${mono}         monotonic time the message is due in nanoseconds, the intended time of the message stamp
+    ${rand:N}       N random hex digits, 1 to 64
+    ${int:A:B}      random integer in [A, B]
+    ${topic}        the topic of the message
+    ${pub}          the publisher id as 8 hex digits
+$$ stands for a single $.
+The template is compiled once into a list of ops: literal text is copied with memcpy, every field has
+its own writer. Rendering writes into a buffer that is allocated at compile time for the longest
+possible output, so rendering neither formats strings nor allocates. Sending the rendered message
+still copies it into a ZeroMQ message, which allocates for messages longer than 33 bytes.
+*/
+class MessageTemplate
+{
+public:
+    MessageTemplate()
+        : maxSize_(0)
+    {
+    }
+
+    // Text without a field is published as it is, it does not need to be compiled
+    static bool isTemplate(const QByteArray& text)
+    {
+        return text.contains("${");
+    }
+
+    /**
+     * @brief Compiles a template, see the description of the class for the syntax.
+     * @param text The template.
+     * @param maxTopicSize The size of the longest topic that ${topic} may be replaced with.
+     * @param error Receives a description of the problem if compiling fails.
+     * @return False if the template is malformed, the template is left unchanged then.
+     */
+    bool compile(const QByteArray& text, int maxTopicSize, QString* error)
+    {
+        QVector<Op> ops;
+        QByteArray literals;
+        int maxSize = 0;
+
+        int i = 0;
+        while (i < text.size())
+        {
+            int dollar = text.indexOf('$', i);
+            int literalEnd = dollar < 0 ? text.size() : dollar;
+            if (dollar >= 0 && dollar + 1 < text.size() && text.at(dollar + 1) == '$')
+            {
+                // "$$" keeps one "$" in the literal
+                ++literalEnd;
+            }
+            if (literalEnd > i)
+            {
+                appendLiteral(&ops, &literals, text.mid(i, literalEnd - i));
+                maxSize += literalEnd - i;
+            }
+            if (dollar < 0)
+            {
+                break;
+            }
+
+            if (dollar + 1 < text.size() && text.at(dollar + 1) == '$')
+            {
+                i = dollar + 2;
+                continue;
+            }
+            if (dollar + 1 >= text.size() || text.at(dollar + 1) != '{')
+            {
+                // A lone "$" is literal text
+                appendLiteral(&ops, &literals, QByteArray("$"));
+                maxSize += 1;
+                i = dollar + 1;
+                continue;
+            }
+
+            int close = text.indexOf('}', dollar + 2);
+            if (close < 0)
+            {
+                *error = QString("Unterminated field at offset %1 of the message template").arg(dollar);
+                return false;
+            }
+
+            Op op;
+            int width = 0;
+            if (!parseField(text.mid(dollar + 2, close - dollar - 2), maxTopicSize, &op, &width))
+            {
+                *error = QString("Unknown field \"%1\" in the message template, expected seq, ts, mono, rand:N, int:A:B, topic or pub")
+                    .arg(QString::fromUtf8(text.mid(dollar, close - dollar + 1)));
+                return false;
+            }
+            ops.append(op);
+            maxSize += width;
+            i = close + 1;
+        }
+
+        ops_ = ops;
+        literals_ = literals;
+        maxSize_ = maxSize;
+        buffer_.fill('\0', qMax(1, maxSize));
+        return true;
+    }
+
+    bool isEmpty() const { return ops_.isEmpty(); }
+
+    int maxSize() const { return maxSize_; }
+
+    // Values of the fields that are not drawn from the random generator
+    struct Fields
+    {
+        quint64 sequence;
+        qint64 wallNs;
+        qint64 monotonicNs;
+        quint32 publisherId;
+        const QByteArray* topic;
+    };
+
+    /**
+     * @brief Renders the template into the internal buffer.
+     * @param fields The values of the fields.
+     * @param random The generator of the random fields.
+     * @return The size of the rendered message, the bytes are at data().
+     */
+    int render(const Fields& fields, FastRandom& random)
+    {
+        char* begin = buffer_.data();
+        char* p = begin;
+        const char* literals = literals_.constData();
+        for (const Op& op : ops_)
+        {
+            switch (op.code)
+            {
+            case OP_LITERAL:
+                memcpy(p, literals + op.offset, op.length);
+                p += op.length;
+                break;
+            case OP_SEQUENCE:
+                p = writeUnsigned(p, fields.sequence);
+                break;
+            case OP_WALL_TIME:
+                p = writeSigned(p, fields.wallNs / op.low);
+                break;
+            case OP_MONOTONIC:
+                p = writeSigned(p, fields.monotonicNs);
+                break;
+            case OP_RANDOM_HEX:
+                p = writeRandomHex(p, op.length, random);
+                break;
+            case OP_RANDOM_INT:
+            {
+                // In unsigned arithmetic, the span of a wide range such as the whole qint64 does not fit a qint64
+                quint64 span = static_cast<quint64>(op.high) - static_cast<quint64>(op.low) + 1;
+                p = writeSigned(p, static_cast<qint64>(static_cast<quint64>(op.low) + randomBelow(span, random)));
+                break;
+            }
+            case OP_TOPIC:
+            {
+                int size = qMin(fields.topic->size(), op.length);
+                memcpy(p, fields.topic->constData(), size);
+                p += size;
+                break;
+            }
+            case OP_PUBLISHER:
+                p = writeHex(p, fields.publisherId, 8);
+                break;
+            }
+        }
+        return static_cast<int>(p - begin);
+    }
+
+    const char* data() const { return buffer_.constData(); }
+
+private:
+    enum OpCode
+    {
+        OP_LITERAL,
+        OP_SEQUENCE,
+        OP_WALL_TIME,
+        OP_MONOTONIC,
+        OP_RANDOM_HEX,
+        OP_RANDOM_INT,
+        OP_TOPIC,
+        OP_PUBLISHER
+    };
+
+    struct Op
+    {
+        OpCode code;
+        int offset;         // Literal: position in literals_
+        int length;         // Literal size, hex digits or the longest topic
+        qint64 low;         // Random range or the divisor of the wall clock
+        qint64 high;
+    };
+
+    static const int MaxDecimal = 20;   // Digits and sign of any 64 bit integer
+
+    static void appendLiteral(QVector<Op>* ops, QByteArray* literals, const QByteArray& text)
+    {
+        // Adjacent literals, e.g. around "$$", become one copy
+        if (!ops->isEmpty() && ops->last().code == OP_LITERAL)
+        {
+            ops->last().length += text.size();
+        }
+        else
+        {
+            Op op = { OP_LITERAL, literals->size(), text.size(), 0, 0 };
+            ops->append(op);
+        }
+        literals->append(text);
+    }
+
+    static bool parseField(const QByteArray& field, int maxTopicSize, Op* op, int* width)
+    {
+        QList<QByteArray> parts = field.trimmed().split(':');
+        const QByteArray& name = parts.first();
+        Op result = { OP_SEQUENCE, 0, 0, 0, 0 };
+        *width = MaxDecimal;
+
+        if (name == "seq" && parts.size() == 1)
+        {
+            result.code = OP_SEQUENCE;
+        }
+        else if (name == "ts" && parts.size() <= 2)
+        {
+            QByteArray unit = parts.size() == 2 ? parts.at(1) : QByteArray("ms");
+            result.code = OP_WALL_TIME;
+            result.low = unit == "ms" ? 1000000 : unit == "us" ? 1000 : unit == "ns" ? 1 : 0;
+            if (result.low == 0)
+            {
+                return false;
+            }
+        }
+        else if (name == "mono" && parts.size() == 1)
+        {
+            result.code = OP_MONOTONIC;
+        }
+        else if (name == "rand" && parts.size() == 2)
+        {
+            bool ok = false;
+            result.code = OP_RANDOM_HEX;
+            result.length = parts.at(1).toInt(&ok);
+            if (!ok || result.length < 1 || result.length > 64)
+            {
+                return false;
+            }
+            *width = result.length;
+        }
+        else if (name == "int" && parts.size() == 3)
+        {
+            bool lowOk = false;
+            bool highOk = false;
+            result.code = OP_RANDOM_INT;
+            result.low = parts.at(1).toLongLong(&lowOk);
+            result.high = parts.at(2).toLongLong(&highOk);
+            if (!lowOk || !highOk || result.low > result.high)
+            {
+                return false;
+            }
+        }
+        else if (name == "topic" && parts.size() == 1)
+        {
+            result.code = OP_TOPIC;
+            result.length = maxTopicSize;
+            *width = maxTopicSize;
+        }
+        else if (name == "pub" && parts.size() == 1)
+        {
+            result.code = OP_PUBLISHER;
+            *width = 8;
+        }
+        else
+        {
+            return false;
+        }
+
+        *op = result;
+        return true;
+    }
+
+    // Two digits per division, written from the end of a scratch buffer
+    static char* writeUnsigned(char* p, quint64 value)
+    {
+        static const char digits[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+
+        char scratch[MaxDecimal];
+        char* end = scratch + MaxDecimal;
+        char* q = end;
+        while (value >= 100)
+        {
+            int pair = static_cast<int>(value % 100) * 2;
+            value /= 100;
+            *--q = digits[pair + 1];
+            *--q = digits[pair];
+        }
+        if (value >= 10)
+        {
+            int pair = static_cast<int>(value) * 2;
+            *--q = digits[pair + 1];
+            *--q = digits[pair];
+        }
+        else
+        {
+            *--q = static_cast<char>('0' + value);
+        }
+
+        int size = static_cast<int>(end - q);
+        memcpy(p, q, size);
+        return p + size;
+    }
+
+    static char* writeSigned(char* p, qint64 value)
+    {
+        if (value < 0)
+        {
+            *p++ = '-';
+            return writeUnsigned(p, 0 - static_cast<quint64>(value));
+        }
+        return writeUnsigned(p, static_cast<quint64>(value));
+    }
+
+    static char* writeHex(char* p, quint64 value, int digits)
+    {
+        static const char hex[] = "0123456789abcdef";
+        for (int i = digits - 1; i >= 0; --i)
+        {
+            p[i] = hex[value & 0xF];
+            value >>= 4;
+        }
+        return p + digits;
+    }
+
+    static char* writeRandomHex(char* p, int digits, FastRandom& random)
+    {
+        // One draw yields 16 digits
+        while (digits > 0)
+        {
+            int n = qMin(digits, 16);
+            p = writeHex(p, random.next(), n);
+            digits -= n;
+        }
+        return p;
+    }
+
+    // Uniform in [0, span), a span of 0 stands for 2^64
+    static quint64 randomBelow(quint64 span, FastRandom& random)
+    {
+        if (span != 0 && span <= 0xFFFFFFFFULL)
+        {
+            return random.bounded(static_cast<quint32>(span));
+        }
+        return span == 0 ? random.next() : random.next() % span;
+    }
+
+    QVector<Op> ops_;
+    QByteArray literals_;
+    QByteArray buffer_;     // maxSize_ bytes, rendered into over and over
+    int maxSize_;
+};
+
+}
+
+}
+
+#endif // NZMQT_MESSAGETEMPLATE_H
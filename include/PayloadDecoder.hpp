@@ -0,0 +1,105 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_PAYLOADDECODER_H
+#define NZMQT_PAYLOADDECODER_H
+
+#include <QByteArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QString>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Payload Decoder:
+Turns a binary payload frame into readable text for the message views. A decoder is created in the
+GUI thread and then only used through decode() on the decode thread, see DecodeQueue.hpp, so it must
+not change after construction. Another format is added by deriving from PayloadDecoder and offering
+it in the Decode As box of the main window.
+*/
+class PayloadDecoder
+{
+public:
+    // Longer output is cut, a view never shows more than this of one payload
+    static const int MaxTextSize = 1 << 20;
+
+    virtual ~PayloadDecoder()
+    {
+    }
+
+    virtual QString name() const = 0;
+
+    /**
+     * @brief Decodes a payload frame.
+     * @param payload The frame as received.
+     * @param text Receives the readable form, may span several lines.
+     * @param error Receives why the payload is not in this format.
+     * @return False if the payload cannot be decoded, text is undefined then.
+     */
+    virtual bool decode(const QByteArray& payload, QString* text, QString* error) const = 0;
+
+    // Quotes text or binary for the output, non printable bytes are escaped as \xHH
+    static QString quote(const QByteArray& bytes)
+    {
+        QString text;
+        text.reserve(bytes.size() + 2);
+        text.append('"');
+        for (char c : bytes)
+        {
+            uchar u = static_cast<uchar>(c);
+            if (c == '"' || c == '\\')
+            {
+                text.append('\\').append(QChar(u));
+            }
+            else if (u == '\n')
+            {
+                text.append("\\n");
+            }
+            else if (u >= 0x20 && u < 0x7F)
+            {
+                text.append(QChar(u));
+            }
+            else
+            {
+                text.append(QString("\\x%1").arg(u, 2, 16, QChar('0')));
+            }
+        }
+        text.append('"');
+        return text;
+    }
+};
+
+// Pretty prints a JSON object or array
+class JsonDecoder : public PayloadDecoder
+{
+public:
+    QString name() const override
+    {
+        return "JSON";
+    }
+
+    bool decode(const QByteArray& payload, QString* text, QString* error) const override
+    {
+        QJsonParseError parseError;
+        QJsonDocument document = QJsonDocument::fromJson(payload, &parseError);
+        if (document.isNull())
+        {
+            *error = QString("%1 at offset %2").arg(parseError.errorString()).arg(parseError.offset);
+            return false;
+        }
+        *text = QString::fromUtf8(document.toJson(QJsonDocument::Indented)).trimmed();
+        return true;
+    }
+};
+
+}
+
+}
+
+#endif // NZMQT_PAYLOADDECODER_H
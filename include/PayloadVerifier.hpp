@@ -0,0 +1,130 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_PAYLOADVERIFIER_H
+#define NZMQT_PAYLOADVERIFIER_H
+
+#include "MessageStamp.hpp"
+#include "SeededPayload.hpp"
+
+#include <QByteArray>
+#include <QList>
+#include <QMetaType>
+#include <QVector>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+// A seeded payload that did not match what its publisher sent
+struct PayloadMismatch
+{
+    quint32 publisherId;
+    QByteArray topic;
+    quint64 sequence;
+    qint64 expectedSize;
+    qint64 receivedSize;    // -1 if the message has no payload frame or more than one
+    qint64 offset;          // First byte that differs, -1 if only the size differs
+    qint64 receiveNs;
+};
+
+struct IntegrityReport
+{
+    quint64 verified;       // Seeded payloads checked since the start, including the mismatches
+    quint64 corrupted;      // Payloads with a byte that differs
+    quint64 malformed;      // Payloads of the wrong size or messages with a wrong number of frames
+    QVector<PayloadMismatch> samples;   // Mismatches sampled since the previous report
+
+    IntegrityReport()
+        : verified(0), corrupted(0), malformed(0)
+    {
+    }
+
+    quint64 failed() const { return corrupted + malformed; }
+};
+
+/*
+Payload Verifier:
+Checks the SeededPayload of every stamped message that is flagged as seeded. The expected bytes are
+regenerated from the stamp and compared word by word, nothing is stored per message. A message whose
+payload is cut short, padded, split into several frames or missing counts as malformed, one whose
+size is right but whose bytes differ as corrupted. The first MaxSamples mismatches are kept with the
+offset of the first bad byte, later ones are only counted so that a broken link does not flood the log.
+*/
+class PayloadVerifier
+{
+public:
+    static const int MaxSamples = 16;
+
+    PayloadVerifier()
+        : sampled_(0)
+    {
+    }
+
+    /**
+     * @brief Verifies the payload of a seeded message.
+     * @param msg The received frames: topic, stamp and the payload frame.
+     * @param stamp The parsed stamp frame, the message is ignored unless it is seeded.
+     * @param receiveNs The monotonic receive time.
+     * @return False if the payload does not match.
+     */
+    bool check(const QList<QByteArray>& msg, const MessageStamp::View& stamp, qint64 receiveNs)
+    {
+        if (!stamp.isSeeded())
+        {
+            return true;
+        }
+
+        ++report_.verified;
+        qint64 expectedSize = static_cast<qint64>(stamp.payloadSize());
+        qint64 receivedSize = msg.size() == 3 ? msg.at(2).size() : -1;
+        qint64 offset = -1;
+        if (receivedSize == expectedSize)
+        {
+            quint64 seed = SeededPayload::seed(stamp.publisherId(), msg.at(0), stamp.sequence());
+            offset = SeededPayload::verify(msg.at(2).constData(), expectedSize, seed);
+            if (offset < 0)
+            {
+                return true;
+            }
+            ++report_.corrupted;
+        }
+        else
+        {
+            ++report_.malformed;
+        }
+
+        if (sampled_ < MaxSamples)
+        {
+            ++sampled_;
+            PayloadMismatch mismatch = { stamp.publisherId(), msg.at(0), stamp.sequence(), expectedSize, receivedSize, offset, receiveNs };
+            report_.samples.append(mismatch);
+        }
+        return false;
+    }
+
+    bool isEmpty() const { return report_.verified == 0; }
+
+    // The counters since the start and the mismatches sampled since the previous call
+    IntegrityReport takeReport()
+    {
+        IntegrityReport report = report_;
+        report_.samples.clear();
+        return report;
+    }
+
+private:
+    IntegrityReport report_;
+    int sampled_;
+};
+
+}
+
+}
+
+Q_DECLARE_METATYPE(nzmqt::samples::IntegrityReport)
+
+#endif // NZMQT_PAYLOADVERIFIER_H
@@ -0,0 +1,825 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_PROTOBUFDECODER_H
+#define NZMQT_PROTOBUFDECODER_H
+
+#include "PayloadDecoder.hpp"
+
+#include <QFile>
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <cstring>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Protobuf Wire:
+A reader for the protobuf wire format, shared by the descriptor set parser and the decoder. Every
+read is checked against the end of the buffer.
+*/
+struct ProtobufWire
+{
+    enum WireType
+    {
+        VARINT = 0,
+        FIXED64 = 1,
+        LENGTH_DELIMITED = 2,
+        START_GROUP = 3,
+        END_GROUP = 4,
+        FIXED32 = 5
+    };
+
+    const uchar* p;
+    const uchar* end;
+
+    explicit ProtobufWire(const QByteArray& data)
+        : p(reinterpret_cast<const uchar*>(data.constData())), end(p + data.size())
+    {
+    }
+
+    ProtobufWire(const uchar* begin, const uchar* e)
+        : p(begin), end(e)
+    {
+    }
+
+    bool atEnd() const
+    {
+        return p >= end;
+    }
+
+    bool varint(quint64* value)
+    {
+        *value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (p >= end)
+            {
+                return false;
+            }
+            uchar byte = *p++;
+            *value |= quint64(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool tag(int* number, int* wireType)
+    {
+        quint64 key;
+        if (!varint(&key) || (key >> 3) == 0 || (key >> 3) > 0x1FFFFFFF)
+        {
+            return false;
+        }
+        *number = static_cast<int>(key >> 3);
+        *wireType = static_cast<int>(key & 7);
+        return true;
+    }
+
+    bool fixed(int size, quint64* value)
+    {
+        if (end - p < size)
+        {
+            return false;
+        }
+        *value = 0;
+        for (int i = 0; i < size; ++i)
+        {
+            *value |= quint64(p[i]) << (8 * i);
+        }
+        p += size;
+        return true;
+    }
+
+    bool bytes(QByteArray* value)
+    {
+        quint64 size;
+        if (!varint(&size) || static_cast<quint64>(end - p) < size)
+        {
+            return false;
+        }
+        *value = QByteArray::fromRawData(reinterpret_cast<const char*>(p), static_cast<int>(size));
+        p += size;
+        return true;
+    }
+
+    // Skips the value of a field, groups are not supported
+    bool skip(int wireType)
+    {
+        quint64 value;
+        QByteArray data;
+        switch (wireType)
+        {
+        case VARINT: return varint(&value);
+        case FIXED64: return fixed(8, &value);
+        case LENGTH_DELIMITED: return bytes(&data);
+        case FIXED32: return fixed(4, &value);
+        default: return false;
+        }
+    }
+};
+
+/*
+Protobuf Descriptors:
+The message types of a descriptor set, as written by protoc --descriptor_set_out=types.desc
+--include_imports. The set is itself a protobuf message and is read with ProtobufWire, only the
+parts the decoder needs are kept: field names, numbers, types and enum value names. Loaded once in
+the GUI thread and shared read only with the decoders afterwards.
+*/
+class ProtobufDescriptors
+{
+public:
+    // FieldDescriptorProto.Type
+    enum FieldType
+    {
+        TYPE_DOUBLE = 1, TYPE_FLOAT = 2, TYPE_INT64 = 3, TYPE_UINT64 = 4, TYPE_INT32 = 5, TYPE_FIXED64 = 6,
+        TYPE_FIXED32 = 7, TYPE_BOOL = 8, TYPE_STRING = 9, TYPE_GROUP = 10, TYPE_MESSAGE = 11, TYPE_BYTES = 12,
+        TYPE_UINT32 = 13, TYPE_ENUM = 14, TYPE_SFIXED32 = 15, TYPE_SFIXED64 = 16, TYPE_SINT32 = 17, TYPE_SINT64 = 18
+    };
+
+    struct Field
+    {
+        QByteArray name;
+        int type;
+        QByteArray typeName;    // Full name of a message or enum type, without the leading dot
+
+        Field() : type(0) {}
+    };
+
+    struct Message
+    {
+        QHash<int, Field> fields;
+    };
+
+    typedef QHash<qint32, QByteArray> Enum;
+
+    /**
+     * @brief Reads a descriptor set file.
+     * @param path The file written by protoc --descriptor_set_out.
+     * @param error Receives a description of the problem.
+     * @return False if the file cannot be read or is not a descriptor set.
+     */
+    bool load(const QString& path, QString* error)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            *error = QString("%1: %2").arg(path, file.errorString());
+            return false;
+        }
+        QByteArray data = file.readAll();
+
+        messages_.clear();
+        enums_.clear();
+        ProtobufWire wire(data);
+        while (!wire.atEnd())
+        {
+            int number;
+            int wireType;
+            QByteArray fileDescriptor;
+            bool ok = wire.tag(&number, &wireType);
+            if (ok && number == 1 && wireType == ProtobufWire::LENGTH_DELIMITED)
+            {
+                ok = wire.bytes(&fileDescriptor) && parseFile(fileDescriptor);
+            }
+            else if (ok)
+            {
+                ok = wire.skip(wireType);
+            }
+            if (!ok)
+            {
+                *error = QString("%1 is not a protobuf descriptor set").arg(path);
+                return false;
+            }
+        }
+        if (messages_.isEmpty())
+        {
+            *error = QString("%1 defines no message types").arg(path);
+            return false;
+        }
+        return true;
+    }
+
+    const Message* message(const QByteArray& fullName) const
+    {
+        auto it = messages_.constFind(fullName);
+        return it == messages_.constEnd() ? 0 : &it.value();
+    }
+
+    const Enum* enumType(const QByteArray& fullName) const
+    {
+        auto it = enums_.constFind(fullName);
+        return it == enums_.constEnd() ? 0 : &it.value();
+    }
+
+    int messageCount() const
+    {
+        return messages_.size();
+    }
+
+private:
+    // FileDescriptorProto: 2 package, 4 message_type, 5 enum_type
+    bool parseFile(const QByteArray& data)
+    {
+        QByteArray package;
+        QVector<QByteArray> messages;
+        QVector<QByteArray> enums;
+        ProtobufWire wire(data);
+        while (!wire.atEnd())
+        {
+            int number;
+            int wireType;
+            QByteArray value;
+            if (!wire.tag(&number, &wireType))
+            {
+                return false;
+            }
+            if (wireType != ProtobufWire::LENGTH_DELIMITED || (number != 2 && number != 4 && number != 5))
+            {
+                if (!wire.skip(wireType))
+                {
+                    return false;
+                }
+                continue;
+            }
+            if (!wire.bytes(&value))
+            {
+                return false;
+            }
+            if (number == 2)
+            {
+                package = value;
+            }
+            else
+            {
+                (number == 4 ? messages : enums).append(value);
+            }
+        }
+
+        // The package may follow the types, so they are parsed last
+        for (const QByteArray& message : messages)
+        {
+            if (!parseMessage(message, package))
+            {
+                return false;
+            }
+        }
+        for (const QByteArray& enumDescriptor : enums)
+        {
+            if (!parseEnum(enumDescriptor, package))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static QByteArray qualify(const QByteArray& scope, const QByteArray& name)
+    {
+        return scope.isEmpty() ? name : scope + '.' + name;
+    }
+
+    // DescriptorProto: 1 name, 2 field, 3 nested_type, 4 enum_type
+    bool parseMessage(const QByteArray& data, const QByteArray& scope)
+    {
+        QByteArray name;
+        QVector<QByteArray> fields;
+        QVector<QByteArray> nested;
+        QVector<QByteArray> enums;
+        ProtobufWire wire(data);
+        while (!wire.atEnd())
+        {
+            int number;
+            int wireType;
+            QByteArray value;
+            if (!wire.tag(&number, &wireType))
+            {
+                return false;
+            }
+            if (wireType != ProtobufWire::LENGTH_DELIMITED || number < 1 || number > 4)
+            {
+                if (!wire.skip(wireType))
+                {
+                    return false;
+                }
+                continue;
+            }
+            if (!wire.bytes(&value))
+            {
+                return false;
+            }
+            switch (number)
+            {
+            case 1: name = value; break;
+            case 2: fields.append(value); break;
+            case 3: nested.append(value); break;
+            default: enums.append(value); break;
+            }
+        }
+
+        QByteArray fullName = qualify(scope, name);
+        Message& message = messages_[fullName];
+        for (const QByteArray& field : fields)
+        {
+            if (!parseField(field, &message))
+            {
+                return false;
+            }
+        }
+        for (const QByteArray& type : nested)
+        {
+            if (!parseMessage(type, fullName))
+            {
+                return false;
+            }
+        }
+        for (const QByteArray& enumDescriptor : enums)
+        {
+            if (!parseEnum(enumDescriptor, fullName))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // FieldDescriptorProto: 1 name, 3 number, 5 type, 6 type_name
+    static bool parseField(const QByteArray& data, Message* message)
+    {
+        Field field;
+        int fieldNumber = 0;
+        ProtobufWire wire(data);
+        while (!wire.atEnd())
+        {
+            int number;
+            int wireType;
+            quint64 value;
+            QByteArray bytes;
+            if (!wire.tag(&number, &wireType))
+            {
+                return false;
+            }
+            if ((number == 1 || number == 6) && wireType == ProtobufWire::LENGTH_DELIMITED)
+            {
+                if (!wire.bytes(&bytes))
+                {
+                    return false;
+                }
+                if (number == 1)
+                {
+                    field.name = bytes;
+                }
+                else
+                {
+                    field.typeName = bytes.startsWith('.') ? bytes.mid(1) : bytes;
+                }
+            }
+            else if ((number == 3 || number == 5) && wireType == ProtobufWire::VARINT)
+            {
+                if (!wire.varint(&value))
+                {
+                    return false;
+                }
+                (number == 3 ? fieldNumber : field.type) = static_cast<int>(value);
+            }
+            else if (!wire.skip(wireType))
+            {
+                return false;
+            }
+        }
+        message->fields.insert(fieldNumber, field);
+        return true;
+    }
+
+    // EnumDescriptorProto: 1 name, 2 value; EnumValueDescriptorProto: 1 name, 2 number
+    bool parseEnum(const QByteArray& data, const QByteArray& scope)
+    {
+        QByteArray name;
+        Enum values;
+        ProtobufWire wire(data);
+        while (!wire.atEnd())
+        {
+            int number;
+            int wireType;
+            QByteArray value;
+            if (!wire.tag(&number, &wireType))
+            {
+                return false;
+            }
+            if (wireType != ProtobufWire::LENGTH_DELIMITED || (number != 1 && number != 2))
+            {
+                if (!wire.skip(wireType))
+                {
+                    return false;
+                }
+                continue;
+            }
+            if (!wire.bytes(&value))
+            {
+                return false;
+            }
+            if (number == 1)
+            {
+                name = value;
+                continue;
+            }
+
+            QByteArray valueName;
+            quint64 valueNumber = 0;
+            ProtobufWire valueWire(value);
+            while (!valueWire.atEnd())
+            {
+                int n;
+                int w;
+                if (!valueWire.tag(&n, &w))
+                {
+                    return false;
+                }
+                bool ok = n == 1 && w == ProtobufWire::LENGTH_DELIMITED ? valueWire.bytes(&valueName)
+                    : n == 2 && w == ProtobufWire::VARINT ? valueWire.varint(&valueNumber)
+                    : valueWire.skip(w);
+                if (!ok)
+                {
+                    return false;
+                }
+            }
+            values.insert(static_cast<qint32>(valueNumber), valueName);
+        }
+        enums_.insert(qualify(scope, name), values);
+        return true;
+    }
+
+    QHash<QByteArray, Message> messages_;   // By full name, package included
+    QHash<QByteArray, Enum> enums_;
+};
+
+/*
+Protobuf Decoder:
+Shows a protobuf message in the text format of protoc --decode. With a message type from a
+descriptor set the fields get their names and types, without one the payload is shown like
+protoc --decode_raw: field numbers, and a length delimited field is taken for a nested message if
+it parses as one, for a string if it is printable, else for bytes. Unknown fields of a typed message
+are shown the raw way as well.
+*/
+class ProtobufDecoder : public PayloadDecoder
+{
+public:
+    static const int MaxDepth = 64;
+
+    /**
+     * @brief Creates a decoder.
+     * @param descriptors The message types, may be null for raw decoding.
+     * @param messageType The full name of the payload type, raw decoding if empty.
+     */
+    ProtobufDecoder(const QSharedPointer<const ProtobufDescriptors>& descriptors, const QByteArray& messageType)
+        : descriptors_(descriptors)
+        , type_(descriptors && !messageType.isEmpty() ? descriptors->message(messageType) : 0)
+        , messageType_(messageType)
+    {
+    }
+
+    QString name() const override
+    {
+        return type_ ? QString("Protobuf %1").arg(QString::fromUtf8(messageType_)) : QString("Protobuf");
+    }
+
+    bool decode(const QByteArray& payload, QString* text, QString* error) const override
+    {
+        text->clear();
+        if (payload.isEmpty())
+        {
+            // A message with all fields at their defaults
+            return true;
+        }
+        ProtobufWire wire(payload);
+        if (!message(&wire, type_, 0, text))
+        {
+            *error = QString("Not a protobuf message at offset %1").arg(wire.p - reinterpret_cast<const uchar*>(payload.constData()));
+            return false;
+        }
+        text->chop(1);
+        return true;
+    }
+
+private:
+    static void indent(QString* text, int depth)
+    {
+        text->append(QString(depth * 2, ' '));
+    }
+
+    static QString fieldName(const ProtobufDescriptors::Field* field, int number)
+    {
+        return field ? QString::fromUtf8(field->name) : QString::number(number);
+    }
+
+    bool message(ProtobufWire* wire, const ProtobufDescriptors::Message* type, int depth, QString* text) const
+    {
+        if (depth > MaxDepth)
+        {
+            return false;
+        }
+        while (!wire->atEnd())
+        {
+            if (text->size() >= MaxTextSize)
+            {
+                text->append("...\n");
+                wire->p = wire->end;
+                return true;
+            }
+
+            int number;
+            int wireType;
+            if (!wire->tag(&number, &wireType))
+            {
+                return false;
+            }
+            auto it = type ? type->fields.constFind(number) : QHash<int, ProtobufDescriptors::Field>::const_iterator();
+            const ProtobufDescriptors::Field* field = type && it != type->fields.constEnd() ? &it.value() : 0;
+
+            if (!field)
+            {
+                if (!raw(wire, number, wireType, depth, text))
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            if (wireType == ProtobufWire::LENGTH_DELIMITED && isPackable(field->type))
+            {
+                // A packed repeated field, the values follow each other without tags
+                QByteArray packed;
+                if (!wire->bytes(&packed))
+                {
+                    return false;
+                }
+                ProtobufWire values(packed);
+                while (!values.atEnd())
+                {
+                    if (!typed(&values, *field, wireTypeOf(field->type), depth, text))
+                    {
+                        return false;
+                    }
+                }
+                continue;
+            }
+            if (!typed(wire, *field, wireType, depth, text))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool isPackable(int type)
+    {
+        return type != ProtobufDescriptors::TYPE_STRING && type != ProtobufDescriptors::TYPE_BYTES
+            && type != ProtobufDescriptors::TYPE_MESSAGE && type != ProtobufDescriptors::TYPE_GROUP;
+    }
+
+    static int wireTypeOf(int type)
+    {
+        switch (type)
+        {
+        case ProtobufDescriptors::TYPE_DOUBLE:
+        case ProtobufDescriptors::TYPE_FIXED64:
+        case ProtobufDescriptors::TYPE_SFIXED64:
+            return ProtobufWire::FIXED64;
+        case ProtobufDescriptors::TYPE_FLOAT:
+        case ProtobufDescriptors::TYPE_FIXED32:
+        case ProtobufDescriptors::TYPE_SFIXED32:
+            return ProtobufWire::FIXED32;
+        case ProtobufDescriptors::TYPE_STRING:
+        case ProtobufDescriptors::TYPE_BYTES:
+        case ProtobufDescriptors::TYPE_MESSAGE:
+            return ProtobufWire::LENGTH_DELIMITED;
+        default:
+            return ProtobufWire::VARINT;
+        }
+    }
+
+    // One value of a known field, a wire type that does not fit the declared type is shown raw
+    bool typed(ProtobufWire* wire, const ProtobufDescriptors::Field& field, int wireType, int depth, QString* text) const
+    {
+        if (wireType != wireTypeOf(field.type))
+        {
+            return raw(wire, 0, wireType, depth, text, &field);
+        }
+
+        QString value;
+        quint64 bits = 0;
+        QByteArray bytes;
+        switch (field.type)
+        {
+        case ProtobufDescriptors::TYPE_MESSAGE:
+        {
+            if (!wire->bytes(&bytes))
+            {
+                return false;
+            }
+            const ProtobufDescriptors::Message* type = descriptors_->message(field.typeName);
+            indent(text, depth);
+            text->append(fieldName(&field, 0)).append(" {\n");
+            ProtobufWire nested(bytes);
+            if (!message(&nested, type, depth + 1, text))
+            {
+                return false;
+            }
+            indent(text, depth);
+            text->append("}\n");
+            return true;
+        }
+        case ProtobufDescriptors::TYPE_STRING:
+        case ProtobufDescriptors::TYPE_BYTES:
+            if (!wire->bytes(&bytes))
+            {
+                return false;
+            }
+            value = field.type == ProtobufDescriptors::TYPE_STRING ? quoteUtf8(bytes) : quote(bytes);
+            break;
+        case ProtobufDescriptors::TYPE_DOUBLE:
+        {
+            if (!wire->fixed(8, &bits))
+            {
+                return false;
+            }
+            double d;
+            memcpy(&d, &bits, sizeof(d));
+            value = QString::number(d, 'g', 17);
+            break;
+        }
+        case ProtobufDescriptors::TYPE_FLOAT:
+        {
+            if (!wire->fixed(4, &bits))
+            {
+                return false;
+            }
+            quint32 bits32 = static_cast<quint32>(bits);
+            float f;
+            memcpy(&f, &bits32, sizeof(f));
+            value = QString::number(f, 'g', 9);
+            break;
+        }
+        case ProtobufDescriptors::TYPE_FIXED64:
+        case ProtobufDescriptors::TYPE_FIXED32:
+            if (!wire->fixed(field.type == ProtobufDescriptors::TYPE_FIXED64 ? 8 : 4, &bits))
+            {
+                return false;
+            }
+            value = QString::number(bits);
+            break;
+        case ProtobufDescriptors::TYPE_SFIXED64:
+            if (!wire->fixed(8, &bits))
+            {
+                return false;
+            }
+            value = QString::number(static_cast<qint64>(bits));
+            break;
+        case ProtobufDescriptors::TYPE_SFIXED32:
+            if (!wire->fixed(4, &bits))
+            {
+                return false;
+            }
+            value = QString::number(static_cast<qint32>(bits));
+            break;
+        default:
+            if (!wire->varint(&bits))
+            {
+                return false;
+            }
+            value = varint(field, bits);
+            break;
+        }
+
+        indent(text, depth);
+        text->append(fieldName(&field, 0)).append(": ").append(value).append('\n');
+        return true;
+    }
+
+    QString varint(const ProtobufDescriptors::Field& field, quint64 bits) const
+    {
+        switch (field.type)
+        {
+        case ProtobufDescriptors::TYPE_INT64:
+            return QString::number(static_cast<qint64>(bits));
+        case ProtobufDescriptors::TYPE_INT32:
+            return QString::number(static_cast<qint32>(bits));
+        case ProtobufDescriptors::TYPE_UINT32:
+            return QString::number(static_cast<quint32>(bits));
+        case ProtobufDescriptors::TYPE_BOOL:
+            return bits != 0 ? "true" : "false";
+        case ProtobufDescriptors::TYPE_SINT32:
+        case ProtobufDescriptors::TYPE_SINT64:
+            return QString::number(static_cast<qint64>(bits >> 1) ^ -static_cast<qint64>(bits & 1));
+        case ProtobufDescriptors::TYPE_ENUM:
+        {
+            const ProtobufDescriptors::Enum* values = descriptors_->enumType(field.typeName);
+            QByteArray name = values ? values->value(static_cast<qint32>(bits)) : QByteArray();
+            return name.isEmpty() ? QString::number(static_cast<qint32>(bits)) : QString::fromUtf8(name);
+        }
+        default:
+            return QString::number(bits);
+        }
+    }
+
+    // A field without a descriptor, or one whose wire type does not fit its descriptor
+    bool raw(ProtobufWire* wire, int number, int wireType, int depth, QString* text, const ProtobufDescriptors::Field* field = 0) const
+    {
+        quint64 bits = 0;
+        QByteArray bytes;
+        QString value;
+        switch (wireType)
+        {
+        case ProtobufWire::VARINT:
+            if (!wire->varint(&bits))
+            {
+                return false;
+            }
+            value = QString::number(bits);
+            break;
+        case ProtobufWire::FIXED64:
+            if (!wire->fixed(8, &bits))
+            {
+                return false;
+            }
+            value = QString("0x%1").arg(bits, 16, 16, QChar('0'));
+            break;
+        case ProtobufWire::FIXED32:
+            if (!wire->fixed(4, &bits))
+            {
+                return false;
+            }
+            value = QString("0x%1").arg(bits, 8, 16, QChar('0'));
+            break;
+        case ProtobufWire::LENGTH_DELIMITED:
+        {
+            if (!wire->bytes(&bytes))
+            {
+                return false;
+            }
+            // A nested message if it parses as one to the last byte, the partial output is discarded otherwise
+            QString nestedText;
+            ProtobufWire nested(bytes);
+            if (!bytes.isEmpty() && !isPrintable(bytes) && message(&nested, 0, depth + 1, &nestedText))
+            {
+                indent(text, depth);
+                text->append(fieldName(field, number)).append(" {\n").append(nestedText);
+                indent(text, depth);
+                text->append("}\n");
+                return true;
+            }
+            value = isPrintable(bytes) ? quoteUtf8(bytes) : quote(bytes);
+            break;
+        }
+        default:
+            // Groups are deprecated and not decoded
+            return false;
+        }
+
+        indent(text, depth);
+        text->append(fieldName(field, number)).append(": ").append(value).append('\n');
+        return true;
+    }
+
+    // Valid UTF-8 without control characters other than white space
+    static bool isPrintable(const QByteArray& bytes)
+    {
+        for (char c : bytes)
+        {
+            uchar u = static_cast<uchar>(c);
+            if (u < 0x20 && u != '\t' && u != '\n' && u != '\r')
+            {
+                return false;
+            }
+        }
+        return QString::fromUtf8(bytes).toUtf8() == bytes;
+    }
+
+    static QString quoteUtf8(const QByteArray& bytes)
+    {
+        QString text = QString::fromUtf8(bytes);
+        text.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+        return QString("\"%1\"").arg(text);
+    }
+
+    QSharedPointer<const ProtobufDescriptors> descriptors_;
+    const ProtobufDescriptors::Message* type_;  // Points into descriptors_, 0 for raw decoding
+    QByteArray messageType_;
+};
+
+}
+
+}
+
+#endif // NZMQT_PROTOBUFDECODER_H
@@ -28,12 +28,27 @@
 #define NZMQT_PUBSUBSERVER_H
 
 #include "SampleBase.hpp"
+#include "CachedFrame.hpp"
+#include "MappedCapture.hpp"
+#include "ChunkSender.hpp"
+#include "HexCodec.hpp"
+#include "LoadProfile.hpp"
+#include "MappedPayload.hpp"
+#include "MessageTemplate.hpp"
+#include "MessageStamp.hpp"
+#include "PublisherStats.hpp"
+#include "RateScheduler.hpp"
+#include "SeededPayload.hpp"
+#include "TopicSampler.hpp"
 
 #include "nzmqt/nzmqt.hpp"
 
 #include <QByteArray>
 #include <QDateTime>
+#include <QHash>
 #include <QList>
+#include <QRandomGenerator>
+#include <QSharedPointer>
 #include <QTimer>
 
 
@@ -54,16 +69,138 @@ class Publisher : public SampleBase
 public:
     explicit Publisher(ZMQContext& context, const QString& address, const bool& useHex, QObject* parent = 0)
         : super(parent)
-        , address_(address), frequency_(0), useHex_(useHex)
+        , address_(address), payloadSliceSize_(0), seededSize_(0), seeded_(false), templated_(false), templateSequence_(0), wallOffsetNs_(0)
+        , streaming_(false), chunkSize_(1024 * 1024), chunkWindow_(8), pendingStreams_(0), streamTopic_(0), streamPumpScheduled_(false)
+        , share_(1.0), phase_(0.0), connect_(false), useHex_(useHex), payloadHex_(false), stamped_(false)
+        , publisherId_(QRandomGenerator::global()->generate())
+        , targetRate_(0), profileStartNs_(0), sendGeneration_(0)
+        , random_(publisherId_)
+        , nextEchoNs_(0)
+        , replaySpeed_(1.0), replaying_(false), replayGeneration_(0), replayOriginNs_(0), replayStartNs_(0)
         , socket_(0)
     {
         socket_ = context.createSocket(ZMQSocket::TYP_PUB, this);
         socket_->setObjectName("Publisher.Socket.socket(PUB)");
     }
 
-    void setFrequency(int frequency)
+    // The setters change the run state of the publisher thread, the GUI queues them into that thread
+    // together with startAction() while a previous run may still be sending
+    void setFrequency(double frequency)
     {
-        frequency_ = frequency;
+        profile_ = LoadProfile::constant(frequency);
+    }
+
+    // Varies the rate over time, replaces the frequency, see LoadProfile.hpp
+    void setLoadProfile(const LoadProfile& profile)
+    {
+        profile_ = profile;
+    }
+
+    /**
+     * @brief Sets the part of the profile's rate this publisher sends.
+     * @param share The fraction in the range 0 to 1, workers sharing a rate use 1 / N. Stamps carry the full rate.
+     * @return None
+     */
+    void setShare(double share)
+    {
+        share_ = qBound(0.0, share, 1.0);
+    }
+
+    /**
+     * @brief Shifts the schedule of this publisher by a fraction of its period.
+     * @param phase The fraction in the range 0 to 1, workers sharing a rate use i / N to interleave their messages.
+     * @return None
+     */
+    void setPhase(double phase)
+    {
+        phase_ = qBound(0.0, phase, 1.0);
+    }
+
+    // Connects to the address instead of binding it, e.g. to feed a proxy shared by several publishers
+    void setConnect(bool connect)
+    {
+        connect_ = connect;
+    }
+
+    // Reads the message as a hex dump and publishes the decoded bytes, see HexCodec.hpp
+    void setUseHex(bool useHex)
+    {
+        useHex_ = useHex;
+    }
+
+    // Counters updated by this publisher, they may be read from any thread
+    void setStats(const QSharedPointer<PublisherStats>& stats)
+    {
+        stats_ = stats;
+    }
+
+    // Prepends a MessageStamp frame to every message, see MessageStamp.hpp
+    void setStamped(bool stamped)
+    {
+        stamped_ = stamped;
+    }
+
+    quint32 publisherId() const
+    {
+        return publisherId_;
+    }
+
+    /**
+     * @brief Sets the topics messages are spread over, replaces the topic passed to startAction().
+     * @param topics The parsed topic set with its distribution, an empty set restores the single topic.
+     * @return None
+     */
+    void setTopics(const TopicSampler& topics)
+    {
+        pendingTopics_ = topics;
+    }
+
+    /**
+     * @brief Publishes the contents of a file instead of the message passed to startAction().
+     * @param path The file to publish, it is mapped and sent without a copy. An empty path restores the message.
+     * @param sliceSize Splits the file into frames of this size that are sent one after the other, 0 sends the whole file.
+     * @return None
+     */
+    void setPayloadFile(const QString& path, qint64 sliceSize)
+    {
+        payloadPath_ = path;
+        payloadSliceSize_ = qMax<qint64>(0, sliceSize);
+    }
+
+    /**
+     * @brief Publishes a SeededPayload instead of the message, the subscriber verifies every byte of it.
+     * @param size The size of the payload frame in bytes, 0 restores the message. Seeded messages are always stamped.
+     * @return None
+     */
+    void setSeededPayload(qint64 size)
+    {
+        seededSize_ = qMax<qint64>(0, size);
+    }
+
+    /**
+     * @brief Sends every message as a stream of chunks instead of a single payload frame, see ChunkSender.hpp.
+     * @param streaming True to stream the payload, the rate then counts streams instead of messages.
+     * @param chunkSize The size of a chunk's data in bytes.
+     * @param window The number of chunks that may be queued in ZeroMQ at a time.
+     * @return None
+     */
+    void setStreaming(bool streaming, qint64 chunkSize, int window)
+    {
+        streaming_ = streaming;
+        chunkSize_ = chunkSize;
+        chunkWindow_ = window;
+    }
+
+    /**
+     * @brief Switches between publishing the message of startAction() and replaying a capture.
+     * @param path The capture to replay, an empty path disables replay.
+     * @param speed Factor applied to the recorded timing, 2 replays twice as fast, 0 sends as fast as possible.
+     * @return None
+     */
+    void setReplay(const QString& path, double speed)
+    {
+        replayPath_ = path;
+        replaySpeed_ = qMax(0.0, speed);
     }
 
 signals:
@@ -74,71 +211,565 @@ protected:
     {
         int send_timeout = 2000;  // 2 seconds for receiving
         socket_->setOption(ZMQSocket::OPT_SNDTIMEO, &send_timeout, sizeof(send_timeout));
-        socket_->bindTo(address_);
+        if (connect_)
+        {
+            socket_->connectTo(address_);
+        }
+        else
+        {
+            socket_->bindTo(address_);
+        }
     }
 
     void startImpl(const QStringList& messages)
     {
+        // The send and replay loops run in the publisher thread and read the socket, the mappings and
+        // the run state there, the GUI's call is handed over to that thread instead of changing them underneath it
+        if (QThread::currentThread() != thread())
+        {
+            QMetaObject::invokeMethod(this, [this, messages]() { startAction(messages); }, Qt::QueuedConnection);
+            return;
+        }
+
+        if (!replayPath_.isEmpty())
+        {
+            startReplay();
+            return;
+        }
+
         if (messages.isEmpty())
         {
             return;
         }
 
         topic_ = messages.first();
-        message_ = messages.at(1);
-        
-        QTimer::singleShot(100, this, SLOT(sendMessage()));
+        if (messages.at(1) != message_ || useHex_ != payloadHex_)
+        {
+            // A hex dump is decoded once here, the send loop publishes the cached bytes
+            QByteArray text = messages.at(1).toLocal8Bit();
+            QByteArray bytes;
+            QString error;
+            if (useHex_ && !HexCodec::decode(text, &bytes, &error))
+            {
+                emit signal_log(1, error);
+                return;
+            }
+            message_ = messages.at(1);
+            payloadHex_ = useHex_;
+            hexText_ = useHex_ ? text : QByteArray();
+            payload_.reset(useHex_ ? bytes : text);
+        }
+        nextEchoNs_ = 0;
+
+        // A streamed payload is chunked by the sender, otherwise a file is published in slices
+        mappedPayload_.close();
+        closeStream();
+        QString error;
+        bool ok = true;
+        if (streaming_)
+        {
+            chunkSender_.setChunking(chunkSize_, chunkWindow_);
+            if (payloadPath_.isEmpty())
+            {
+                chunkSender_.setSource(payload_.bytes());
+            }
+            else
+            {
+                ok = chunkSender_.setSource(payloadPath_, &error);
+            }
+        }
+        else if (!payloadPath_.isEmpty())
+        {
+            ok = mappedPayload_.open(payloadPath_, payloadSliceSize_, &error);
+        }
+        if (!ok)
+        {
+            emit signal_log(1, error);
+            return;
+        }
+
+        TopicSampler topics = pendingTopics_;
+        if (topics.isEmpty() && !topics.parse(topic_, &error))
+        {
+            emit signal_log(1, error);
+            return;
+        }
+        useTopics(topics);
+        stampFrame_ = MessageStamp::makeFrame(publisherId_);
+
+        // A seeded payload replaces the message, the stamp tells the subscriber its size
+        seeded_ = !streaming_ && payloadPath_.isEmpty() && seededSize_ > 0;
+        MessageStamp::patchSeeded(stampFrame_.data(), seeded_ ? seededSize_ : 0);
+        seededEcho_ = seeded_ ? QString("Seeded payload of %1 bytes").arg(seededSize_).toUtf8() : QByteArray();
+
+        // A message with fields is compiled here once, the send loop only runs its ops
+        templated_ = !streaming_ && !seeded_ && !useHex_ && payloadPath_.isEmpty() && MessageTemplate::isTemplate(payload_.bytes());
+        if (templated_)
+        {
+            int maxTopicSize = 0;
+            for (int i = 0; i < topics_.size(); ++i)
+            {
+                maxTopicSize = qMax(maxTopicSize, topics_.topic(i).size());
+            }
+            if (!template_.compile(payload_.bytes(), maxTopicSize, &error))
+            {
+                templated_ = false;
+                emit signal_log(1, error);
+                return;
+            }
+            wallOffsetNs_ = QDateTime::currentMSecsSinceEpoch() * 1000000LL - monotonicNs();
+        }
+
+        // The first message is due when the timer below fires, later ones one period apart
+        double rate = profile_.rateAt(0);
+        targetRate_ = static_cast<quint32>(qMin(rate, 4e9));
+        qint64 offsetNs = rate * share_ > 0 ? static_cast<qint64>(phase_ * 1e9 / (rate * share_)) : 0;
+        profileStartNs_ = monotonicNs() + 100 * 1000000LL + offsetNs;
+        scheduler_.start(profileStartNs_, rate * share_);
+        int generation = ++sendGeneration_;
+        QTimer::singleShot(scheduler_.delayMsec(monotonicNs()), Qt::PreciseTimer, this, [this, generation]() { sendMessage(generation); });
     }
 
     void stopImpl(const QStringList& messages)
     {
-        frequency_ = 0;
+        if (QThread::currentThread() != thread())
+        {
+            QMetaObject::invokeMethod(this, [this, messages]() { stopAction(messages); }, Qt::QueuedConnection);
+            return;
+        }
+
+        // The send loop of the current run ends at its next message, a restart before that starts a new one
+        ++sendGeneration_;
+
+        // Pending replay timers see a new generation and do nothing, the capture is unmapped between two passes
+        ++replayGeneration_;
+        if (replaying_)
+        {
+            replaying_ = false;
+            replay_.close();
+        }
+
+        // The pump of the current run ends with the generation, the socket gets the rest of its chunk here
+        closeStream();
     }
 
 protected slots:
-    void sendMessage()
+    void sendMessage(int generation)
     {
-        QList<QByteArray> msg;
-        QList<QByteArray> hexMsg;
-        msg += topic_.toLocal8Bit();
-        msg += message_.toLocal8Bit();
-        QString currentTime = getCurrentTime();
+        // Everything that is due goes out now and nothing before its time, so the rate holds even when the
+        // period is shorter than the timer resolution. When the timer fired late the backlog is sent as a
+        // burst instead of shifting the schedule, so the intended times stay those of the requested rate.
+        qint64 now = monotonicNs();
+        int burst = 0;
+        while (scheduler_.isDue(now) && burst++ < MaxBurst)
+        {
+            if (generation != sendGeneration_)
+            {
+                return;
+            }
 
-        // if (useHex_)
-        // {
-        //     hexMsg.append(msg.at(0));
-        //     if (msg.size() > 1)  // Ensure there are at least two elements
-        //     {
-        //         for (int i = 1; i < msg.size(); ++i)
-        //         {
-        //             hexMsg.append(msg.at(i).toHex());
-        //         }
-        //     }
-        //     socket_->sendMessage(hexMsg);
+            qint64 intendedNs = scheduler_.nextIntendedNs();
+            if (!profile_.isConstant())
+            {
+                // The rate at this message's due time sets the gap to the next one
+                double rate = profile_.rateAt(intendedNs - profileStartNs_);
+                if (rate <= 0.0)
+                {
+                    emit signal_log(0, QString("Load profile finished"));
+                    return;
+                }
+                scheduler_.setRate(rate * share_);
+                targetRate_ = static_cast<quint32>(qMin(rate, 4e9));
+            }
+
+            publishMessage(intendedNs);
+            if (!scheduler_.advance())
+            {
+                return;
+            }
+            now = monotonicNs();
+        }
+
+        if (generation != sendGeneration_)
+        {
+            return;
+        }
+        QTimer::singleShot(scheduler_.delayMsec(now), Qt::PreciseTimer, this, [this, generation]() { sendMessage(generation); });
+    }
 
-        //     qDebug() << "Publisher> " << hexMsg << ", Timestamp: " << currentTime;
-        //     emit messageSent(currentTime, hexMsg);
-        // }
-        // else
+private:
+    void startReplay()
+    {
+        ++replayGeneration_;
+        QString error;
+        replayCursor_ = replay_.open(replayPath_, &error) ? replay_.first() : CaptureCursor();
+        if (!replayCursor_.isValid())
         {
-            socket_->sendMessage(msg);
+            emit signal_log(1, QString("Replay of %1 failed: %2").arg(replayPath_, error.isEmpty() ? QString("No messages") : error));
+            replay_.close();
+            return;
+        }
+
+        stampFrame_ = MessageStamp::makeFrame(publisherId_);
+        replaying_ = true;
+        replayOriginNs_ = replayCursor_.receiveNs();
+        replayStartNs_ = monotonicNs();
+        nextEchoNs_ = 0;
+        replayMessages(replayGeneration_);
+    }
 
-            qDebug() << "Publisher> " << msg << ", Timestamp: " << currentTime;
-            emit messageSent(currentTime, msg);
+    void replayMessages(int generation)
+    {
+        if (generation != replayGeneration_ || !replaying_)
+        {
+            return;
         }
 
-        if (frequency_ != 0)
+        // Sends everything that is due. The due time of each message is derived from its recorded receive
+        // time, so replay does not drift when a timer fires late, it catches up with a burst instead.
+        qint64 now = monotonicNs();
+        qint64 dueNs = replayDueNs(now);
+        int burst = 0;
+        while (dueNs <= now)
         {
-            QTimer::singleShot(1000 / frequency_, this, SLOT(sendMessage()));
+            replayMessage(replayCursor_.frames(), dueNs);
+            if (!replayCursor_.next())
+            {
+                replaying_ = false;
+                replay_.close();
+                emit signal_log(0, QString("Replay of %1 finished").arg(replayPath_));
+                return;
+            }
+
+            now = monotonicNs();
+            dueNs = replayDueNs(now);
+            if (++burst >= MaxBurst)
+            {
+                break;
+            }
         }
+
+        int delay = dueNs > now ? static_cast<int>((dueNs - now) / 1000000) : 0;
+        QTimer::singleShot(delay, Qt::PreciseTimer, this, [this, generation]() { replayMessages(generation); });
+    }
+
+    // The time the current record is due, at maximum speed every record is due immediately
+    qint64 replayDueNs(qint64 nowNs) const
+    {
+        if (replaySpeed_ <= 0.0)
+        {
+            return nowNs;
+        }
+        return replayStartNs_ + static_cast<qint64>((replayCursor_.receiveNs() - replayOriginNs_) / replaySpeed_);
+    }
+
+    void replayMessage(const QList<QByteArray>& frames, qint64 dueNs)
+    {
+        if (frames.isEmpty())
+        {
+            return;
+        }
+
+        // A stamp of the recording publisher is replaced, otherwise subscribers would see stale sequences and times
+        QList<QByteArray> msg = frames;
+        MessageStamp::View recorded;
+        if (msg.size() > 1 && MessageStamp::parse(msg.at(1), &recorded))
+        {
+            msg.removeAt(1);
+        }
+
+        if (stamped_)
+        {
+            QList<QByteArray> stampedMsg = msg;
+            quint64& sequence = sequences_[msg.at(0)];
+            MessageStamp::patch(stampFrame_.data(), sequence++, monotonicNs(), dueNs);
+            stampedMsg.insert(1, stampFrame_);
+            send(stampedMsg);
+        }
+        else
+        {
+            send(msg);
+        }
+
+        if (!echoDue(dueNs))
+        {
+            return;
+        }
+
+        // The frames refer to the reader buffer, the queued signal needs its own copy
+        QList<QByteArray> echo;
+        for (const QByteArray& frame : msg)
+        {
+            echo += QByteArray(frame.constData(), frame.size());
+        }
+        emit messageSent(getCurrentTime(), echo);
+    }
+
+    bool send(const QList<QByteArray>& msg)
+    {
+        bool sent = socket_->sendMessage(msg);
+        if (stats_)
+        {
+            quint64 size = 0;
+            for (const QByteArray& frame : msg)
+            {
+                size += frame.size();
+            }
+            stats_->record(size, sent);
+        }
+        return sent;
+    }
+
+    void useTopics(const TopicSampler& topics)
+    {
+        // Sequences continue where the previous run of a topic stopped, subscribers would report duplicates otherwise
+        for (int i = 0; i < topics_.size(); ++i)
+        {
+            sequences_.insert(topics_.topic(i), topicSequences_.at(i));
+        }
+
+        topics_ = topics;
+        topicSequences_.resize(topics_.size());
+        topicFrames_.resize(topics_.size());
+        for (int i = 0; i < topics_.size(); ++i)
+        {
+            topicSequences_[i] = sequences_.value(topics_.topic(i));
+            topicFrames_[i].reset(topics_.topic(i));
+        }
+    }
+
+    // Upper bound of messages sent per timer event, keeps the event loop responsive while catching up
+    static const int MaxBurst = 1000;
+    static const qint64 EchoIntervalNs = 50 * 1000000LL;
+
+    void publishMessage(qint64 intendedNs)
+    {
+        if (streaming_)
+        {
+            queueStream();
+            return;
+        }
+
+        // Nothing is encoded here: the topic and payload frames are cached ZeroMQ messages sent as copies,
+        // which does not allocate, and the frames are sent one by one instead of being collected in a list.
+        // The stamp frame is patched in place and copied into a message of its own, its only allocation.
+        const ZMQSocket::SendFlags more = ZMQSocket::SND_MORE | ZMQSocket::SND_DONTWAIT;
+        int topic = topics_.size() > 1 ? topics_.sample(random_) : 0;
+        const QByteArray& topicFrame = topics_.topic(topic);
+        bool mapped = mappedPayload_.isOpen();
+        int rendered = 0;
+        if (templated_)
+        {
+            MessageTemplate::Fields fields = { templateSequence_++, wallOffsetNs_ + intendedNs, intendedNs, publisherId_, &topicFrame };
+            rendered = template_.render(fields, random_);
+        }
+        quint64 size = topicFrame.size() + (mapped ? mappedPayload_.nextSize() : seeded_ ? seededSize_ : templated_ ? rendered : payload_.size());
+        bool stamp = stamped_ || seeded_;
+        quint64 sequence = stamp ? topicSequences_[topic]++ : 0;
+
+        // A file slice is echoed by its first bytes, taken before send() moves on to the next slice
+        bool echo = echoDue(intendedNs);
+        QByteArray preview = echo && mapped ? mappedPayload_.preview() : QByteArray();
+
+        bool sent = topicFrames_.at(topic).send(socket_, more);
+        if (sent && stamp)
+        {
+            // The stamp frame goes between topic and payload so that topic filtering is unaffected
+            MessageStamp::patch(stampFrame_.data(), sequence, monotonicNs(), intendedNs);
+            MessageStamp::patchTargetRate(stampFrame_.data(), targetRate_);
+            sent = socket_->sendMessage(stampFrame_, more);
+            size += stampFrame_.size();
+        }
+        if (sent)
+        {
+            if (mapped)
+            {
+                sent = mappedPayload_.send(socket_, ZMQSocket::SND_DONTWAIT);
+            }
+            else if (seeded_)
+            {
+                // Every message has bytes of its own, they are generated straight into the ZeroMQ buffer it allocates
+                ZMQMessage msg(static_cast<size_t>(seededSize_));
+                SeededPayload::fill(static_cast<char*>(msg.data()), seededSize_, SeededPayload::seed(publisherId_, topicFrame, sequence));
+                sent = socket_->sendMessage(msg, ZMQSocket::SND_DONTWAIT);
+            }
+            else if (templated_)
+            {
+                // libzmq owns the bytes it sends, the rendered message is copied once into its buffer,
+                // which libzmq allocates unless the message fits into its 33 inline bytes
+                ZMQMessage msg(rendered);
+                memcpy(msg.data(), template_.data(), rendered);
+                sent = socket_->sendMessage(msg, ZMQSocket::SND_DONTWAIT);
+            }
+            else
+            {
+                sent = payload_.send(socket_, ZMQSocket::SND_DONTWAIT);
+            }
+        }
+
+        if (stats_)
+        {
+            stats_->record(size, sent);
+        }
+
+        if (echo)
+        {
+            QList<QByteArray> msg;
+            msg += topicFrame;
+            msg += mapped ? preview : seeded_ ? seededEcho_ : templated_ ? QByteArray(template_.data(), rendered) : payloadHex_ ? hexText_ : payload_.bytes();
+            emit messageSent(getCurrentTime(), msg);
+        }
+    }
+
+    // Sends the rest of a half sent chunk so the next message on the socket is not glued to it, then drops the stream.
+    // Runs in the publisher thread, the socket belongs to it.
+    void closeStream()
+    {
+        if (chunkSender_.isActive() && !chunkSender_.finish(socket_, topics_.topic(streamTopic_), monotonicNs()))
+        {
+            emit signal_log(1, QString("The socket did not take the rest of a chunk, the next message may be malformed"));
+        }
+        chunkSender_.close();
+        pendingStreams_ = 0;
+        streamPumpScheduled_ = false;
+    }
+
+    // A stream that is due while the previous one is still being sent waits for it, a further one is dropped
+    void queueStream()
+    {
+        if (pendingStreams_ > 0)
+        {
+            if (stats_)
+            {
+                stats_->record(0, false);
+            }
+            return;
+        }
+
+        ++pendingStreams_;
+        if (!streamPumpScheduled_)
+        {
+            pumpStream(sendGeneration_);
+        }
+    }
+
+    // Sends chunks while credits are available. Credits come back from ZeroMQ's I/O thread, so the
+    // window is polled every millisecond until the stream is out.
+    void pumpStream(int generation)
+    {
+        if (generation != sendGeneration_)
+        {
+            return;
+        }
+        streamPumpScheduled_ = false;
+
+        ChunkSender::Result result = ChunkSender::RESULT_IDLE;
+        for (int burst = 0; burst < MaxBurst; ++burst)
+        {
+            if (!chunkSender_.isActive())
+            {
+                if (pendingStreams_ == 0 || !chunkSender_.begin(publisherId_, monotonicNs()))
+                {
+                    pendingStreams_ = 0;
+                    return;
+                }
+                --pendingStreams_;
+                streamTopic_ = topics_.size() > 1 ? topics_.sample(random_) : 0;
+
+                qint64 now = monotonicNs();
+                if (echoDue(now))
+                {
+                    QList<QByteArray> msg;
+                    msg += topics_.topic(streamTopic_);
+                    msg += QString("Stream %1: %2 bytes in %3 chunks")
+                        .arg(chunkSender_.streamId()).arg(chunkSender_.totalSize()).arg(chunkSender_.chunkCount()).toLocal8Bit();
+                    emit messageSent(getCurrentTime(), msg);
+                }
+            }
+
+            quint64 size = 0;
+            result = chunkSender_.sendNext(socket_, topics_.topic(streamTopic_), monotonicNs(), &size);
+            if (result != ChunkSender::RESULT_SENT)
+            {
+                break;
+            }
+            if (stats_)
+            {
+                stats_->record(size, true);
+            }
+        }
+
+        if (result == ChunkSender::RESULT_FAILED && stats_)
+        {
+            stats_->record(0, false);
+        }
+
+        streamPumpScheduled_ = true;
+        QTimer::singleShot(result == ChunkSender::RESULT_SENT ? 0 : 1, Qt::PreciseTimer, this, [this, generation]() { pumpStream(generation); });
+    }
+
+    // The GUI cannot keep up with every message, at most one per EchoIntervalNs is echoed
+    bool echoDue(qint64 nowNs)
+    {
+        if (nowNs < nextEchoNs_)
+        {
+            return false;
+        }
+        nextEchoNs_ = nowNs + EchoIntervalNs;
+        return true;
     }
 
-private:
     QString address_;
     QString topic_;
     QString message_;
-    int frequency_;
+    QByteArray hexText_;        // The hex dump payload_ was decoded from, echoed instead of the binary bytes
+    CachedFrame payload_;
+    QString payloadPath_;
+    qint64 payloadSliceSize_;
+    MappedPayload mappedPayload_;
+    qint64 seededSize_;
+    bool seeded_;               // The messages carry a SeededPayload of seededSize_ bytes
+    QByteArray seededEcho_;     // Shown instead of the random bytes
+    MessageTemplate template_;
+    bool templated_;            // The message has fields, it is rendered from template_
+    quint64 templateSequence_;  // ${seq}, keeps counting across restarts so that payloads stay unique
+    qint64 wallOffsetNs_;       // Epoch time minus monotonic time, turns due times into ${ts}
+    bool streaming_;
+    qint64 chunkSize_;
+    int chunkWindow_;
+    ChunkSender chunkSender_;
+    int pendingStreams_;        // Streams that are due but not started yet
+    int streamTopic_;           // Topic of the active stream
+    bool streamPumpScheduled_;
+    LoadProfile profile_;
+    double share_;
+    double phase_;
+    bool connect_;
     bool useHex_;
+    bool payloadHex_;           // payload_ holds the decoded bytes of message_
+    bool stamped_;
+    quint32 publisherId_;
+    RateScheduler scheduler_;
+    quint32 targetRate_;        // Rate of the profile when the current message is due, sent in the stamp
+    qint64 profileStartNs_;
+    int sendGeneration_;        // Counts starts and stops
+    QByteArray stampFrame_;
+    TopicSampler pendingTopics_;
+    TopicSampler topics_;
+    QVector<quint64> topicSequences_;   // Indexed like topics_
+    QVector<CachedFrame> topicFrames_;  // Indexed like topics_
+    FastRandom random_;
+    qint64 nextEchoNs_;
+    QHash<QByteArray, quint64> sequences_;
+    QString replayPath_;
+    double replaySpeed_;
+    bool replaying_;
+    int replayGeneration_;
+    MappedCapture replay_;
+    CaptureCursor replayCursor_;
+    qint64 replayOriginNs_;     // Recorded receive time of the first message
+    qint64 replayStartNs_;      // Monotonic time the first message was replayed
+    QSharedPointer<PublisherStats> stats_;
     ZMQSocket* socket_;
 };
 
@@ -0,0 +1,82 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_PUBLISHERSTATS_H
+#define NZMQT_PUBLISHERSTATS_H
+
+#include <QAtomicInteger>
+#include <QSharedPointer>
+#include <QVector>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Publisher Stats:
+Counters of one publisher worker. Each worker owns its counters and is their only writer, so an
+increment is a relaxed load and store without a locked instruction. Readers on other threads sum the
+counters of all workers whenever they like. Every instance fills its own cache line, which keeps
+workers on different cores from invalidating each other's counters.
+*/
+struct alignas(64) PublisherStats
+{
+    QAtomicInteger<quint64> messages;
+    QAtomicInteger<quint64> bytes;
+    QAtomicInteger<quint64> failures;   // Messages the socket did not accept, e.g. on a send timeout
+
+    PublisherStats()
+        : messages(0), bytes(0), failures(0)
+    {
+    }
+
+    // Must only be called by the owning worker
+    void record(quint64 size, bool sent)
+    {
+        if (sent)
+        {
+            messages.storeRelaxed(messages.loadRelaxed() + 1);
+            bytes.storeRelaxed(bytes.loadRelaxed() + size);
+        }
+        else
+        {
+            failures.storeRelaxed(failures.loadRelaxed() + 1);
+        }
+    }
+};
+
+typedef QVector<QSharedPointer<PublisherStats> > PublisherStatsList;
+
+// Sum of the counters of several workers
+struct PublisherTotals
+{
+    quint64 messages;
+    quint64 bytes;
+    quint64 failures;
+
+    PublisherTotals()
+        : messages(0), bytes(0), failures(0)
+    {
+    }
+
+    static PublisherTotals collect(const PublisherStatsList& workers)
+    {
+        PublisherTotals totals;
+        for (const QSharedPointer<PublisherStats>& stats : workers)
+        {
+            totals.messages += stats->messages.loadRelaxed();
+            totals.bytes += stats->bytes.loadRelaxed();
+            totals.failures += stats->failures.loadRelaxed();
+        }
+        return totals;
+    }
+};
+
+}
+
+}
+
+#endif // NZMQT_PUBLISHERSTATS_H
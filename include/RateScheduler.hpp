@@ -0,0 +1,98 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_RATESCHEDULER_H
+#define NZMQT_RATESCHEDULER_H
+
+#include <QtGlobal>
+
+#include <cmath>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Rate Scheduler:
+Hands out the intended send time of every message for a given rate. The schedule is fixed when
+start() is called and does not move if the sender falls behind: a stalled sender finds intended
+times in the past and is expected to catch up, while the stamped intended time lets the Subscriber
+measure latency without coordinated omission.
+*/
+class RateScheduler
+{
+public:
+    RateScheduler()
+        : rate_(0.0), periodNs_(0.0), nextNs_(0.0)
+    {
+    }
+
+    /**
+     * @brief Starts a new schedule.
+     * @param startNs The monotonic time the first message is due.
+     * @param rate Messages per second, 0 schedules a single message.
+     * @return None
+     */
+    void start(qint64 startNs, double rate)
+    {
+        nextNs_ = static_cast<double>(startNs);
+        setRate(rate);
+    }
+
+    /**
+     * @brief Changes the rate, the message that is due next keeps its intended time.
+     * @param rate Messages per second, 0 stops the schedule after the next message.
+     * @return None
+     */
+    void setRate(double rate)
+    {
+        rate_ = qMax(0.0, rate);
+        periodNs_ = rate_ > 0.0 ? 1e9 / rate_ : 0.0;
+    }
+
+    double rate() const { return rate_; }
+    qint64 periodNs() const { return static_cast<qint64>(periodNs_); }
+
+    // Kept as double so that periods which are not a whole number of nanoseconds do not drift
+    qint64 nextIntendedNs() const { return static_cast<qint64>(nextNs_); }
+
+    bool isDue(qint64 nowNs) const { return nextNs_ <= static_cast<double>(nowNs); }
+
+    /**
+     * @brief Moves on to the next message.
+     * @param None
+     * @return False if the schedule is finished because the rate is 0.
+     */
+    bool advance()
+    {
+        nextNs_ += periodNs_;
+        return rate_ > 0.0;
+    }
+
+    /**
+     * @brief Returns how long a timer should wait for the next message.
+     * @param nowNs The current monotonic time.
+     * @return The delay in milliseconds rounded up, 0 if the next message is already due.
+     * @note Rounding down would wake the sender before the message is due. Periods below a
+     *       millisecond are paced by sending everything that became due after each wakeup.
+     */
+    int delayMsec(qint64 nowNs) const
+    {
+        double delayNs = nextNs_ - static_cast<double>(nowNs);
+        return delayNs <= 0.0 ? 0 : static_cast<int>(std::ceil(qMin(delayNs, 1e15) / 1e6));
+    }
+
+private:
+    double rate_;
+    double periodNs_;
+    double nextNs_;
+};
+
+}
+
+}
+
+#endif // NZMQT_RATESCHEDULER_H
@@ -0,0 +1,310 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_RATESEARCH_H
+#define NZMQT_RATESEARCH_H
+
+#include "HdrHistogram.hpp"
+
+#include <QMetaType>
+#include <QVector>
+
+#include <cmath>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+// Latency and loss of one search step, measured by the Subscriber
+struct StepMeasurement
+{
+    quint32 targetRate;
+    double sendRate;            // Messages per second the publishers achieved while the Subscriber measured
+    quint64 received;
+    quint64 missing;
+    qint64 p50;
+    qint64 p99;
+    qint64 p999;
+    qint64 max;
+    QVector<qint64> windowP99;  // p99 of every sub window, the spread gives the confidence interval
+
+    StepMeasurement()
+        : targetRate(0), sendRate(0.0), received(0), missing(0), p50(0), p99(0), p999(0), max(0)
+    {
+    }
+
+    // Deviation of the achieved send rate from the target, 0.1 is 10 % too slow or too fast
+    double sendRateError() const
+    {
+        return targetRate == 0 ? 0.0 : std::fabs(sendRate / targetRate - 1.0);
+    }
+
+    double lossRate() const
+    {
+        quint64 expected = received + missing;
+        return expected == 0 ? 0.0 : static_cast<double>(missing) / expected;
+    }
+
+    /**
+     * @brief Returns the 95 % confidence interval of the p99 latency from the sub window values.
+     * @param low Receives the lower bound.
+     * @param high Receives the upper bound.
+     * @return False if there are less than two sub windows.
+     * @note The sub windows are treated as batch means, which holds as long as a sub window is
+     *       much longer than the correlation time of the latency.
+     */
+    bool p99Interval(double* low, double* high) const
+    {
+        int n = windowP99.size();
+        if (n < 2)
+        {
+            return false;
+        }
+
+        double mean = 0.0;
+        for (qint64 value : windowP99)
+        {
+            mean += value;
+        }
+        mean /= n;
+
+        double variance = 0.0;
+        for (qint64 value : windowP99)
+        {
+            variance += (value - mean) * (value - mean);
+        }
+        variance /= n - 1;
+
+        // Two sided 97.5 % quantiles of Student's t distribution for 1 to 30 degrees of freedom
+        static const double t[] = {
+            12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+            2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+            2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+        };
+        double quantile = n - 1 <= 30 ? t[n - 2] : 1.96;
+        double halfWidth = quantile * std::sqrt(variance / n);
+        *low = qMax(0.0, mean - halfWidth);
+        *high = mean + halfWidth;
+        return true;
+    }
+};
+
+/*
+Step Meter:
+Collects the stamped messages of one search step on the Subscriber side. Only messages whose stamp
+carries the target rate of the step are counted, so stragglers of the previous step and the warm up
+do not leak into the measurement. rotate() closes a sub window.
+*/
+class StepMeter
+{
+public:
+    StepMeter()
+        : active_(false)
+    {
+    }
+
+    bool isActive() const { return active_; }
+
+    void start(quint32 targetRate)
+    {
+        measurement_ = StepMeasurement();
+        measurement_.targetRate = targetRate;
+        total_.reset();
+        window_.reset();
+        active_ = true;
+    }
+
+    void record(quint32 targetRate, qint64 latencyNs)
+    {
+        if (active_ && targetRate == measurement_.targetRate)
+        {
+            total_.record(latencyNs);
+            window_.record(latencyNs);
+            ++measurement_.received;
+        }
+    }
+
+    void addMissing(quint32 targetRate, quint64 missing)
+    {
+        if (active_ && targetRate == measurement_.targetRate)
+        {
+            measurement_.missing += missing;
+        }
+    }
+
+    void rotate()
+    {
+        if (window_.totalCount() != 0)
+        {
+            measurement_.windowP99.append(window_.valueAtPercentile(99.0));
+        }
+        window_.reset();
+    }
+
+    StepMeasurement finish()
+    {
+        rotate();
+        measurement_.p50 = total_.valueAtPercentile(50.0);
+        measurement_.p99 = total_.valueAtPercentile(99.0);
+        measurement_.p999 = total_.valueAtPercentile(99.9);
+        measurement_.max = total_.max();
+        active_ = false;
+        return measurement_;
+    }
+
+private:
+    bool active_;
+    StepMeasurement measurement_;
+    HdrHistogram total_;
+    HdrHistogram window_;
+};
+
+// Limits and timing of a search
+struct RateSearchConfig
+{
+    double minRate;
+    double maxRate;
+    double precision;       // The search ends when the failing rate is at most this fraction above the passing one
+    qint64 p99LimitNs;
+    qint64 p999LimitNs;
+    double lossLimit;       // Fraction of messages
+    double rateTolerance;   // Largest deviation of the achieved send rate from the target, as a fraction
+    int warmupMsec;
+    int measureMsec;
+
+    RateSearchConfig()
+        : minRate(1000.0), maxRate(1000000.0), precision(0.05)
+        , p99LimitNs(1000000), p999LimitNs(5000000), lossLimit(0.0001), rateTolerance(0.02)
+        , warmupMsec(2000), measureMsec(10000)
+    {
+    }
+};
+
+struct RateSearchStep
+{
+    StepMeasurement measurement;
+    bool passed;
+};
+
+struct RateSearchResult
+{
+    bool found;             // False if already the minimum rate failed
+    double bestRate;        // Highest rate that met the limits
+    double failedRate;      // Lowest rate above it that did not, 0 if the maximum rate passed
+    StepMeasurement best;
+    QVector<RateSearchStep> steps;
+};
+
+/*
+Rate Search:
+Finds the highest rate that meets the latency and loss limits. Starting at the minimum rate the rate
+doubles while the limits are met. The first failing rate brackets the result, which is narrowed by
+bisecting in log space until the bracket is within the requested precision. The search assumes
+that a system which fails at one rate also fails at every higher rate.
+A step also fails when the publishers did not send at its rate: latency measured at a lower rate
+says nothing about the target, and a higher one means the pacing is broken.
+*/
+class RateSearch
+{
+public:
+    RateSearch()
+        : rate_(0.0), passed_(0.0), failed_(0.0), finished_(true)
+    {
+    }
+
+    void start(const RateSearchConfig& config)
+    {
+        config_ = config;
+        config_.minRate = qMax(1.0, config_.minRate);
+        config_.maxRate = qMax(config_.minRate, config_.maxRate);
+        result_ = RateSearchResult();
+        result_.found = false;
+        result_.bestRate = 0.0;
+        result_.failedRate = 0.0;
+        rate_ = config_.minRate;
+        passed_ = 0.0;
+        failed_ = 0.0;
+        finished_ = false;
+    }
+
+    const RateSearchConfig& config() const { return config_; }
+    bool isFinished() const { return finished_; }
+
+    // The rate of the step to run next
+    double rate() const { return rate_; }
+
+    bool meetsLimits(const StepMeasurement& measurement) const
+    {
+        return measurement.received != 0
+            && measurement.sendRateError() <= config_.rateTolerance
+            && measurement.p99 <= config_.p99LimitNs
+            && measurement.p999 <= config_.p999LimitNs
+            && measurement.lossRate() <= config_.lossLimit;
+    }
+
+    /**
+     * @brief Accounts the measurement of the current step and picks the next rate.
+     * @param measurement The measurement taken at rate().
+     * @return True if the step met the limits.
+     */
+    bool report(const StepMeasurement& measurement)
+    {
+        RateSearchStep step;
+        step.measurement = measurement;
+        step.passed = meetsLimits(measurement);
+        result_.steps.append(step);
+
+        if (step.passed)
+        {
+            passed_ = rate_;
+            result_.found = true;
+            result_.bestRate = rate_;
+            result_.best = measurement;
+        }
+        else
+        {
+            failed_ = rate_;
+            result_.failedRate = rate_;
+        }
+
+        if (passed_ == 0.0 || passed_ >= config_.maxRate)
+        {
+            // The minimum already fails or the maximum passes
+            finished_ = true;
+        }
+        else if (failed_ == 0.0)
+        {
+            rate_ = qMin(rate_ * 2.0, config_.maxRate);
+        }
+        else if (failed_ / passed_ - 1.0 <= config_.precision)
+        {
+            finished_ = true;
+        }
+        else
+        {
+            rate_ = std::sqrt(passed_ * failed_);
+        }
+        return step.passed;
+    }
+
+    const RateSearchResult& result() const { return result_; }
+
+private:
+    RateSearchConfig config_;
+    RateSearchResult result_;
+    double rate_;
+    double passed_;
+    double failed_;
+    bool finished_;
+};
+
+}
+
+}
+
+Q_DECLARE_METATYPE(nzmqt::samples::StepMeasurement)
+
+#endif // NZMQT_RATESEARCH_H
@@ -0,0 +1,230 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_RATESEARCHCONTROLLER_H
+#define NZMQT_RATESEARCHCONTROLLER_H
+
+#include "Publisher.hpp"
+#include "PublisherStats.hpp"
+#include "RateSearch.hpp"
+#include "TopicSampler.hpp"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+#include <QTimer>
+
+#include <cmath>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Rate Search Controller:
+Drives the publisher workers through the steps of a RateSearch. Every step stops the workers, waits
+for the queues to drain, restarts them at the step's rate and lets them warm up before it asks the
+Subscriber to measure. The measurement comes back through measurementFinished(), the controller
+adds the rate the workers achieved over the same time from their PublisherStats. The controller
+lives in the GUI thread like the code that starts the publishers; signals to the Subscriber are
+queued into its thread.
+*/
+class RateSearchController : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int DrainMsec = 200;
+    static const int ResultTimeoutMsec = 3000;
+
+    explicit RateSearchController(QObject* parent = 0)
+        : QObject(parent), currentRate_(0), sentAtStart_(0), sendRate_(0.0), running_(false), waiting_(false), generation_(0)
+    {
+    }
+
+    bool isRunning() const { return running_; }
+
+    const RateSearch& search() const { return search_; }
+
+    /**
+     * @brief Starts a search, the publishers must already run in their threads.
+     * @param config The limits and timing of the search.
+     * @param publishers The publisher workers, they share the rate of a step.
+     * @param messages The topic and message as passed to Publisher::startAction().
+     * @param topics The topic set the workers spread the messages over.
+     * @param stats The counters of the workers, they give the achieved send rate of a step.
+     * @return None
+     */
+    void start(const RateSearchConfig& config, const QList<pubsub::Publisher*>& publishers,
+               const QStringList& messages, const TopicSampler& topics, const PublisherStatsList& stats)
+    {
+        abort();
+        publishers_.clear();
+        for (pubsub::Publisher* publisher : publishers)
+        {
+            publishers_.append(publisher);
+        }
+        messages_ = messages;
+        topics_ = topics;
+        stats_ = stats;
+        search_.start(config);
+        running_ = true;
+        runStep();
+    }
+
+    // Stops the search and the publishers, nothing is emitted
+    void abort()
+    {
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+        waiting_ = false;
+        ++generation_;
+        stopPublishers();
+    }
+
+signals:
+    // The Subscriber starts and finishes its measurement on these, see Subscriber::startMeasurement()
+    void measurementStarted(quint32 targetRate);
+    void measurementRequested();
+
+    void stepStarted(double rate);
+    void stepFinished(const nzmqt::samples::StepMeasurement& measurement, bool passed);
+    void searchFinished();
+    void searchFailed(const QString& reason);
+
+public slots:
+    void measurementFinished(const nzmqt::samples::StepMeasurement& measurement)
+    {
+        if (!waiting_ || measurement.targetRate != currentRate_)
+        {
+            return;
+        }
+        waiting_ = false;
+
+        StepMeasurement step = measurement;
+        step.sendRate = sendRate_;
+        bool passed = search_.report(step);
+        emit stepFinished(step, passed);
+        if (search_.isFinished())
+        {
+            running_ = false;
+            ++generation_;
+            stopPublishers();
+            emit searchFinished();
+        }
+        else
+        {
+            runStep();
+        }
+    }
+
+private:
+    void runStep()
+    {
+        // Rates are whole messages per second, the same value the stamps and the meter compare
+        currentRate_ = static_cast<quint32>(qBound(1.0, std::floor(search_.rate() + 0.5), 4e9));
+        emit stepStarted(currentRate_);
+
+        stopPublishers();
+        int generation = ++generation_;
+        const RateSearchConfig& config = search_.config();
+        QTimer::singleShot(DrainMsec, this, [this, generation]() {
+            if (generation == generation_)
+            {
+                startPublishers();
+            }
+        });
+        QTimer::singleShot(DrainMsec + config.warmupMsec, this, [this, generation]() {
+            if (generation == generation_)
+            {
+                sentAtStart_ = PublisherTotals::collect(stats_).messages;
+                measureTimer_.start();
+                emit measurementStarted(currentRate_);
+            }
+        });
+        QTimer::singleShot(DrainMsec + config.warmupMsec + config.measureMsec, this, [this, generation]() {
+            if (generation == generation_)
+            {
+                quint64 sent = PublisherTotals::collect(stats_).messages - sentAtStart_;
+                qint64 elapsedNs = measureTimer_.nsecsElapsed();
+                sendRate_ = elapsedNs > 0 ? sent * 1e9 / elapsedNs : 0.0;
+                waiting_ = true;
+                emit measurementRequested();
+            }
+        });
+        QTimer::singleShot(DrainMsec + config.warmupMsec + config.measureMsec + ResultTimeoutMsec, this, [this, generation]() {
+            if (generation == generation_ && waiting_)
+            {
+                abort();
+                emit searchFailed(tr("The subscriber did not report the measurement"));
+            }
+        });
+    }
+
+    // The publishers run in their own threads, each step is queued there behind the previous one
+    void startPublishers()
+    {
+        int count = publishers_.size();
+        LoadProfile profile = LoadProfile::constant(currentRate_);
+        for (int i = 0; i < count; ++i)
+        {
+            pubsub::Publisher* publisher = publishers_.at(i);
+            if (publisher)
+            {
+                double share = 1.0 / count;
+                double phase = static_cast<double>(i) / count;
+                TopicSampler topics = topics_;
+                QStringList messages = messages_;
+                QMetaObject::invokeMethod(publisher, [publisher, profile, share, phase, topics, messages]() {
+                    publisher->setLoadProfile(profile);
+                    publisher->setShare(share);
+                    publisher->setPhase(phase);
+                    publisher->setReplay(QString(), 1.0);
+                    publisher->setStamped(true);
+                    publisher->setStreaming(false, 0, 1);
+                    publisher->setTopics(topics);
+                    publisher->startAction(messages);
+                }, Qt::QueuedConnection);
+            }
+        }
+    }
+
+    void stopPublishers()
+    {
+        for (const QPointer<pubsub::Publisher>& publisher : publishers_)
+        {
+            if (publisher)
+            {
+                pubsub::Publisher* target = publisher;
+                QMetaObject::invokeMethod(target, [target]() { target->stopAction(); }, Qt::QueuedConnection);
+            }
+        }
+    }
+
+    RateSearch search_;
+    QList<QPointer<pubsub::Publisher> > publishers_;
+    QStringList messages_;
+    TopicSampler topics_;
+    PublisherStatsList stats_;
+    quint32 currentRate_;
+    quint64 sentAtStart_;   // Messages the workers had sent when the measurement of the step started
+    QElapsedTimer measureTimer_;
+    double sendRate_;       // Achieved by the workers during the measurement of the step
+    bool running_;
+    bool waiting_;          // The Subscriber was asked for the measurement
+    int generation_;        // Timers of an earlier step or search compare against it and do nothing
+};
+
+}
+
+}
+
+#endif // NZMQT_RATESEARCHCONTROLLER_H
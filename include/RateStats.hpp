@@ -0,0 +1,180 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_RATESTATS_H
+#define NZMQT_RATESTATS_H
+
+#include "HdrHistogram.hpp"
+#include "LatencyStats.hpp"
+
+#include <QMetaType>
+#include <QVector>
+
+#include <cmath>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+// Latency and loss of the messages that were due while the publishers targeted rates in [lowRate, highRate)
+struct RateBand
+{
+    double lowRate;
+    double highRate;
+    quint64 received;
+    quint64 missing;
+    LatencySummary latency;     // Corrected latency, from the intended send time
+
+    double lossRate() const
+    {
+        quint64 expected = received + missing;
+        return expected == 0 ? 0.0 : static_cast<double>(missing) / expected;
+    }
+};
+
+// Bands with messages, ordered by rate
+typedef QVector<RateBand> RateReport;
+
+/*
+Rate Stats:
+Groups stamped messages by the target rate carried in their stamp. Bands are logarithmic with
+BandsPerDecade bands per factor of ten, so a ramp over several decades is resolved equally well at
+every rate. Walking the bands upwards shows the rate at which latency bends and loss sets in.
+A band's histogram is allocated when its first message arrives.
+*/
+class RateStats
+{
+    Q_DISABLE_COPY(RateStats)
+
+public:
+    static const int BandsPerDecade = 10;
+    static const int MaxBands = 9 * BandsPerDecade;     // Up to 10^9 msg/s
+
+    RateStats()
+        : bands_(MaxBands, 0), lastRate_(0), lastBand_(0)
+    {
+    }
+
+    ~RateStats()
+    {
+        qDeleteAll(bands_);
+    }
+
+    /**
+     * @brief Records the latency of one message.
+     * @param targetRate The target rate of the stamp, messages without one are ignored.
+     * @param latencyNs The latency in nanoseconds.
+     * @return None
+     */
+    void record(quint32 targetRate, qint64 latencyNs)
+    {
+        Band* band = bandFor(targetRate);
+        if (band)
+        {
+            band->histogram.record(latencyNs);
+            ++band->received;
+        }
+    }
+
+    // Accounts messages found missing when a message of the given target rate arrived
+    void addMissing(quint32 targetRate, quint64 missing)
+    {
+        Band* band = bandFor(targetRate);
+        if (band)
+        {
+            band->missing += missing;
+        }
+    }
+
+    bool isEmpty() const
+    {
+        for (const Band* band : bands_)
+        {
+            if (band)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void reset()
+    {
+        qDeleteAll(bands_);
+        bands_.fill(0);
+        lastRate_ = 0;
+        lastBand_ = 0;
+    }
+
+    RateReport report() const
+    {
+        RateReport report;
+        for (int i = 0; i < bands_.size(); ++i)
+        {
+            const Band* band = bands_.at(i);
+            if (band)
+            {
+                RateBand entry;
+                entry.lowRate = std::pow(10.0, static_cast<double>(i) / BandsPerDecade);
+                entry.highRate = std::pow(10.0, static_cast<double>(i + 1) / BandsPerDecade);
+                entry.received = band->received;
+                entry.missing = band->missing;
+                entry.latency = LatencySummary::fromHistogram(band->histogram);
+                report.append(entry);
+            }
+        }
+        return report;
+    }
+
+private:
+    struct Band
+    {
+        HdrHistogram histogram;
+        quint64 received;
+        quint64 missing;
+
+        Band()
+            : histogram(60LL * 1000000000LL, 2), received(0), missing(0)
+        {
+        }
+    };
+
+    Band* bandFor(quint32 targetRate)
+    {
+        // Consecutive messages mostly share their target rate, which saves the logarithm
+        if (targetRate == lastRate_)
+        {
+            return lastBand_;
+        }
+        lastRate_ = targetRate;
+        if (targetRate == 0)
+        {
+            lastBand_ = 0;
+            return 0;
+        }
+
+        int index = qBound(0, static_cast<int>(std::log10(static_cast<double>(targetRate)) * BandsPerDecade), MaxBands - 1);
+        Band*& band = bands_[index];
+        if (band == 0)
+        {
+            band = new Band;
+        }
+        lastBand_ = band;
+        return band;
+    }
+
+    QVector<Band*> bands_;
+    quint32 lastRate_;
+    Band* lastBand_;
+};
+
+}
+
+}
+
+Q_DECLARE_METATYPE(nzmqt::samples::RateReport)
+
+#endif // NZMQT_RATESTATS_H
@@ -35,6 +35,8 @@
 #include <QDateTime>
 #include <QElapsedTimer>
 
+#include <chrono>
+
 
 namespace nzmqt
 {
@@ -74,6 +76,8 @@ protected:
 
     virtual QString getCurrentTime();
 
+    static qint64 monotonicNs();
+
 private:
     class ThreadTools : private QThread
     {
@@ -170,6 +174,12 @@ inline QString SampleBase::getCurrentTime()
     return now.toString(format);
 }
 
+inline qint64 SampleBase::monotonicNs()
+{
+    // steady_clock maps to CLOCK_MONOTONIC / QueryPerformanceCounter, which are shared by all processes on a host
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 }
 
 }
@@ -0,0 +1,134 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_SEEDEDPAYLOAD_H
+#define NZMQT_SEEDEDPAYLOAD_H
+
+#include <QByteArray>
+#include <QtEndian>
+#include <QtGlobal>
+
+#include <cstring>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Seeded Payload:
+A payload frame whose bytes follow from the publisher id, topic and sequence number of its
+MessageStamp, so the Subscriber can check every byte of every message without a copy of what was
+sent. Word i of the payload is the splitmix64 finalizer of seed + (i + 1) * 2^64 / phi in little
+endian order, the last word is cut to the size of the frame. The words do not depend on each other,
+so generating and checking are a multiply-xorshift chain per 8 bytes that the compiler unrolls, and
+a mismatch is located at the exact byte. A frame of another topic, publisher or sequence, e.g. after
+a multipart mix-up, differs from the first word on.
+*/
+class SeededPayload
+{
+public:
+    /**
+     * @brief Derives the seed of one message.
+     * @param publisherId The publisher id of the stamp.
+     * @param topic The topic frame.
+     * @param sequence The sequence number of the stamp.
+     * @return The seed passed to fill() and verify().
+     */
+    static quint64 seed(quint32 publisherId, const QByteArray& topic, quint64 sequence)
+    {
+        // FNV-1a of the topic, topics are short
+        quint64 hash = 0xCBF29CE484222325ULL;
+        for (int i = 0; i < topic.size(); ++i)
+        {
+            hash = (hash ^ static_cast<uchar>(topic.at(i))) * 0x100000001B3ULL;
+        }
+        return mix(hash ^ (static_cast<quint64>(publisherId) << 32)) ^ mix(sequence);
+    }
+
+    // Writes the size bytes of the payload of seed to data
+    static void fill(char* data, qint64 size, quint64 seed)
+    {
+        qint64 words = size / 8;
+        for (qint64 i = 0; i < words; ++i)
+        {
+            qToLittleEndian<quint64>(word(seed, i), data + i * 8);
+        }
+
+        int tail = static_cast<int>(size - words * 8);
+        if (tail > 0)
+        {
+            uchar last[8];
+            qToLittleEndian<quint64>(word(seed, words), last);
+            memcpy(data + words * 8, last, tail);
+        }
+    }
+
+    /**
+     * @brief Compares received bytes with the payload of seed.
+     * @param data The received payload frame.
+     * @param size The number of bytes to compare.
+     * @param seed The seed of the message.
+     * @return The offset of the first byte that differs, -1 if all bytes match.
+     */
+    static qint64 verify(const char* data, qint64 size, quint64 seed)
+    {
+        qint64 words = size / 8;
+        for (qint64 i = 0; i < words; ++i)
+        {
+            quint64 diff = qFromLittleEndian<quint64>(data + i * 8) ^ word(seed, i);
+            if (diff != 0)
+            {
+                return i * 8 + firstByte(diff);
+            }
+        }
+
+        int tail = static_cast<int>(size - words * 8);
+        if (tail > 0)
+        {
+            uchar last[8];
+            qToLittleEndian<quint64>(word(seed, words), last);
+            for (int i = 0; i < tail; ++i)
+            {
+                if (static_cast<uchar>(data[words * 8 + i]) != last[i])
+                {
+                    return words * 8 + i;
+                }
+            }
+        }
+        return -1;
+    }
+
+private:
+    static quint64 mix(quint64 z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    static quint64 word(quint64 seed, qint64 index)
+    {
+        return mix(seed + static_cast<quint64>(index + 1) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    // Index of the lowest non-zero byte, the first one in memory for a little endian word
+    static int firstByte(quint64 diff)
+    {
+        int index = 0;
+        while ((diff & 0xFF) == 0)
+        {
+            diff >>= 8;
+            ++index;
+        }
+        return index;
+    }
+};
+
+}
+
+}
+
+#endif // NZMQT_SEEDEDPAYLOAD_H
@@ -0,0 +1,282 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_SEQUENCETRACKER_H
+#define NZMQT_SEQUENCETRACKER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMetaType>
+#include <QPair>
+#include <QVector>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+// Counters of one (publisher, topic) stream
+struct StreamLoss
+{
+    quint32 publisherId;
+    QByteArray topic;
+    quint64 firstSequence;  // A first sequence other than 0 means the subscriber joined late
+    quint64 highestSequence;
+    quint64 received;       // Unique messages, duplicates not included
+    quint64 missing;        // Sequence numbers skipped and not (yet) received out of order
+    quint64 gaps;
+    quint64 duplicates;
+    quint64 reordered;
+
+    StreamLoss()
+        : publisherId(0), firstSequence(0), highestSequence(0)
+        , received(0), missing(0), gaps(0), duplicates(0), reordered(0)
+    {
+    }
+
+    bool lateJoin() const { return firstSequence != 0; }
+
+    double lossRate() const
+    {
+        quint64 expected = received + missing;
+        return expected == 0 ? 0.0 : static_cast<double>(missing) / expected;
+    }
+};
+
+// A range of sequence numbers that was skipped when a later message arrived
+struct GapEvent
+{
+    quint32 publisherId;
+    QByteArray topic;
+    quint64 firstMissing;
+    quint64 lastMissing;
+    qint64 detectedNs;
+};
+
+// Loss of all streams during one sampling interval
+struct LossSample
+{
+    qint64 timeNs;
+    quint64 expected;
+    quint64 missing;
+
+    double lossRate() const { return expected == 0 ? 0.0 : static_cast<double>(missing) / expected; }
+};
+
+struct LossReport
+{
+    QVector<StreamLoss> streams;
+    QVector<LossSample> series;     // Oldest sample first
+    QVector<GapEvent> gaps;         // Gaps detected since the previous report
+};
+
+/*
+Sequence Tracker:
+Follows the sequence numbers of MessageStamp frames per (publisher, topic) stream. Besides the
+counters every stream holds the highest sequence seen and a 64 bit window of the sequences below
+it, which tells a duplicate from a late message that fills a gap. Messages older than the window
+are counted as reordered. Memory per stream is constant regardless of the message rate.
+*/
+class SequenceTracker
+{
+public:
+    static const int WindowSize = 64;
+    static const int MaxGapEvents = 1024;
+    static const int MaxSamples = 600;
+
+    enum Status
+    {
+        STS_IN_ORDER,
+        STS_FIRST,
+        STS_GAP,
+        STS_DUPLICATE,
+        STS_REORDERED
+    };
+
+    SequenceTracker()
+        : sampledExpected_(0), sampledMissing_(0), droppedGapEvents_(0)
+    {
+    }
+
+    /**
+     * @brief Accounts one stamped message.
+     * @param publisherId The publisher id of the stamp.
+     * @param topic The topic frame of the message.
+     * @param sequence The sequence number of the stamp.
+     * @param receiveNs The monotonic receive time, used to time stamp gap events.
+     * @param skipped Receives the number of sequences this message skipped if not null, 0 unless it opened a gap.
+     * @return How the message relates to the ones seen before.
+     */
+    Status track(quint32 publisherId, const QByteArray& topic, quint64 sequence, qint64 receiveNs, quint64* skipped = 0)
+    {
+        if (skipped)
+        {
+            *skipped = 0;
+        }
+
+        Stream& stream = streams_[StreamKey(publisherId, topic)];
+        StreamLoss& loss = stream.loss;
+
+        if (loss.received == 0 && loss.duplicates == 0)
+        {
+            loss.publisherId = publisherId;
+            loss.topic = topic;
+            loss.firstSequence = sequence;
+            loss.highestSequence = sequence;
+            loss.received = 1;
+            stream.window = 1;
+            return STS_FIRST;
+        }
+
+        if (sequence > loss.highestSequence)
+        {
+            quint64 distance = sequence - loss.highestSequence;
+            stream.window = distance >= WindowSize ? 1 : (stream.window << distance) | 1;
+            loss.highestSequence = sequence;
+            ++loss.received;
+            if (distance == 1)
+            {
+                return STS_IN_ORDER;
+            }
+
+            loss.missing += distance - 1;
+            ++loss.gaps;
+            if (skipped)
+            {
+                *skipped = distance - 1;
+            }
+            addGapEvent(publisherId, topic, sequence - distance + 1, sequence - 1, receiveNs);
+            return STS_GAP;
+        }
+
+        quint64 age = loss.highestSequence - sequence;
+        if (age < WindowSize)
+        {
+            quint64 bit = quint64(1) << age;
+            if (stream.window & bit)
+            {
+                ++loss.duplicates;
+                return STS_DUPLICATE;
+            }
+            stream.window |= bit;
+        }
+
+        // Arrived after a later message, it fills part of a gap that was counted as missing
+        ++loss.received;
+        ++loss.reordered;
+        if (sequence >= loss.firstSequence && loss.missing > 0)
+        {
+            --loss.missing;
+        }
+        return STS_REORDERED;
+    }
+
+    /**
+     * @brief Closes the current sampling interval and appends it to the loss time series.
+     * @param nowNs The monotonic time of the sample.
+     * @return None
+     */
+    void sample(qint64 nowNs)
+    {
+        quint64 expected = 0;
+        quint64 missing = 0;
+        for (const Stream& stream : streams_)
+        {
+            expected += stream.loss.received + stream.loss.missing;
+            missing += stream.loss.missing;
+        }
+
+        // Late messages may reduce the missing count below the previous sample
+        LossSample sample;
+        sample.timeNs = nowNs;
+        sample.expected = expected - sampledExpected_;
+        sample.missing = missing > sampledMissing_ ? missing - sampledMissing_ : 0;
+        sampledExpected_ = expected;
+        sampledMissing_ = missing;
+
+        if (series_.size() == MaxSamples)
+        {
+            series_.remove(0);
+        }
+        series_.append(sample);
+    }
+
+    /**
+     * @brief Builds a report and clears the gap events it contains.
+     * @param None
+     * @return The counters of all streams, the loss time series and the new gap events.
+     */
+    LossReport takeReport()
+    {
+        LossReport report;
+        report.streams.reserve(streams_.size());
+        for (const Stream& stream : streams_)
+        {
+            report.streams.append(stream.loss);
+        }
+        report.series = series_;
+        report.gaps = gapEvents_;
+        gapEvents_.clear();
+        return report;
+    }
+
+    // Gap events that did not fit in the event log
+    quint64 droppedGapEvents() const { return droppedGapEvents_; }
+
+    bool isEmpty() const { return streams_.isEmpty(); }
+
+    void reset()
+    {
+        streams_.clear();
+        series_.clear();
+        gapEvents_.clear();
+        sampledExpected_ = 0;
+        sampledMissing_ = 0;
+        droppedGapEvents_ = 0;
+    }
+
+private:
+    typedef QPair<quint32, QByteArray> StreamKey;
+
+    struct Stream
+    {
+        StreamLoss loss;
+        quint64 window;     // Bit n is set if highestSequence - n was received
+
+        Stream() : window(0) {}
+    };
+
+    void addGapEvent(quint32 publisherId, const QByteArray& topic, quint64 firstMissing, quint64 lastMissing, qint64 detectedNs)
+    {
+        if (gapEvents_.size() >= MaxGapEvents)
+        {
+            ++droppedGapEvents_;
+            return;
+        }
+
+        GapEvent event;
+        event.publisherId = publisherId;
+        event.topic = topic;
+        event.firstMissing = firstMissing;
+        event.lastMissing = lastMissing;
+        event.detectedNs = detectedNs;
+        gapEvents_.append(event);
+    }
+
+    QHash<StreamKey, Stream> streams_;
+    QVector<LossSample> series_;
+    QVector<GapEvent> gapEvents_;
+    quint64 sampledExpected_;
+    quint64 sampledMissing_;
+    quint64 droppedGapEvents_;
+};
+
+}
+
+}
+
+Q_DECLARE_METATYPE(nzmqt::samples::LossReport)
+
+#endif // NZMQT_SEQUENCETRACKER_H
@@ -28,11 +28,31 @@
 #define NZMQT_PUBSUBCLIENT_H
 
 #include "SampleBase.hpp"
+#include "CaptureWriter.hpp"
+#include "ChunkAssembler.hpp"
+#include "DisplayRing.hpp"
+#include "EndpointList.hpp"
+#include "EndpointStats.hpp"
+#include "HexCodec.hpp"
+#include "MessageStamp.hpp"
+#include "LatencyStats.hpp"
+#include "PayloadVerifier.hpp"
+#include "RateSearch.hpp"
+#include "RateStats.hpp"
+#include "SequenceTracker.hpp"
+#include "TopicMatcher.hpp"
+#include "TopicStats.hpp"
 
 #include "nzmqt/nzmqt.hpp"
 
 #include <QByteArray>
+#include <QDateTime>
+#include <QHash>
 #include <QList>
+#include <QPair>
+#include <QSharedPointer>
+#include <QThread>
+#include <QTimer>
 
 
 namespace nzmqt
@@ -44,6 +64,13 @@ namespace samples
 namespace pubsub
 {
 
+/*
+Subscriber:
+Connects to one or many publishers. The endpoints are spread over sockets, see EndpointList::shard(),
+and each socket gets a monitor whose events tell the connection state of its endpoints. All sockets
+deliver to the subscriber thread, so the statistics below stay single threaded and cover the whole
+fan-in; EndpointStats breaks traffic, latency and loss down by socket.
+*/
 class Subscriber : public SampleBase
 {
     Q_OBJECT
@@ -51,24 +78,98 @@ class Subscriber : public SampleBase
 
 public:
     explicit Subscriber(ZMQContext& context, const QString& address, const bool& useHex, QObject *parent = 0)
+        : Subscriber(context, QStringList(address), 1, useHex, parent)
+    {
+    }
+
+    /**
+     * @brief Creates a subscriber for many publishers.
+     * @param context The context of the sockets, give it more I/O threads for more sockets.
+     * @param endpoints The publishers, see EndpointList.hpp.
+     * @param sockets The number of SUB sockets the endpoints are spread over, 0 for one socket per endpoint.
+     * @param useHex Shows the payloads as hex.
+     * @param parent The parent object.
+     */
+    Subscriber(ZMQContext& context, const QStringList& endpoints, int sockets, const bool& useHex, QObject *parent = 0)
         : super(parent)
-        , address_(address), useHex_(useHex)
-        , socket_(0)
+        , shards_(EndpointList::shard(endpoints, sockets)), useHex_(useHex)
+        , backfill_(false)
+        , reportTimer_(0), topicStatsTimer_(0)
     {
-        socket_ = context.createSocket(ZMQSocket::TYP_SUB, this);
-        socket_->setObjectName("Subscriber.Socket.socket(SUB)");
-        connect(socket_, SIGNAL(messageReceived(const QList<QByteArray>&)), SLOT(subMessageReceived(const QList<QByteArray>&)));
+        for (int shard = 0; shard < shards_.size(); ++shard)
+        {
+            ZMQSocket* socket = context.createSocket(ZMQSocket::TYP_SUB, this);
+            socket->setObjectName(QString("Subscriber.Socket.socket(SUB).%1").arg(shard));
+            connect(socket, &ZMQSocket::messageReceived, this, [this, shard](const QList<QByteArray>& msg) { subMessageReceived(shard, msg); });
+            sockets_.append(socket);
+
+            // The monitor must exist before the socket connects, or the first events are lost
+            QString monitorAddress = QString("inproc://subscriber-monitor-%1-%2").arg(reinterpret_cast<quintptr>(this), 0, 16).arg(shard);
+            if (zmq_socket_monitor(static_cast<void*>(*socket), monitorAddress.toLatin1().constData(), EndpointStats::MonitorEvents) != 0)
+            {
+                qWarning() << "Subscriber> Cannot monitor" << shards_.at(shard) << ":" << zmq_strerror(zmq_errno());
+                continue;
+            }
+            ZMQSocket* monitor = context.createSocket(ZMQSocket::TYP_PAIR, this);
+            monitor->setObjectName(QString("Subscriber.Socket.monitor(PAIR).%1").arg(shard));
+            monitor->connectTo(monitorAddress);
+            connect(monitor, &ZMQSocket::messageReceived, this, [this, shard](const QList<QByteArray>& msg) {
+                endpointStats_.monitorEvent(shard, msg, monotonicNs());
+            });
+        }
     }
 
 signals:
+    // Emitted per message unless a display ring is set
     void messageReceived(const QString& timeStamp, const QList<QByteArray>& message);
 
+    // Emitted once per second while stamped messages arrive, see LatencyStats.hpp.
+    // The measured latency starts at the actual send time, the corrected one at the intended send time.
+    void latencyReported(const nzmqt::samples::LatencyReports& measured, const nzmqt::samples::LatencyReports& corrected);
+
+    // Emitted once per second while stamped messages arrive, see SequenceTracker.hpp
+    void lossReported(const nzmqt::samples::LossReport& report);
+
+    // Emitted once per second while messages stamped with a target rate arrive, see RateStats.hpp
+    void rateReported(const nzmqt::samples::RateReport& report);
+
+    // Emitted by finishMeasurement() with the messages of the step since startMeasurement()
+    void measurementFinished(const nzmqt::samples::StepMeasurement& measurement);
+
+    // Emitted once per second while streams complete or are given up, see ChunkAssembler.hpp
+    void streamReported(const nzmqt::samples::StreamReport& report);
+
+    // Emitted once per second while seeded payloads arrive, see PayloadVerifier.hpp
+    void integrityReported(const nzmqt::samples::IntegrityReport& report);
+
+    // Emitted once per second while recording and once when recording stops, see CaptureWriter.hpp
+    void captureReported(const nzmqt::samples::CaptureStatus& status);
+
+    // Emitted once per second, see EndpointStats.hpp
+    void endpointsReported(const nzmqt::samples::EndpointReport& report);
+
 protected:
     void initialize()
     {
         int receive_timeout = 2000;  // 2 seconds for receiving
-        socket_->setOption(ZMQSocket::OPT_RCVTIMEO, &receive_timeout, sizeof(receive_timeout));
-        socket_->connectTo(address_);
+        endpointStats_.setEndpoints(shards_, monotonicNs());
+        for (int shard = 0; shard < sockets_.size(); ++shard)
+        {
+            sockets_.at(shard)->setOption(ZMQSocket::OPT_RCVTIMEO, &receive_timeout, sizeof(receive_timeout));
+            for (const QString& endpoint : shards_.at(shard))
+            {
+                sockets_.at(shard)->connectTo(endpoint);
+            }
+        }
+
+        // Created here so that the timer lives in the subscriber thread
+        reportTimer_ = new QTimer(this);
+        connect(reportTimer_, SIGNAL(timeout()), SLOT(reportStats()));
+        reportTimer_->start(1000);
+
+        topicStatsTimer_ = new QTimer(this);
+        connect(topicStatsTimer_, SIGNAL(timeout()), SLOT(publishTopicStats()));
+        topicStatsTimer_->start(TopicStatsIntervalMsec);
     }
 
     void startImpl(const QStringList& topics)
@@ -78,9 +179,23 @@ protected:
             return;
         }
 
+        // The matcher and the sockets are used by the subscriber thread for every message, the GUI's
+        // call is handed over to that thread instead of changing them underneath it
+        if (QThread::currentThread() != thread())
+        {
+            QMetaObject::invokeMethod(this, [this, topics]() { startAction(topics); }, Qt::QueuedConnection);
+            return;
+        }
+
+        // A pattern subscribes the socket to its literal prefix, the matcher drops the rest on arrival
         for (auto& topic : topics)
         {
-            socket_->subscribeTo(topic);
+            QByteArray subscription = topic.toLocal8Bit();
+            topicMatcher_.add(subscription);
+            for (ZMQSocket* socket : sockets_)
+            {
+                socket->subscribeTo(TopicMatcher::upstreamPrefix(subscription));
+            }
         }
     }
 
@@ -91,12 +206,39 @@ protected:
             return;
         }
 
+        if (QThread::currentThread() != thread())
+        {
+            QMetaObject::invokeMethod(this, [this, topics]() { stopAction(topics); }, Qt::QueuedConnection);
+            return;
+        }
+
+        // ZeroMQ counts subscriptions, two patterns sharing a prefix subscribed it twice
         for (auto& topic : topics)
         {
-            socket_->unsubscribeFrom(topic);
+            QByteArray subscription = topic.toLocal8Bit();
+            topicMatcher_.remove(subscription);
+            for (ZMQSocket* socket : sockets_)
+            {
+                socket->unsubscribeFrom(TopicMatcher::upstreamPrefix(subscription));
+            }
         }
     }
 
+public:
+    static const int TopicStatsIntervalMsec = 100;
+
+    // Counts every received message per topic, set before the subscriber thread starts, see TopicStats.hpp
+    void setTopicStats(const QSharedPointer<TopicStats>& topicStats)
+    {
+        topicStats_ = topicStats;
+    }
+
+    // Collects the messages to show instead of emitting messageReceived() for each, set before the subscriber thread starts, see DisplayRing.hpp
+    void setDisplayRing(const QSharedPointer<DisplayRing>& displayRing)
+    {
+        displayRing_ = displayRing;
+    }
+
 public slots:
     void setUseHex()
     {
@@ -108,17 +250,163 @@ public slots:
         useHex_ = false;
     }
 
+    // Back-fills the measured histogram with the samples held back by a stalled publisher
+    void setBackfill(bool backfill)
+    {
+        backfill_ = backfill;
+    }
+
+    // Reassembles streamed payloads into files in the directory, an empty directory keeps them in memory
+    void setStreamDirectory(const QString& directory)
+    {
+        chunkAssembler_.setDirectory(directory);
+    }
+
+    // Segments of the next recording are named <prefix>.<index>.zcap, an empty prefix names them after the time
+    void setCapturePrefix(const QString& prefix)
+    {
+        capturePrefix_ = prefix;
+    }
+
+    // Writes in flight of the next recording
+    void setCaptureQueueDepth(int depth)
+    {
+        captureOptions_.queueDepth = depth;
+    }
+
+    // Bypasses the page cache in the next recording
+    void setCaptureDirectIo(bool direct)
+    {
+        captureOptions_.directIo = direct;
+    }
+
+    // Waits for the disk instead of dropping messages, also while recording
+    void setCaptureBlocking(bool block)
+    {
+        captureOptions_.backpressure = block ? CaptureOptions::BLOCK : CaptureOptions::DROP;
+        captureWriter_.setBackpressure(captureOptions_.backpressure);
+    }
+
+    // Builds the search index of each segment the next recording closes
+    void setCaptureSearchIndex(bool index)
+    {
+        captureOptions_.searchIndex = index;
+    }
+
+    // Records every received message into a capture while recording is on
+    void setRecording(bool recording)
+    {
+        if (recording == captureWriter_.isOpen())
+        {
+            return;
+        }
+
+        if (!recording)
+        {
+            captureWriter_.close();
+            emit captureReported(captureWriter_.status(monotonicNs()));
+            return;
+        }
+
+        QString prefix = capturePrefix_.isEmpty()
+            ? QString("capture-%1").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")) : capturePrefix_;
+        QString error;
+        if (!captureWriter_.open(prefix, monotonicNs(), captureOptions_, &error))
+        {
+            emit signal_log(1, QString("Could not record to %1: %2").arg(prefix, error));
+            return;
+        }
+        emit captureReported(captureWriter_.status(monotonicNs()));
+    }
+
+    // Starts measuring the stamped messages sent at the given target rate, see RateSearch.hpp
+    void startMeasurement(quint32 targetRate)
+    {
+        stepMeter_.start(targetRate);
+    }
+
+    void finishMeasurement()
+    {
+        if (stepMeter_.isActive())
+        {
+            emit measurementFinished(stepMeter_.finish());
+        }
+    }
+
 protected slots:
-    void subMessageReceived(const QList<QByteArray>& msg)
+    void subMessageReceived(int shard, const QList<QByteArray>& msg)
     {
+        // Take the receive time first, everything below only adds to the measured latency
+        qint64 receiveNs = monotonicNs();
+
+        int size = 0;
+        for (const QByteArray& frame : msg)
+        {
+            size += frame.size();
+        }
+        endpointStats_.record(shard, size, receiveNs);
+
+        // The socket only filtered by the prefix of a wildcard subscription
+        if (topicMatcher_.hasWildcards() && !msg.isEmpty() && !topicMatcher_.matches(msg.at(0)))
+        {
+            return;
+        }
+
+        if (topicStats_ && !msg.isEmpty())
+        {
+            topicStats_->record(msg.at(0), size, receiveNs);
+        }
+
+        // Records the frames as received, before any of them is interpreted
+        captureWriter_.write(msg, receiveNs);
+
+        // Chunks of a streamed payload are reassembled instead of being shown
+        ChunkHeader::View chunk;
+        if (msg.size() == 3 && ChunkHeader::parse(msg.at(1), &chunk))
+        {
+            chunkAssembler_.add(chunk, msg.at(2), receiveNs);
+            return;
+        }
+
+        // A stamped message carries the MessageStamp frame right after the topic, it is not shown to the user
+        MessageStamp::View stamp;
+        bool stamped = msg.size() > 1 && MessageStamp::parse(msg.at(1), &stamp);
+        if (stamped)
+        {
+            recordStamp(shard, msg.at(0), stamp, receiveNs);
+        }
+        bool seeded = stamped && stamp.isSeeded();
+        bool intact = seeded && payloadVerifier_.check(msg, stamp, receiveNs);
+
+        // Everything above is counted for every message, the display may drop it from here on
+        if (displayRing_ && !displayRing_->admit())
+        {
+            return;
+        }
+
         QList<QByteArray> plainMsg;
         QString currentTime = getCurrentTime();
 
+        if (seeded)
+        {
+            // The generated bytes mean nothing to the user, the outcome of the check is shown instead
+            plainMsg.append(msg.at(0));
+            plainMsg.append(QString("Seeded payload of %1 bytes, %2").arg(stamp.payloadSize()).arg(intact ? "intact" : "MISMATCH").toUtf8());
+            display(currentTime, plainMsg, false);
+            return;
+        }
+
+        int index = 0;
         bool isFirst = true;
         if (useHex_)
         {
             for (const QByteArray &data : msg)
             {
+                if (stamped && index++ == 1)
+                {
+                    continue;
+                }
+
                 if (isFirst)
                 {
                     plainMsg.append(data);
@@ -126,32 +414,162 @@ protected slots:
                     continue;
                 }
                 
-                QByteArray hexString;
-                for (int i = 0; i < data.size(); ++i)
-                {
-                    hexString.append(QByteArray::number(static_cast<uchar>(data[i]), 16).rightJustified(2, '0').toUpper());
-                    hexString.append(" ");
-                }
-                plainMsg.append(hexString);
+                // One allocation for the whole frame, see HexCodec.hpp
+                plainMsg.append(HexCodec::toSpacedHex(data));
             }
         }
         else
         {
             for (const QByteArray &data : msg)
             {
+                if (stamped && index++ == 1)
+                {
+                    continue;
+                }
                 plainMsg.append(data);
             }
         }
-        qDebug() << "Subscriber> " << plainMsg << ", Timestamp: " << currentTime;
-        emit messageReceived(currentTime, plainMsg);
+
+        display(currentTime, plainMsg, !useHex_);
+    }
+
+    void reportStats()
+    {
+        LatencyReports measured = latencyStats_.reports();
+        if (measured.first().total.count != 0)
+        {
+            emit latencyReported(measured, correctedLatencyStats_.reports());
+        }
+        latencyStats_.rotate();
+        correctedLatencyStats_.rotate();
+
+        if (!sequenceTracker_.isEmpty())
+        {
+            sequenceTracker_.sample(monotonicNs());
+            emit lossReported(sequenceTracker_.takeReport());
+        }
+
+        if (!rateStats_.isEmpty())
+        {
+            emit rateReported(rateStats_.report());
+        }
+
+        if (stepMeter_.isActive())
+        {
+            stepMeter_.rotate();
+        }
+
+        chunkAssembler_.expire(monotonicNs());
+        if (chunkAssembler_.hasReport())
+        {
+            emit streamReported(chunkAssembler_.takeReport());
+        }
+
+        if (!payloadVerifier_.isEmpty())
+        {
+            emit integrityReported(payloadVerifier_.takeReport());
+        }
+
+        if (captureWriter_.isOpen())
+        {
+            emit captureReported(captureWriter_.status(monotonicNs()));
+        }
+
+        if (!endpointStats_.isEmpty())
+        {
+            emit endpointsReported(endpointStats_.report(monotonicNs()));
+        }
+    }
+
+    void publishTopicStats()
+    {
+        if (topicStats_)
+        {
+            topicStats_->publish(monotonicNs());
+        }
     }
 
 private:
-    QString address_;
+    // Identifies the message stream of one topic sent by one publisher
+    typedef QPair<quint32, QByteArray> StreamKey;
+
+    struct StreamTiming
+    {
+        bool seen;
+        quint64 sequence;
+        qint64 intendedNs;
+        qint64 intervalNs;
+    };
+
+    // raw tells the payload decoder of the view whether the frames are as received
+    void display(const QString& timeStamp, const QList<QByteArray>& plainMsg, bool raw)
+    {
+        if (displayRing_)
+        {
+            displayRing_->store(timeStamp, plainMsg, raw);
+        }
+        else
+        {
+            emit messageReceived(timeStamp, plainMsg);
+        }
+    }
+
+    void recordStamp(int shard, const QByteArray& topic, const MessageStamp::View& stamp, qint64 receiveNs)
+    {
+        // The expected interval for back-filling is the distance of two consecutive intended send times
+        qint64 intervalNs = 0;
+        if (backfill_)
+        {
+            StreamTiming& timing = streamTimings_[StreamKey(stamp.publisherId(), topic)];
+            if (timing.seen && stamp.sequence() == timing.sequence + 1)
+            {
+                timing.intervalNs = stamp.intendedTimeNs() - timing.intendedNs;
+            }
+            timing.seen = true;
+            timing.sequence = stamp.sequence();
+            timing.intendedNs = stamp.intendedTimeNs();
+            intervalNs = timing.intervalNs;
+        }
+
+        latencyStats_.record(topic, receiveNs - stamp.sendTimeNs(), intervalNs);
+        endpointStats_.recordLatency(shard, receiveNs - stamp.sendTimeNs());
+        correctedLatencyStats_.record(topic, receiveNs - stamp.intendedTimeNs());
+        rateStats_.record(stamp.targetRate(), receiveNs - stamp.intendedTimeNs());
+        stepMeter_.record(stamp.targetRate(), receiveNs - stamp.intendedTimeNs());
+
+        quint64 skipped = 0;
+        sequenceTracker_.track(stamp.publisherId(), topic, stamp.sequence(), receiveNs, &skipped);
+        if (skipped != 0)
+        {
+            rateStats_.addMissing(stamp.targetRate(), skipped);
+            stepMeter_.addMissing(stamp.targetRate(), skipped);
+            endpointStats_.addMissing(shard, skipped);
+        }
+    }
+
+    QVector<QStringList> shards_;           // Endpoints per socket
     QString topic_;
     QString message_;
     bool useHex_;
-    ZMQSocket* socket_;
+    bool backfill_;
+    QList<ZMQSocket*> sockets_;
+    QTimer* reportTimer_;
+    QTimer* topicStatsTimer_;
+    QSharedPointer<TopicStats> topicStats_;
+    QSharedPointer<DisplayRing> displayRing_;
+    TopicMatcher topicMatcher_;
+    LatencyStats latencyStats_;
+    LatencyStats correctedLatencyStats_;
+    QHash<StreamKey, StreamTiming> streamTimings_;
+    SequenceTracker sequenceTracker_;
+    RateStats rateStats_;
+    StepMeter stepMeter_;
+    ChunkAssembler chunkAssembler_;
+    PayloadVerifier payloadVerifier_;
+    EndpointStats endpointStats_;
+    QString capturePrefix_;
+    CaptureOptions captureOptions_;
+    CaptureWriter captureWriter_;
 };
 
 }
@@ -0,0 +1,435 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_TOPICMATCHER_H
+#define NZMQT_TOPICMATCHER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Topic Matcher:
+Wildcard subscriptions on top of the prefix filtering of ZeroMQ. Topics are '/' separated levels, a
+pattern level "+" matches exactly one level and a level "#" matches any number of levels, also none
+and also in the middle, e.g. "sensor/#/temp" matches "sensor/temp" and "sensor/a/b/temp". A pattern
+with a wildcard must match the whole topic; a topic without one keeps the prefix semantics of a ZeroMQ
+subscription, so "sensor" still matches "sensors/x". The literal part in front of the first wildcard
+is what the socket subscribes to, see upstreamPrefix(), so the publisher drops what cannot match.
+All patterns are compiled into one character trie. A node keeps its first edge inline, which covers
+the long single child chains of a trie, further edges live in one open addressing table keyed by
+(node, byte); a wildcard level is a child of its own kind. matches() runs the trie as an NFA
+in one pass over the topic: the active states are the trie nodes reached so far, plus states that skip
+the rest of a "+" level or whole levels for a "#". Literal edges prune quickly, so a handful of states
+are active at a time regardless of the number of patterns.
+*/
+class TopicMatcher
+{
+public:
+    TopicMatcher()
+        : wildcards_(0), matchAll_(false)
+    {
+        clear();
+    }
+
+    // True if the subscription needs the matcher, i.e. one of its levels is "+" or "#"
+    static bool isPattern(const QByteArray& subscription)
+    {
+        for (const QByteArray& level : subscription.split('/'))
+        {
+            if (level == "+" || level == "#")
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The widest prefix the socket can subscribe to without losing a topic the subscription matches
+    static QByteArray upstreamPrefix(const QByteArray& subscription)
+    {
+        QList<QByteArray> levels = subscription.split('/');
+        QByteArray prefix;
+        for (int i = 0; i < levels.size(); ++i)
+        {
+            const QByteArray& level = levels.at(i);
+            if (level == "+" || level == "#")
+            {
+                // "#" also matches no level, "a/#" matches "a" without the separator
+                if (level == "#" && !prefix.isEmpty())
+                {
+                    prefix.chop(1);
+                }
+                return prefix;
+            }
+            prefix += level;
+            prefix += '/';
+        }
+        return subscription;
+    }
+
+    /**
+     * @brief Adds a subscription, adding it twice needs two calls to remove().
+     * @param subscription A prefix or a pattern with "+" and "#" levels.
+     * @return None
+     */
+    void add(const QByteArray& subscription)
+    {
+        ++subscriptions_[subscription];
+        wildcards_ += isPattern(subscription) ? 1 : 0;
+        compile(subscription);
+    }
+
+    // Removes a subscription added before, the trie is rebuilt from the remaining ones
+    void remove(const QByteArray& subscription)
+    {
+        auto it = subscriptions_.find(subscription);
+        if (it == subscriptions_.end())
+        {
+            return;
+        }
+        wildcards_ -= isPattern(subscription) ? 1 : 0;
+        if (--it.value() == 0)
+        {
+            subscriptions_.erase(it);
+        }
+
+        QHash<QByteArray, int> subscriptions = subscriptions_;
+        int wildcards = wildcards_;
+        clear();
+        subscriptions_ = subscriptions;
+        wildcards_ = wildcards;
+        for (auto it = subscriptions_.cbegin(); it != subscriptions_.cend(); ++it)
+        {
+            compile(it.key());
+        }
+    }
+
+    // Without a wildcard subscription the socket's prefix filter is exact and the matcher can be skipped
+    bool hasWildcards() const { return wildcards_ > 0; }
+
+    /**
+     * @brief Checks a topic against all subscriptions.
+     * @param topic The topic frame of a received message.
+     * @return True if at least one subscription matches.
+     */
+    bool matches(const QByteArray& topic)
+    {
+        if (matchAll_)
+        {
+            return true;
+        }
+
+        const char* text = topic.constData();
+        const int size = topic.size();
+        QVector<State>* current = &statesA_;
+        QVector<State>* next = &statesB_;
+        current->clear();
+        push(current, State(0, LITERAL));
+
+        for (int pos = 0; ; ++pos)
+        {
+            bool atEnd = pos == size;
+            char c = atEnd ? '\0' : text[pos];
+            bool levelStart = pos == 0 || text[pos - 1] == '/';
+
+            // Epsilon moves: wildcard children at a level start, the end of a "+" level; the list grows while it is walked
+            for (int i = 0; i < current->size(); ++i)
+            {
+                State state = current->at(i);
+                const Node& node = nodes_.at(state.node);
+                if (state.kind == LITERAL)
+                {
+                    if (node.prefixEnd || (node.levelEnd && (atEnd || c == '/')) || (atEnd && node.exactEnd))
+                    {
+                        return true;
+                    }
+                    if (levelStart && node.plusChild >= 0)
+                    {
+                        push(current, State(node.plusChild, SKIP_LEVEL));
+                    }
+                    if (levelStart && node.hashChild >= 0)
+                    {
+                        push(current, State(node.hashChild, SKIP_LEVELS));
+                    }
+                }
+                else if (state.kind == SKIP_LEVEL)
+                {
+                    if (atEnd || c == '/')
+                    {
+                        push(current, State(state.node, LITERAL));
+                    }
+                }
+                else if (levelStart)
+                {
+                    push(current, State(state.node, LITERAL));
+                }
+            }
+            if (atEnd)
+            {
+                return false;
+            }
+
+            next->clear();
+            for (const State& state : *current)
+            {
+                if (state.kind == LITERAL)
+                {
+                    int child = edge(state.node, static_cast<uchar>(c));
+                    if (child >= 0)
+                    {
+                        push(next, State(child, LITERAL));
+                    }
+                }
+                else if (state.kind == SKIP_LEVELS || c != '/')
+                {
+                    push(next, state);
+                }
+            }
+            if (next->isEmpty())
+            {
+                return false;
+            }
+            qSwap(current, next);
+        }
+    }
+
+private:
+    enum Kind
+    {
+        LITERAL,        // At a trie node
+        SKIP_LEVEL,     // Inside the level of a "+", continues at the node once the level ends
+        SKIP_LEVELS     // Inside the levels of a "#", continues at the node at every level start
+    };
+
+    struct State
+    {
+        int node;
+        Kind kind;
+
+        State() : node(0), kind(LITERAL) {}
+        State(int n, Kind k) : node(n), kind(k) {}
+    };
+
+    struct Node
+    {
+        int plusChild;      // The node after a "+" level, -1 if none
+        int hashChild;      // The node after "#/" levels, -1 if none
+        bool prefixEnd;     // A subscription without wildcards ends here, any continuation matches
+        bool exactEnd;      // A pattern ends here, the topic must end too
+        bool levelEnd;      // A pattern ends with "/#" here, the topic must end or continue with a level
+        bool branches;      // Edges beyond the first one are in edges_
+        uchar firstByte;
+        int firstChild;     // The first edge is kept in the node, most nodes have one child only; -1 if none
+
+        Node()
+            : plusChild(-1), hashChild(-1), prefixEnd(false), exactEnd(false), levelEnd(false)
+            , branches(false), firstByte(0), firstChild(-1)
+        {
+        }
+    };
+
+    struct Edge
+    {
+        quint32 key;        // node << 8 | byte
+        int child;          // -1 for a free slot
+
+        Edge() : key(0), child(-1) {}
+    };
+
+    void clear()
+    {
+        subscriptions_.clear();
+        wildcards_ = 0;
+        matchAll_ = false;
+        nodes_.clear();
+        nodes_.append(Node());
+        edges_.fill(Edge(), 1024);
+        edgeCount_ = 0;
+    }
+
+    void compile(const QByteArray& subscription)
+    {
+        int node = 0;
+        if (!isPattern(subscription))
+        {
+            for (char c : subscription)
+            {
+                node = addEdge(node, static_cast<uchar>(c));
+            }
+            nodes_[node].prefixEnd = true;
+            return;
+        }
+
+        QList<QByteArray> levels = subscription.split('/');
+        bool separator = false;
+        for (int i = 0; i < levels.size(); ++i)
+        {
+            const QByteArray& level = levels.at(i);
+            if (level == "#" && i + 1 < levels.size() && levels.at(i + 1) == "#")
+            {
+                continue;   // "#/#" is the same as "#"
+            }
+            if (level == "#" && i == levels.size() - 1)
+            {
+                // A trailing "#" also matches the parent level itself, it needs no state of its own
+                if (node == 0 && !separator)
+                {
+                    matchAll_ = true;
+                }
+                nodes_[node].levelEnd = true;
+                return;
+            }
+
+            // The separator after a "#" is part of the levels it skips
+            if (separator)
+            {
+                node = addEdge(node, '/');
+            }
+            separator = level != "#";
+            if (level == "#")
+            {
+                node = wildcardChild(node, &Node::hashChild);
+            }
+            else if (level == "+")
+            {
+                node = wildcardChild(node, &Node::plusChild);
+            }
+            else
+            {
+                for (char c : level)
+                {
+                    node = addEdge(node, static_cast<uchar>(c));
+                }
+            }
+        }
+        nodes_[node].exactEnd = true;
+    }
+
+    int wildcardChild(int node, int Node::*child)
+    {
+        if (nodes_.at(node).*child < 0)
+        {
+            nodes_.append(Node());
+            nodes_[node].*child = nodes_.size() - 1;
+        }
+        return nodes_.at(node).*child;
+    }
+
+    static uint slotOf(quint32 key, int mask)
+    {
+        // Fibonacci hashing spreads the consecutive node numbers over the table
+        return (key * 2654435769U >> 7) & mask;
+    }
+
+    int edge(int node, uchar c) const
+    {
+        const Node& from = nodes_.at(node);
+        if (from.firstByte == c && from.firstChild >= 0)
+        {
+            return from.firstChild;
+        }
+        if (!from.branches)
+        {
+            return -1;
+        }
+
+        quint32 key = static_cast<quint32>(node) << 8 | c;
+        int mask = edges_.size() - 1;
+        const Edge* edges = edges_.constData();
+        for (uint i = slotOf(key, mask); ; i = (i + 1) & mask)
+        {
+            if (edges[i].child < 0)
+            {
+                return -1;
+            }
+            if (edges[i].key == key)
+            {
+                return edges[i].child;
+            }
+        }
+    }
+
+    int addEdge(int node, uchar c)
+    {
+        int child = edge(node, c);
+        if (child >= 0)
+        {
+            return child;
+        }
+
+        nodes_.append(Node());
+        child = nodes_.size() - 1;
+        Node& from = nodes_[node];
+        if (from.firstChild < 0)
+        {
+            from.firstByte = c;
+            from.firstChild = child;
+            return child;
+        }
+        from.branches = true;
+        insertEdge(&edges_, static_cast<quint32>(node) << 8 | c, child);
+        if (++edgeCount_ * 2 > edges_.size())
+        {
+            QVector<Edge> edges(edges_.size() * 2);
+            for (const Edge& e : edges_)
+            {
+                if (e.child >= 0)
+                {
+                    insertEdge(&edges, e.key, e.child);
+                }
+            }
+            edges_.swap(edges);
+        }
+        return child;
+    }
+
+    static void insertEdge(QVector<Edge>* edges, quint32 key, int child)
+    {
+        int mask = edges->size() - 1;
+        Edge* data = edges->data();
+        uint i = slotOf(key, mask);
+        while (data[i].child >= 0)
+        {
+            i = (i + 1) & mask;
+        }
+        data[i].key = key;
+        data[i].child = child;
+    }
+
+    // Adds a state unless the list has it already, the lists hold a handful of states
+    static void push(QVector<State>* states, const State& state)
+    {
+        for (const State& s : *states)
+        {
+            if (s.node == state.node && s.kind == state.kind)
+            {
+                return;
+            }
+        }
+        states->append(state);
+    }
+
+    QHash<QByteArray, int> subscriptions_;  // Subscription to the number of times it was added
+    int wildcards_;
+    bool matchAll_;                         // A "#" subscription matches every topic
+    QVector<Node> nodes_;                   // Node 0 is the root
+    QVector<Edge> edges_;                   // At most half full
+    int edgeCount_;
+    QVector<State> statesA_;
+    QVector<State> statesB_;
+};
+
+}
+
+}
+
+#endif // NZMQT_TOPICMATCHER_H
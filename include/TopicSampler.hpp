@@ -0,0 +1,274 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_TOPICSAMPLER_H
+#define NZMQT_TOPICSAMPLER_H
+
+#include "FastRandom.hpp"
+
+#include <QByteArray>
+#include <QFile>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+#include <cmath>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Topic Sampler:
+Picks the topic of every message from a topic set. The set is given as
+    @path           a file with one topic per line
+    md/{0..9999}    a pattern, every {first..last} range is expanded, leading zeros of first pad the numbers
+    a;b;c           a list, each entry may itself be a pattern
+Any topic may be followed by =weight, which is used by the weighted distribution and defaults to 1.
+Zipf ranks the topics in the order they are given, the first topic is the most popular one.
+
+Topic frames are encoded once and sample() uses Vose's alias table: one random number selects a
+column and decides between the column's topic and its alias, O(1) regardless of the set size.
+*/
+class TopicSampler
+{
+public:
+    static const int MaxTopics = 1000000;
+
+    enum Distribution
+    {
+        DIST_UNIFORM,
+        DIST_ZIPF,
+        DIST_WEIGHTED
+    };
+
+    /**
+     * @brief Parses a topic set, see the description of the class for the syntax.
+     * @param spec The topic set.
+     * @param error Receives a description of the problem if parsing fails.
+     * @return False if the set is empty, malformed or larger than MaxTopics.
+     */
+    bool parse(const QString& spec, QString* error)
+    {
+        topics_.clear();
+        weights_.clear();
+
+        QStringList entries;
+        if (spec.startsWith('@'))
+        {
+            QFile file(spec.mid(1));
+            if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            {
+                *error = QString("Cannot open topic file %1: %2").arg(file.fileName(), file.errorString());
+                return false;
+            }
+
+            QTextStream stream(&file);
+            while (!stream.atEnd())
+            {
+                QString line = stream.readLine().trimmed();
+                if (!line.isEmpty())
+                {
+                    entries.append(line);
+                }
+            }
+        }
+        else
+        {
+            entries = spec.split(';');
+        }
+
+        for (const QString& entry : entries)
+        {
+            QString topic = entry.trimmed();
+            double weight = 1.0;
+            int separator = topic.lastIndexOf('=');
+            if (separator >= 0)
+            {
+                bool ok = false;
+                weight = topic.mid(separator + 1).toDouble(&ok);
+                if (!ok || weight < 0.0 || !std::isfinite(weight))
+                {
+                    *error = QString("Invalid weight in %1").arg(topic);
+                    return false;
+                }
+                topic.truncate(separator);
+            }
+
+            if (topic.isEmpty())
+            {
+                continue;
+            }
+            if (!expand(topic, weight, error))
+            {
+                return false;
+            }
+        }
+
+        if (topics_.isEmpty())
+        {
+            *error = QString("The topic set is empty");
+            return false;
+        }
+        setDistribution(DIST_UNIFORM);
+        return true;
+    }
+
+    /**
+     * @brief Selects the distribution and rebuilds the alias table.
+     * @param distribution The distribution of the topics.
+     * @param zipfExponent The exponent s of the Zipf distribution, topic k is chosen with a probability proportional to 1 / k^s.
+     * @return None
+     */
+    void setDistribution(Distribution distribution, double zipfExponent = 1.0)
+    {
+        QVector<double> probabilities(topics_.size());
+        for (int i = 0; i < topics_.size(); ++i)
+        {
+            switch (distribution)
+            {
+            case DIST_ZIPF:
+                probabilities[i] = 1.0 / std::pow(i + 1.0, zipfExponent);
+                break;
+            case DIST_WEIGHTED:
+                probabilities[i] = weights_.at(i);
+                break;
+            default:
+                probabilities[i] = 1.0;
+                break;
+            }
+        }
+        buildAliasTable(probabilities);
+    }
+
+    bool isEmpty() const { return topics_.isEmpty(); }
+    int size() const { return topics_.size(); }
+
+    // The encoded topic frame, shares its data with the sampler
+    const QByteArray& topic(int index) const { return topics_.at(index); }
+
+    /**
+     * @brief Picks the index of the next topic.
+     * @param random The generator of the calling sender.
+     * @return An index in the range 0 to size() - 1.
+     */
+    int sample(FastRandom& random) const
+    {
+        // The upper half of the number selects the column, the lower half decides against its threshold
+        quint64 r = random.next();
+        int column = static_cast<int>(((r >> 32) * static_cast<quint64>(thresholds_.size())) >> 32);
+        return (r & 0xFFFFFFFFULL) < thresholds_.at(column) ? column : alias_.at(column);
+    }
+
+private:
+    bool expand(const QString& pattern, double weight, QString* error)
+    {
+        static const QRegularExpression range("\\{(\\d+)\\.\\.(\\d+)\\}");
+        QRegularExpressionMatch match = range.match(pattern);
+        if (!match.hasMatch())
+        {
+            if (topics_.size() >= MaxTopics)
+            {
+                *error = QString("The topic set has more than %1 topics").arg(MaxTopics);
+                return false;
+            }
+            topics_.append(pattern.toLocal8Bit());
+            weights_.append(weight);
+            return true;
+        }
+
+        bool firstOk = false;
+        bool lastOk = false;
+        qint64 first = match.captured(1).toLongLong(&firstOk);
+        qint64 last = match.captured(2).toLongLong(&lastOk);
+        if (!firstOk || !lastOk || last < first || last - first >= MaxTopics)
+        {
+            *error = QString("Invalid range %1").arg(match.captured(0));
+            return false;
+        }
+
+        int width = match.captured(1).startsWith('0') ? match.captured(1).size() : 0;
+        QString prefix = pattern.left(match.capturedStart(0));
+        QString suffix = pattern.mid(match.capturedEnd(0));
+        for (qint64 value = first; value <= last; ++value)
+        {
+            // Later ranges of the pattern are expanded recursively
+            if (!expand(prefix + QString("%1").arg(value, width, 10, QChar('0')) + suffix, weight, error))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void buildAliasTable(const QVector<double>& probabilities)
+    {
+        int n = probabilities.size();
+        double sum = 0.0;
+        for (double p : probabilities)
+        {
+            sum += p;
+        }
+
+        thresholds_.fill(0, n);
+        alias_.fill(0, n);
+        if (n == 0)
+        {
+            return;
+        }
+
+        // Scaled so that the average column holds exactly 1, all zero weights fall back to uniform
+        QVector<double> scaled(n);
+        QVector<int> small;
+        QVector<int> large;
+        for (int i = 0; i < n; ++i)
+        {
+            scaled[i] = sum > 0.0 ? probabilities.at(i) * n / sum : 1.0;
+            (scaled.at(i) < 1.0 ? small : large).append(i);
+        }
+
+        // Every small column is topped up by a large one, which becomes its alias
+        while (!small.isEmpty() && !large.isEmpty())
+        {
+            int less = small.takeLast();
+            int more = large.last();
+            thresholds_[less] = static_cast<quint64>(scaled.at(less) * 4294967296.0);
+            alias_[less] = more;
+
+            scaled[more] -= 1.0 - scaled.at(less);
+            if (scaled.at(more) < 1.0)
+            {
+                large.removeLast();
+                small.append(more);
+            }
+        }
+
+        // Left overs are 1 up to rounding errors and always keep their own topic
+        for (int i : large)
+        {
+            thresholds_[i] = Q_UINT64_C(1) << 32;
+            alias_[i] = i;
+        }
+        for (int i : small)
+        {
+            thresholds_[i] = Q_UINT64_C(1) << 32;
+            alias_[i] = i;
+        }
+    }
+
+    QVector<QByteArray> topics_;
+    QVector<double> weights_;
+    QVector<quint64> thresholds_;   // Probability of keeping the column's topic, scaled to 2^32
+    QVector<int> alias_;
+};
+
+}
+
+}
+
+#endif // NZMQT_TOPICSAMPLER_H
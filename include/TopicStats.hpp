@@ -0,0 +1,248 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_TOPICSTATS_H
+#define NZMQT_TOPICSTATS_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <climits>
+#include <cmath>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+// Counters of one topic, a row of the topic statistics table
+struct TopicRow
+{
+    QByteArray topic;
+    quint64 messages;
+    quint64 bytes;          // All frames of the messages, topic included
+    double messageRate;     // msg/s, averaged over about RateWindowNs
+    double byteRate;        // Bytes/s, averaged like messageRate
+    int minSize;
+    int maxSize;
+    qint64 lastNs;          // Monotonic receive time of the latest message
+    double jitterNs;        // Mean deviation of consecutive inter-arrival times
+
+    TopicRow()
+        : messages(0), bytes(0), messageRate(0.0), byteRate(0.0)
+        , minSize(INT_MAX), maxSize(0), lastNs(0), jitterNs(0.0)
+    {
+    }
+
+    double averageSize() const { return messages == 0 ? 0.0 : static_cast<double>(bytes) / messages; }
+};
+
+struct TopicStatsSnapshot
+{
+    qint64 takenNs;             // Monotonic time the snapshot was taken
+    quint64 untracked;          // Messages of topics beyond MaxTopics
+    QVector<TopicRow> rows;     // In the order the topics were first seen
+
+    TopicStatsSnapshot()
+        : takenNs(0), untracked(0)
+    {
+    }
+};
+
+/*
+Topic Stats:
+Live counters for every topic the Subscriber receives. The subscriber thread is the only writer:
+record() finds the topic in an open addressing table with linear probing, whose slots hold the
+hash and the index of the topic's counters in one dense array. A lookup compares hashes and only
+on a match the interned topic bytes, so the received frame is never copied after the first message
+of its topic, and publish() walks the dense array without touching empty slots. publish() turns
+the counters into a snapshot that other threads pick up with latest(); the GUI polls it at its
+frame rate and never waits for the subscriber. Inter-arrival jitter follows RFC 3550: the mean
+deviation of consecutive intervals, smoothed with a gain of 1/16.
+*/
+class TopicStats
+{
+    Q_DISABLE_COPY(TopicStats)
+
+public:
+    static const int MaxTopics = 1 << 20;
+    static const qint64 RateWindowNs = 1000000000LL;
+
+    TopicStats()
+        : untracked_(0), publishedNs_(0)
+        , latest_(new TopicStatsSnapshot)
+    {
+        slots_.fill(Slot(), InitialSlots);
+    }
+
+    /**
+     * @brief Counts a received message, called on the subscriber thread.
+     * @param topic The topic frame.
+     * @param size The size of all frames of the message.
+     * @param receiveNs The monotonic receive time.
+     * @return None
+     */
+    void record(const QByteArray& topic, int size, qint64 receiveNs)
+    {
+        Entry* entry = find(topic);
+        if (entry == 0)
+        {
+            ++untracked_;
+            return;
+        }
+
+        TopicRow& row = entry->row;
+        if (row.messages != 0)
+        {
+            qint64 intervalNs = receiveNs - row.lastNs;
+            if (entry->lastIntervalNs >= 0)
+            {
+                row.jitterNs += (std::fabs(static_cast<double>(intervalNs - entry->lastIntervalNs)) - row.jitterNs) / 16.0;
+            }
+            entry->lastIntervalNs = intervalNs;
+        }
+
+        ++row.messages;
+        row.bytes += size;
+        row.minSize = qMin(row.minSize, size);
+        row.maxSize = qMax(row.maxSize, size);
+        row.lastNs = receiveNs;
+    }
+
+    /**
+     * @brief Updates the rates and makes a new snapshot available to latest(), called on the subscriber thread.
+     * @param nowNs The monotonic time.
+     * @return None
+     */
+    void publish(qint64 nowNs)
+    {
+        // Exponential average with a time constant of RateWindowNs, independent of how often this is called
+        qint64 elapsedNs = publishedNs_ == 0 ? 0 : nowNs - publishedNs_;
+        double weight = elapsedNs > 0 ? 1.0 - std::exp(-static_cast<double>(elapsedNs) / RateWindowNs) : 0.0;
+        publishedNs_ = nowNs;
+
+        TopicStatsSnapshot* snapshot = new TopicStatsSnapshot;
+        snapshot->takenNs = nowNs;
+        snapshot->untracked = untracked_;
+        snapshot->rows.reserve(entries_.size());
+        for (Entry& entry : entries_)
+        {
+            TopicRow& row = entry.row;
+            if (elapsedNs > 0)
+            {
+                double messageRate = (row.messages - entry.publishedMessages) * 1e9 / elapsedNs;
+                double byteRate = (row.bytes - entry.publishedBytes) * 1e9 / elapsedNs;
+                row.messageRate += weight * (messageRate - row.messageRate);
+                row.byteRate += weight * (byteRate - row.byteRate);
+            }
+            entry.publishedMessages = row.messages;
+            entry.publishedBytes = row.bytes;
+            snapshot->rows.append(row);
+        }
+
+        QSharedPointer<const TopicStatsSnapshot> published(snapshot);
+        QMutexLocker locker(&latestMutex_);
+        latest_.swap(published);
+    }
+
+    // The snapshot of the latest publish(), may be called from any thread
+    QSharedPointer<const TopicStatsSnapshot> latest() const
+    {
+        QMutexLocker locker(&latestMutex_);
+        return latest_;
+    }
+
+private:
+    static const int InitialSlots = 1024;
+
+    struct Slot
+    {
+        uint hash;
+        int entry;          // Index into entries_, -1 for a free slot
+
+        Slot() : hash(0), entry(-1) {}
+    };
+
+    struct Entry
+    {
+        TopicRow row;
+        qint64 lastIntervalNs;      // -1 until two messages arrived
+        quint64 publishedMessages;  // Counters at the previous publish(), for the rates
+        quint64 publishedBytes;
+
+        Entry() : lastIntervalNs(-1), publishedMessages(0), publishedBytes(0) {}
+    };
+
+    // The counters of a topic, inserted on its first message; 0 if MaxTopics topics are tracked already
+    Entry* find(const QByteArray& topic)
+    {
+        uint hash = qHash(topic);
+        int mask = slots_.size() - 1;
+        Slot* slots = slots_.data();
+        for (int i = static_cast<int>(hash) & mask;; i = (i + 1) & mask)
+        {
+            Slot& slot = slots[i];
+            if (slot.entry < 0)
+            {
+                if (entries_.size() >= MaxTopics)
+                {
+                    return 0;
+                }
+
+                slot.hash = hash;
+                slot.entry = entries_.size();
+                entries_.append(Entry());
+                entries_.last().row.topic = topic;
+                if (entries_.size() * 2 > slots_.size())
+                {
+                    grow();
+                }
+                return &entries_.last();
+            }
+            if (slot.hash == hash && entries_.at(slot.entry).row.topic == topic)
+            {
+                return &entries_[slot.entry];
+            }
+        }
+    }
+
+    // Doubles the table, which keeps it at most half full and the probe sequences short
+    void grow()
+    {
+        QVector<Slot> slots(slots_.size() * 2);
+        int mask = slots.size() - 1;
+        for (const Slot& slot : slots_)
+        {
+            if (slot.entry >= 0)
+            {
+                int i = static_cast<int>(slot.hash) & mask;
+                while (slots[i].entry >= 0)
+                {
+                    i = (i + 1) & mask;
+                }
+                slots[i] = slot;
+            }
+        }
+        slots_.swap(slots);
+    }
+
+    QVector<Slot> slots_;
+    QVector<Entry> entries_;
+    quint64 untracked_;
+    qint64 publishedNs_;
+
+    mutable QMutex latestMutex_;
+    QSharedPointer<const TopicStatsSnapshot> latest_;
+};
+
+}
+
+}
+
+#endif // NZMQT_TOPICSTATS_H
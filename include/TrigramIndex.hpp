@@ -0,0 +1,411 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NZMQT_TRIGRAMINDEX_H
+#define NZMQT_TRIGRAMINDEX_H
+
+#include "CaptureFormat.hpp"
+#include "MappedCapture.hpp"
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <QtEndian>
+
+#include <algorithm>
+
+
+namespace nzmqt
+{
+
+namespace samples
+{
+
+/*
+Trigram Index:
+The search index of a capture segment, see CaptureFormat.hpp. A pattern can only occur in a message
+that contains all of its trigrams, so intersecting their block lists leaves the few blocks a search
+has to read; those are verified with ByteSearch.
+build() reads a closed segment through a mapping and collects the distinct trigrams of each block
+in a 2 MiB bitmap over all 2^24 trigrams, so a payload byte costs a bit test and only the first
+sighting in a block touches the posting lists. Payloads that look random have most trigrams in every
+block, an index would be as large as the data and prune nothing; after MaxTrigrams distinct trigrams
+the build gives up and searches scan the segment instead.
+*/
+class TrigramIndex
+{
+    Q_DISABLE_COPY(TrigramIndex)
+
+public:
+    static const int MaxTrigrams = 1 << 20;
+
+    TrigramIndex()
+        : data_(0), size_(0)
+    {
+        header_.segmentIndex = 0;
+        header_.blockSize = 0;
+        header_.blockCount = 0;
+        header_.trigramCount = 0;
+    }
+
+    ~TrigramIndex()
+    {
+        close();
+    }
+
+    /**
+     * @brief Builds the search index of a segment.
+     * @param segmentPath The segment, its time index is used if it exists.
+     * @param path The search index file to write.
+     * @param error Receives a description of the problem if no index was written.
+     * @return False if the segment cannot be read, its payloads have too many distinct trigrams or the file cannot be written.
+     */
+    static bool build(const QString& segmentPath, const QString& path, QString* error)
+    {
+        MappedCapture capture;
+        if (!capture.open(segmentPath, error, false))
+        {
+            return false;
+        }
+
+        Builder builder;
+        const quint32 blockSize = capture.blockSize(0);
+        quint32 block = 0;
+        for (CaptureCursor cursor = capture.first(); cursor.isValid(); cursor.next())
+        {
+            quint32 current = static_cast<quint32>(cursor.offset() / blockSize);
+            if (current != block)
+            {
+                builder.finishBlock(block);
+                block = current;
+            }
+            for (int i = 1; i < cursor.frameCount(); ++i)
+            {
+                builder.add(cursor.frame(i));
+            }
+            if (builder.trigramCount() > MaxTrigrams)
+            {
+                *error = QString("%1 has more than %2 distinct trigrams, it is searched without an index").arg(segmentPath).arg(MaxTrigrams);
+                return false;
+            }
+        }
+        builder.finishBlock(block);
+
+        CaptureFormat::TrigramHeader header;
+        header.segmentIndex = static_cast<quint32>(capture.segmentIndex(0));
+        header.blockSize = blockSize;
+        header.blockCount = capture.blockCount(0);
+        QByteArray data = builder.serialize(&header);
+
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(data) != data.size())
+        {
+            *error = QString("%1: %2").arg(path, file.errorString());
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Maps the search index of a segment.
+     * @param path The search index file.
+     * @param segmentIndex The index of the segment it must belong to.
+     * @return False if the file does not exist or does not fit the segment.
+     */
+    bool open(const QString& path, int segmentIndex)
+    {
+        close();
+        file_.setFileName(path);
+        if (!file_.open(QIODevice::ReadOnly))
+        {
+            return false;
+        }
+
+        size_ = file_.size();
+        uchar* data = size_ >= CaptureFormat::TrigramHeaderSize ? file_.map(0, size_) : 0;
+        if (!data)
+        {
+            file_.close();
+            return false;
+        }
+        data_ = reinterpret_cast<const char*>(data);
+        if (!CaptureFormat::readTrigramHeader(data_, &header_) || header_.segmentIndex != static_cast<quint32>(segmentIndex) || header_.blockSize == 0
+            || CaptureFormat::TrigramHeaderSize + quint64(header_.trigramCount) * CaptureFormat::TrigramEntrySize > size_)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (data_)
+        {
+            file_.unmap(const_cast<uchar*>(reinterpret_cast<const uchar*>(data_)));
+            data_ = 0;
+        }
+        file_.close();
+        size_ = 0;
+    }
+
+    bool isOpen() const
+    {
+        return data_ != 0;
+    }
+
+    quint32 blockSize() const
+    {
+        return header_.blockSize;
+    }
+
+    /**
+     * @brief Lists the blocks in which a message may contain the pattern.
+     * @param pattern The bytes to search for, a pattern shorter than a trigram matches every block.
+     * @return The block numbers in ascending order, all blocks if a posting list is damaged.
+     */
+    QVector<quint32> candidates(const QByteArray& pattern) const
+    {
+        QVector<quint32> blocks;
+        if (pattern.size() < 3)
+        {
+            return allBlocks();
+        }
+
+        // The rarest trigram first, every further list can only shrink the result
+        QVector<Entry> entries;
+        const uchar* p = reinterpret_cast<const uchar*>(pattern.constData());
+        for (int i = 0; i + 3 <= pattern.size(); ++i)
+        {
+            quint32 trigram = p[i] << 16 | p[i + 1] << 8 | p[i + 2];
+            Entry entry;
+            if (!find(trigram, &entry))
+            {
+                return blocks;
+            }
+            if (std::find_if(entries.begin(), entries.end(), [trigram](const Entry& e) { return e.trigram == trigram; }) == entries.end())
+            {
+                entries.append(entry);
+            }
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.count < b.count; });
+
+        if (!decode(entries.first(), &blocks))
+        {
+            return allBlocks();
+        }
+        QVector<quint32> other;
+        for (int i = 1; i < entries.size() && !blocks.isEmpty(); ++i)
+        {
+            if (!decode(entries.at(i), &other))
+            {
+                return allBlocks();
+            }
+            auto end = std::set_intersection(blocks.begin(), blocks.end(), other.begin(), other.end(), blocks.begin());
+            blocks.resize(static_cast<int>(end - blocks.begin()));
+        }
+        return blocks;
+    }
+
+private:
+    struct Entry
+    {
+        quint32 trigram;
+        quint32 count;
+        quint64 offset;
+    };
+
+    // Collects the postings while a segment is read
+    class Builder
+    {
+    public:
+        Builder()
+            : seen_(1 << 18, 0)
+        {
+        }
+
+        int trigramCount() const
+        {
+            return postings_.size();
+        }
+
+        void add(const QByteArray& frame)
+        {
+            const uchar* p = reinterpret_cast<const uchar*>(frame.constData());
+            const int size = frame.size();
+            if (size < 3)
+            {
+                return;
+            }
+
+            quint64* seen = seen_.data();
+            quint32 trigram = p[0] << 8 | p[1];
+            for (int i = 2; i < size; ++i)
+            {
+                trigram = (trigram << 8 | p[i]) & 0xFFFFFF;
+                quint64 bit = quint64(1) << (trigram & 63);
+                if ((seen[trigram >> 6] & bit) == 0)
+                {
+                    seen[trigram >> 6] |= bit;
+                    touched_.append(trigram);
+                }
+            }
+        }
+
+        // Appends the block to the postings of the trigrams seen since the previous call
+        void finishBlock(quint32 block)
+        {
+            quint64* seen = seen_.data();
+            for (quint32 trigram : touched_)
+            {
+                seen[trigram >> 6] &= ~(quint64(1) << (trigram & 63));
+                Posting& posting = postings_[trigram];
+                appendVarint(&posting.deltas, block - posting.last);
+                posting.last = block;
+                ++posting.count;
+            }
+            touched_.clear();
+        }
+
+        QByteArray serialize(CaptureFormat::TrigramHeader* header) const
+        {
+            QVector<quint32> trigrams;
+            trigrams.reserve(postings_.size());
+            int postingsSize = 0;
+            for (auto it = postings_.cbegin(); it != postings_.cend(); ++it)
+            {
+                trigrams.append(it.key());
+                postingsSize += it.value().deltas.size();
+            }
+            std::sort(trigrams.begin(), trigrams.end());
+
+            header->trigramCount = trigrams.size();
+            quint64 offset = CaptureFormat::TrigramHeaderSize + quint64(trigrams.size()) * CaptureFormat::TrigramEntrySize;
+            QByteArray data(static_cast<int>(offset) + postingsSize, '\0');
+            CaptureFormat::writeTrigramHeader(data.data(), *header);
+            uchar* entry = reinterpret_cast<uchar*>(data.data()) + CaptureFormat::TrigramHeaderSize;
+            for (quint32 trigram : trigrams)
+            {
+                const Posting& posting = postings_.value(trigram);
+                qToLittleEndian<quint32>(trigram, entry);
+                qToLittleEndian<quint32>(posting.count, entry + 4);
+                qToLittleEndian<quint64>(offset, entry + 8);
+                memcpy(data.data() + offset, posting.deltas.constData(), posting.deltas.size());
+                offset += posting.deltas.size();
+                entry += CaptureFormat::TrigramEntrySize;
+            }
+            return data;
+        }
+
+    private:
+        struct Posting
+        {
+            quint32 last;
+            quint32 count;
+            QByteArray deltas;
+
+            Posting() : last(0), count(0) {}
+        };
+
+        static void appendVarint(QByteArray* data, quint32 value)
+        {
+            while (value >= 0x80)
+            {
+                data->append(static_cast<char>(value | 0x80));
+                value >>= 7;
+            }
+            data->append(static_cast<char>(value));
+        }
+
+        QVector<quint64> seen_;                 // One bit per trigram, set while it is in touched_
+        QVector<quint32> touched_;              // Trigrams of the current block
+        QHash<quint32, Posting> postings_;
+    };
+
+    QVector<quint32> allBlocks() const
+    {
+        QVector<quint32> blocks;
+        blocks.reserve(header_.blockCount);
+        for (quint32 i = 0; i < header_.blockCount; ++i)
+        {
+            blocks.append(i);
+        }
+        return blocks;
+    }
+
+    // Binary search over the sorted trigram table
+    bool find(quint32 trigram, Entry* entry) const
+    {
+        const char* table = data_ + CaptureFormat::TrigramHeaderSize;
+        quint32 low = 0;
+        quint32 high = header_.trigramCount;
+        while (low < high)
+        {
+            quint32 middle = low + (high - low) / 2;
+            const uchar* p = reinterpret_cast<const uchar*>(table + quint64(middle) * CaptureFormat::TrigramEntrySize);
+            quint32 key = qFromLittleEndian<quint32>(p);
+            if (key < trigram)
+            {
+                low = middle + 1;
+            }
+            else if (key > trigram)
+            {
+                high = middle;
+            }
+            else
+            {
+                entry->trigram = key;
+                entry->count = qFromLittleEndian<quint32>(p + 4);
+                entry->offset = qFromLittleEndian<quint64>(p + 8);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Decodes a posting list, false if it runs past the end of the file
+    bool decode(const Entry& entry, QVector<quint32>* blocks) const
+    {
+        blocks->clear();
+        if (entry.offset > size_)
+        {
+            return false;
+        }
+        blocks->reserve(qMin(entry.count, header_.blockCount));
+        const uchar* p = reinterpret_cast<const uchar*>(data_) + entry.offset;
+        const uchar* end = reinterpret_cast<const uchar*>(data_) + size_;
+        quint32 block = 0;
+        for (quint32 i = 0; i < entry.count; ++i)
+        {
+            quint32 delta = 0;
+            for (int shift = 0; ; shift += 7)
+            {
+                if (p >= end || shift > 28)
+                {
+                    return false;
+                }
+                delta |= quint32(*p & 0x7F) << shift;
+                if ((*p++ & 0x80) == 0)
+                {
+                    break;
+                }
+            }
+            block += delta;
+            blocks->append(block);
+        }
+        return true;
+    }
+
+    QFile file_;
+    const char* data_;
+    quint64 size_;
+    CaptureFormat::TrigramHeader header_;
+};
+
+}
+
+}
+
+#endif // NZMQT_TRIGRAMINDEX_H
@@ -0,0 +1,150 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef CAPTUREMODEL_H
+#define CAPTUREMODEL_H
+
+#include "CaptureSearch.hpp"
+#include "DecodeQueue.hpp"
+#include "MappedCapture.hpp"
+
+#include <QAbstractTableModel>
+#include <QCache>
+#include <QSet>
+#include <QVector>
+
+/*
+Capture Model:
+Lists the messages of a capture from a seek position on. Rows are fetched in batches as the view
+scrolls, through canFetchMore() and fetchMore(), and a row keeps the few numbers it shows plus a
+short preview of the payload, so scrolling through an hour of traffic never copies a whole message.
+Instead of a seek position the model can list the matches of a CaptureSearch, as they arrive.
+With a decoder set the Decoded column shows the payload in its format. Only rows the view paints ask
+for it, the DecodeQueue decodes them off the GUI thread and the last MaxDecodedRows results are kept.
+*/
+class CaptureModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    static const int FetchSize = 256;
+    static const int PreviewSize = 32;
+    static const int MaxDecodedRows = 4096;
+    static const int SummarySize = 200;     // Characters of the decoded text shown in the column
+
+    enum Column
+    {
+        COL_TIME,
+        COL_ELAPSED,
+        COL_TOPIC,
+        COL_FRAMES,
+        COL_SIZE,
+        COL_POSITION,
+        COL_PREVIEW,
+        COL_DECODED,
+        COLUMN_COUNT
+    };
+
+    explicit CaptureModel(QObject *parent = 0);
+
+    /**
+     * @brief Maps a capture and lists it from the first message.
+     * @param path A segment of the capture, the following segments are opened too.
+     * @param error Receives a description of the problem if the capture cannot be opened.
+     * @return False if the capture cannot be opened, the model is empty then.
+     */
+    bool open(const QString& path, QString* error);
+
+    /**
+     * @brief Lists the capture from the first message received at or after a time.
+     * @param utcMs The wall clock time in ms since epoch.
+     * @param topic Only messages of this topic are listed, all if empty.
+     * @return None
+     */
+    void seek(qint64 utcMs, const QByteArray& topic);
+
+    /**
+     * @brief Removes all rows to list search results, appendMatches() adds them.
+     * @param None
+     * @return None
+     */
+    void showMatches();
+
+    /**
+     * @brief Lists messages found by a CaptureSearch on the open capture.
+     * @param matches The positions of the messages, in capture order.
+     * @return None
+     */
+    void appendMatches(const nzmqt::samples::CaptureMatches& matches);
+
+    /**
+     * @brief Unmaps the capture and removes all rows.
+     * @param None
+     * @return None
+     */
+    void close();
+
+    /**
+     * @brief Decodes the payloads of the rows shown through a queue, the results of another decoder are dropped when it changes.
+     * @param queue The queue of the main window, it outlives the model.
+     * @return None
+     */
+    void setDecodeQueue(nzmqt::samples::DecodeQueue* queue);
+
+    /**
+     * @brief The decoded payload of a row, a decode is requested if it is not known yet.
+     * @param row The row.
+     * @return The decoded text, or why it is not available; empty while it is decoded or without a decoder.
+     */
+    QString decodedText(int row) const;
+
+    const nzmqt::samples::MappedCapture& capture() const { return capture_; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+signals:
+    // The decoded payload of a row arrived, see decodedText()
+    void rowDecoded(int row);
+
+private slots:
+    void payloadDecoded(quint64 key, const QString& text, bool ok);
+    void clearDecoded();
+
+private:
+    struct Row
+    {
+        qint64 receiveNs;
+        int segment;
+        quint64 offset;
+        QByteArray topic;
+        int frames;
+        quint64 size;
+        QByteArray preview;     // The start of the last frame
+    };
+
+    struct Decoded
+    {
+        QString text;
+        bool ok;
+    };
+
+    static Row makeRow(const nzmqt::samples::CaptureCursor& cursor);
+
+    // Requests the decode of a row unless it is known or on its way
+    const Decoded* decoded(int row) const;
+
+    nzmqt::samples::MappedCapture capture_;
+    nzmqt::samples::CaptureCursor cursor_;     // The message after the last row
+    QVector<Row> rows_;
+    nzmqt::samples::DecodeQueue* decodeQueue_;
+    quint32 decodeEpoch_;                       // Changes with the rows and the decoder, older results are dropped
+    mutable QCache<int, Decoded> decoded_;      // By row
+    mutable QSet<int> decoding_;                // Rows requested and not back yet
+};
+
+#endif // CAPTUREMODEL_H
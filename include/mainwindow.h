@@ -15,9 +15,16 @@
 #include <QtTest/QtTest>
 #include <QtConcurrent/QtConcurrent>
 #include "SampleBase.hpp"
+#include "DecodeQueue.hpp"
+#include "DisplayRing.hpp"
+#include "ProtobufDecoder.hpp"
 #include "Subscriber.hpp"
 #include "Publisher.hpp"
+#include "RateSearchController.hpp"
+#include "TopicStats.hpp"
 #include "aboutdialog.h"
+#include "topicstatsmodel.h"
+#include "capturemodel.h"
 
 namespace Ui {
 class MainWindow;
@@ -38,6 +45,21 @@ public:
      */
     void logMessage(const QString &msg);
 
+    /**
+     * @brief Fills in the subscribe endpoints, e.g. from the command line.
+     * @param endpoints The publishers to connect to, see EndpointList.hpp.
+     * @param sockets The number of SUB sockets, 0 for one socket per endpoint.
+     * @return None
+     */
+    void setSubscribeEndpoints(const QStringList& endpoints, int sockets);
+
+    /**
+     * @brief Connects as if the "Connect" button was clicked.
+     * @param None
+     * @return None
+     */
+    void connectAll();
+
 signals:
     void updateTextEditSignal(QString str);
 
@@ -67,12 +89,12 @@ private:
     Subscriber Context:
     The subscriber context refers to creating and handling the subscriber side of a publish-subscribe pattern. It is symmetrical to the publisher context with some details:
     ZMQContext: Just like the publisher, the subscriber needs a ZMQ context for its operation.
-    Subscriber Creation: A subscriber is created within the same context, listening to the same endpoint that the publisher is using to publish the messages.
+    Subscriber Creation: A subscriber is created within the same context, connecting to every endpoint of the endpoint list, or to the one the publisher is using to publish the messages.
     Execution Thread: Similar to the publisher, the subscriber's functionality runs in a separate thread.
     Test Start: The subscriber thread starts with a slight delay (500 ms) and is stopped after 6 seconds, similar to the publisher.
     Postconditions Check: After the test is finished, conditions are checked to verify the behavior of the subscriber (e.g., number of pings received, failures, etc.).
     */
-    void subscribeInit(QString ipAddress, int port, bool useHex = false);
+    void subscribeInit(const QStringList& endpoints, int sockets, bool useHex = false);
 
 private slots:
     /**
@@ -105,12 +127,98 @@ private slots:
     void messageSent(const QString& timeStamp, const QList<QByteArray>& messageList);
 
     /**
-     * @brief This function is called when a message is received. It appends the timestamp and message to the subscribe text view.
-     * @param timeStamp The timestamp of the received message.
-     * @param messageList The list of messages received.
+     * @brief Shows the overall measured and corrected latency percentiles next to the subscribe counter, per topic values go to the tooltip.
+     * @param measured The latency from the actual send time, the first report covers all topics.
+     * @param corrected The latency from the intended send time, the first report covers all topics.
+     * @return None
+     */
+    void latencyReported(const nzmqt::samples::LatencyReports& measured, const nzmqt::samples::LatencyReports& corrected);
+
+    /**
+     * @brief Shows the loss counters of all stamped streams and logs new gaps.
+     * @param report The loss report of the subscriber.
+     * @return None
+     */
+    void lossReported(const nzmqt::samples::LossReport& report);
+
+    /**
+     * @brief Shows the corrected latency and loss by target rate, the highest rate seen goes to the label.
+     * @param report The rate bands of the subscriber, ordered by rate.
+     * @return None
+     */
+    void rateReported(const nzmqt::samples::RateReport& report);
+
+    /**
+     * @brief Counts the received streams and logs each one, the streams of the last report go to the tooltip.
+     * @param report The streams that completed or were given up since the previous report.
+     * @return None
+     */
+    void streamReported(const nzmqt::samples::StreamReport& report);
+
+    /**
+     * @brief Shows the payload verification counters and logs the sampled mismatches.
+     * @param report The counters of the subscriber and the mismatches sampled since its previous report.
+     * @return None
+     */
+    void integrityReported(const nzmqt::samples::IntegrityReport& report);
+
+    /**
+     * @brief Shows the progress of the recording and logs its first write error.
+     * @param status The counters of the capture writer.
+     * @return None
+     */
+    void captureReported(const nzmqt::samples::CaptureStatus& status);
+
+    /**
+     * @brief Shows how many publishers are connected, the traffic of every endpoint goes to the tooltip.
+     * @param report The connection states of the endpoints and the counters of the subscriber sockets.
+     * @return None
+     */
+    void endpointsReported(const nzmqt::samples::EndpointReport& report);
+
+    /**
+     * @brief Shows how many matches a payload search found and how much of the capture it read.
+     * @param summary The counters of the finished search.
+     * @return None
+     */
+    void captureSearchFinished(const nzmqt::samples::CaptureSearchSummary& summary);
+
+    /**
+     * @brief Appends the messages of the live view once their payloads are decoded.
+     * @param messages The messages as taken from the display ring, in order.
+     * @param undecoded The number of messages passed through undecoded because the decoder was behind.
+     * @return None
+     */
+    void messagesDecoded(const QVector<nzmqt::samples::DisplayMessage>& messages, int undecoded);
+
+    /**
+     * @brief Shows the decoded payload of the selected capture message.
+     * @param None
      * @return None
      */
-    void messageReceived(const QString& timeStamp, const QList<QByteArray>& messageList);
+    void showDecodedRow();
+
+    /**
+     * @brief Logs the result of one search step.
+     * @param measurement The latency and loss measured at the step's rate.
+     * @param passed True if the step met the limits.
+     * @return None
+     */
+    void rateSearchStepFinished(const nzmqt::samples::StepMeasurement& measurement, bool passed);
+
+    /**
+     * @brief Shows the highest rate that met the limits and the rate bracket it was narrowed to.
+     * @param None
+     * @return None
+     */
+    void rateSearchFinished();
+
+    /**
+     * @brief Reports a search that could not be completed.
+     * @param reason The description of the problem.
+     * @return None
+     */
+    void rateSearchFailed(const QString& reason);
 
     /**
      * @brief Updates the text edit with the buffered messages.
@@ -164,6 +272,132 @@ private slots:
      */
     void on_checkBoxLoop_stateChanged(int arg1);
 
+    /**
+     * @brief Enables the Zipf exponent while the Zipf distribution is selected.
+     * @param index The index of the selected distribution.
+     * @return void
+     */
+    void on_comboBoxTopicDistribution_currentIndexChanged(int index);
+
+    /**
+     * @brief Enables the replay file and speed inputs while the "Replay Capture" checkbox is checked.
+     * @param arg1 The new state of the checkbox (Qt::Checked or Qt::Unchecked).
+     * @return void
+     */
+    void on_checkBoxReplay_stateChanged(int arg1);
+
+    /**
+     * @brief Lets the user pick the capture file to replay.
+     * @param None
+     * @return void
+     */
+    void on_buttonReplayBrowse_clicked();
+
+    /**
+     * @brief Enables the payload file and slice size inputs while the "File Payload" checkbox is checked.
+     * @param arg1 The new state of the checkbox (Qt::Checked or Qt::Unchecked).
+     * @return void
+     */
+    void on_checkBoxPayloadFile_stateChanged(int arg1);
+
+    /**
+     * @brief Lets the user pick the file to publish.
+     * @param None
+     * @return void
+     */
+    void on_buttonPayloadBrowse_clicked();
+
+    /**
+     * @brief Enables the seeded payload size input while the "Seeded Payload" checkbox is checked.
+     * @param arg1 The new state of the checkbox (Qt::Checked or Qt::Unchecked).
+     * @return void
+     */
+    void on_checkBoxSeeded_stateChanged(int arg1);
+
+    /**
+     * @brief Enables the chunk size and window inputs while the "Stream Chunks" checkbox is checked.
+     * @param arg1 The new state of the checkbox (Qt::Checked or Qt::Unchecked).
+     * @return void
+     */
+    void on_checkBoxStream_stateChanged(int arg1);
+
+    /**
+     * @brief Lets the user pick the directory received streams are written to.
+     * @param None
+     * @return void
+     */
+    void on_buttonStreamDirBrowse_clicked();
+
+    /**
+     * @brief Lets the user pick the name of the capture to record, the segment suffix is removed.
+     * @param None
+     * @return void
+     */
+    void on_buttonCaptureBrowse_clicked();
+
+    /**
+     * @brief Lets the user pick a capture and shows it in the CaptureView tab.
+     * @param None
+     * @return void
+     */
+    void on_buttonViewBrowse_clicked();
+
+    /**
+     * @brief Loads the subscribe endpoints from a file into the endpoints field.
+     * @param None
+     * @return None
+     */
+    void on_buttonEndpointsBrowse_clicked();
+
+    /**
+     * @brief Switches the payload decoder of the message views.
+     * @param index The format, in the order of the Decode As box.
+     * @return None
+     */
+    void on_comboBoxDecoder_currentIndexChanged(int index);
+
+    /**
+     * @brief Decodes protobuf payloads as the message type typed in.
+     * @param None
+     * @return None
+     */
+    void on_lineEditProtobufType_editingFinished();
+
+    /**
+     * @brief Loads the protobuf message types from a descriptor set.
+     * @param None
+     * @return None
+     */
+    void on_buttonDescriptorsBrowse_clicked();
+
+    /**
+     * @brief Shows the capture typed into the file field in the CaptureView tab.
+     * @param None
+     * @return void
+     */
+    void on_lineEditViewFile_returnPressed();
+
+    /**
+     * @brief Lists the viewed capture from the selected time and topic.
+     * @param None
+     * @return void
+     */
+    void on_buttonViewSeek_clicked();
+
+    /**
+     * @brief Lists the messages of the viewed capture whose payload contains the search bytes.
+     * @param None
+     * @return void
+     */
+    void on_buttonViewFind_clicked();
+
+    /**
+     * @brief Searches the viewed capture for the bytes typed into the search field.
+     * @param None
+     * @return void
+     */
+    void on_lineEditViewSearch_returnPressed();
+
     /**
      * @brief Overrides the changeEvent function to handle language change events.
      * @param e A pointer to the QEvent object.
@@ -225,15 +459,23 @@ private slots:
     void unsubscribeMessage(nzmqt::samples::pubsub::Subscriber*);
 
     /**
-     * @brief Publishes a message to a given publisher.
-     * @param publisher A pointer to the publisher object.
+     * @brief Publishes a message to the given publishers.
+     * @param publishers The publisher workers, each one runs its share of the rate.
      * @return bool True if the message was published successfully, false otherwise.
      * @note This function retrieves the topic and contents of the message from the UI view. 
      *       If either of them is invalid, an error message is displayed and the function returns. 
-     *       Otherwise, the topic and contents are added to a QStringList and passed to the publisher's startAction() function. 
+     *       Otherwise, the topic and contents are added to a QStringList and passed to each publisher's startAction() function. 
      *       Finally, a status message is displayed on the UI view.
      */
-    bool publishMessage(nzmqt::samples::pubsub::Publisher*);
+    bool publishMessage(const QList<nzmqt::samples::pubsub::Publisher*>&);
+
+    /**
+     * @brief Reads and validates the topic set and the message of the publish section.
+     * @param messages Receives the topic and the message as passed to Publisher::startAction().
+     * @param topics Receives the parsed topic set with the selected distribution.
+     * @return bool False if the topic or the message is invalid, an error message has been shown then.
+     */
+    bool readPublishMessage(QStringList* messages, nzmqt::samples::TopicSampler* topics);
 
 private:
     Ui::MainWindow *ui;
@@ -249,7 +491,46 @@ private:
     QMutex slotMutex;
 
     bool isSendMode = true; // starting state is Send mode
+    nzmqt::samples::PublisherStatsList publisherStats; // One entry per publisher worker
+    quint64 streamsComplete = 0;    // Streams reassembled since the start
+    quint64 streamsIncomplete = 0;  // Streams given up with chunks missing
+    QString captureError;           // Write error of the recording, logged once
+    QVector<quint32> endpointDisconnects;   // Per endpoint at the previous report, new ones are logged
+    static const int MaxEndpointRows = 64;  // Endpoints listed in the tooltip of the endpoint label
+    nzmqt::samples::RateSearchController* rateSearch;   // Max sustainable rate search, see RateSearch.hpp
+    QSharedPointer<nzmqt::samples::TopicStats> topicStats; // Per topic counters of the subscriber
+    QSharedPointer<nzmqt::samples::DisplayRing> displayRing;   // Received messages waiting for the text view
+    QVector<nzmqt::samples::DisplayMessage> displayMessages;    // Taken from displayRing, kept to reuse the memory
+    nzmqt::samples::DecodeQueue* decodeQueue;   // Decodes the payloads the views show, see DecodeQueue.hpp
+    QSharedPointer<const nzmqt::samples::ProtobufDescriptors> protobufDescriptors;
+    quint64 undecodedMessages = 0;  // Shown as received since the live view decoder fell behind
+    TopicStatsModel* topicStatsModel;
+    CaptureModel* captureModel;     // Capture shown in the CaptureView tab
+    nzmqt::samples::CaptureSearch* captureSearch;   // Payload search in the viewed capture, see CaptureSearch.hpp
     
+    /**
+     * @brief Formats a message for the text view.
+     * @param lines Receives the lines of the message.
+     * @param timeStamp The timestamp of the message.
+     * @param messageList The topic and the frames of the message.
+     * @return None
+     */
+    static void appendMessage(QStringList* lines, const QString& timeStamp, const QList<QByteArray>& messageList);
+
+    /**
+     * @brief Creates the decoder chosen in the Decode As box and hands it to the decode queue.
+     * @param None
+     * @return None
+     */
+    void applyDecoder();
+
+    /**
+     * @brief Shows the counters of the display ring with the subscribe counter.
+     * @param counters The counters as returned by DisplayRing::take().
+     * @return None
+     */
+    void showDisplayCounters(const nzmqt::samples::DisplayCounters& counters);
+
     /**
      * @brief Initializes the table view for subscribing to topics.
      * @param None
@@ -258,9 +539,9 @@ private:
     void initTable();
 
     /**
-     * @brief Checks if the given string contains only alphanumeric characters.
+     * @brief Checks if the given string contains only alphanumeric characters, '/' and the wildcards '#' and '+'.
      * @param str The string to be checked.
-     * @return True if the string contains only alphanumeric characters, false otherwise.
+     * @return True if the string contains only allowed characters, false otherwise.
      */
     bool isValidString(const QString &str);
 
@@ -271,6 +552,41 @@ private:
      * @return True if the string is a valid IPv4 address, false otherwise.
      */
     bool isValidIPv4(const QString &ip);
+
+    /**
+     * @brief Formats a duration in nanoseconds with a unit that keeps three significant digits.
+     * @param ns The duration in nanoseconds.
+     * @return The formatted duration, e.g. "12.3 us".
+     */
+    static QString formatDuration(qint64 ns);
+
+    /**
+     * @brief Switches the search button between starting and aborting, the send button is disabled while a search runs.
+     * @param running True while a search runs.
+     * @return None
+     */
+    void setRateSearchRunning(bool running);
+
+    /**
+     * @brief Returns the file to publish instead of the message.
+     * @param None
+     * @return QString The selected file, empty if the "File Payload" checkbox is not checked.
+     */
+    QString payloadFile() const;
+
+    /**
+     * @brief Returns the size of the frames the payload file is split into.
+     * @param None
+     * @return qint64 The slice size in bytes, 0 for the whole file.
+     */
+    qint64 payloadSliceSize() const;
+
+    /**
+     * @brief Opens a capture in the CaptureView tab and fills in its time range and topics.
+     * @param path A segment of the capture.
+     * @return None
+     */
+    void openCaptureView(const QString& path);
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,70 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef TOPICSTATSMODEL_H
+#define TOPICSTATSMODEL_H
+
+#include "TopicStats.hpp"
+
+#include <QAbstractTableModel>
+#include <QSharedPointer>
+#include <QVector>
+
+/*
+Topic Stats Model:
+Shows the latest TopicStatsSnapshot as a table. The model sorts the rows itself instead of going
+through a QSortFilterProxyModel: a new snapshot keeps the chosen column and order and re-sorts one
+vector of row indexes by the raw numbers, which stays cheap with 100k topics at the GUI frame rate.
+*/
+class TopicStatsModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column
+    {
+        COL_TOPIC,
+        COL_MESSAGES,
+        COL_MESSAGE_RATE,
+        COL_BYTE_RATE,
+        COL_MIN_SIZE,
+        COL_AVG_SIZE,
+        COL_MAX_SIZE,
+        COL_LAST_SEEN,
+        COL_JITTER,
+        COLUMN_COUNT
+    };
+
+    explicit TopicStatsModel(QObject *parent = 0);
+
+    /**
+     * @brief Shows a new snapshot, the rows keep the current sort order.
+     * @param snapshot The snapshot, a snapshot that is already shown is ignored.
+     * @return None
+     */
+    void setSnapshot(const QSharedPointer<const nzmqt::samples::TopicStatsSnapshot>& snapshot);
+
+    /**
+     * @brief Removes all rows, e.g. when a new subscriber starts.
+     * @param None
+     * @return None
+     */
+    void clear();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+private:
+    void relayout();
+    void sortRows();
+
+    QSharedPointer<const nzmqt::samples::TopicStatsSnapshot> snapshot_;
+    QVector<int> order_;        // Row of the view to row of the snapshot
+    int sortColumn_;
+    Qt::SortOrder sortOrder_;
+};
+
+#endif // TOPICSTATSMODEL_H
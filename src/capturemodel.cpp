@@ -0,0 +1,354 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "capturemodel.h"
+#include "HexCodec.hpp"
+
+#include <QDateTime>
+
+using nzmqt::samples::CaptureCursor;
+using nzmqt::samples::CaptureMatch;
+using nzmqt::samples::CaptureMatches;
+using nzmqt::samples::DecodeQueue;
+using nzmqt::samples::HexCodec;
+
+CaptureModel::CaptureModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , decodeQueue_(0), decodeEpoch_(0), decoded_(MaxDecodedRows)
+{
+}
+
+
+/**
+ * @brief Maps a capture and lists it from the first message.
+ * @param path A segment of the capture, the following segments are opened too.
+ * @param error Receives a description of the problem if the capture cannot be opened.
+ * @return False if the capture cannot be opened, the model is empty then.
+ */
+bool CaptureModel::open(const QString& path, QString* error)
+{
+    beginResetModel();
+    rows_.clear();
+    clearDecoded();
+    cursor_ = CaptureCursor();
+    bool opened = capture_.open(path, error);
+    if (opened)
+    {
+        cursor_ = capture_.first();
+    }
+    endResetModel();
+    return opened;
+}
+
+
+/**
+ * @brief Lists the capture from the first message received at or after a time.
+ * @param utcMs The wall clock time in ms since epoch.
+ * @param topic Only messages of this topic are listed, all if empty.
+ * @return None
+ */
+void CaptureModel::seek(qint64 utcMs, const QByteArray& topic)
+{
+    if (!capture_.isOpen())
+    {
+        return;
+    }
+
+    beginResetModel();
+    rows_.clear();
+    clearDecoded();
+    cursor_ = capture_.seek(capture_.fromUtcMs(utcMs), topic);
+    endResetModel();
+}
+
+
+/**
+ * @brief Removes all rows to list search results, appendMatches() adds them.
+ * @param None
+ * @return None
+ */
+void CaptureModel::showMatches()
+{
+    beginResetModel();
+    rows_.clear();
+    clearDecoded();
+    cursor_ = CaptureCursor();
+    endResetModel();
+}
+
+
+/**
+ * @brief Lists messages found by a CaptureSearch on the open capture.
+ * @param matches The positions of the messages, in capture order.
+ * @return None
+ */
+void CaptureModel::appendMatches(const CaptureMatches& matches)
+{
+    QVector<Row> rows;
+    rows.reserve(matches.size());
+    for (const CaptureMatch& match : matches)
+    {
+        CaptureCursor cursor = capture_.at(match.segment, match.offset);
+        if (cursor.isValid())
+        {
+            rows.append(makeRow(cursor));
+        }
+    }
+    if (rows.isEmpty())
+    {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), rows_.size(), rows_.size() + rows.size() - 1);
+    rows_ += rows;
+    endInsertRows();
+}
+
+
+/**
+ * @brief Unmaps the capture and removes all rows.
+ * @param None
+ * @return None
+ */
+void CaptureModel::close()
+{
+    beginResetModel();
+    rows_.clear();
+    clearDecoded();
+    cursor_ = CaptureCursor();
+    capture_.close();
+    endResetModel();
+}
+
+
+int CaptureModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows_.size();
+}
+
+
+int CaptureModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+
+QVariant CaptureModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows_.size())
+    {
+        return QVariant();
+    }
+
+    if (role == Qt::TextAlignmentRole)
+    {
+        bool left = index.column() == COL_TOPIC || index.column() >= COL_PREVIEW;
+        return left ? QVariant(Qt::AlignLeft | Qt::AlignVCenter) : QVariant(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    if (index.column() == COL_DECODED && role == Qt::ToolTipRole)
+    {
+        const Decoded* decoded = this->decoded(index.row());
+        return decoded ? QVariant(decoded->text) : QVariant();
+    }
+    if (role != Qt::DisplayRole)
+    {
+        return QVariant();
+    }
+
+    const Row& row = rows_.at(index.row());
+    switch (index.column())
+    {
+    case COL_TIME:
+        return QDateTime::fromMSecsSinceEpoch(capture_.toUtcMs(row.receiveNs)).toString("yyyy-MM-dd hh:mm:ss.zzz")
+            + QString("%1").arg((row.receiveNs % 1000000) / 1000, 3, 10, QChar('0'));
+    case COL_ELAPSED:
+        return QString::number((row.receiveNs - capture_.firstNs()) / 1e9, 'f', 6);
+    case COL_TOPIC:
+        return QString::fromUtf8(row.topic);
+    case COL_FRAMES:
+        return row.frames;
+    case COL_SIZE:
+        return QString::number(row.size);
+    case COL_POSITION:
+        return QString("%1:%2").arg(row.segment).arg(row.offset);
+    case COL_PREVIEW:
+        return QString::fromLatin1(HexCodec::toSpacedHex(row.preview));
+    case COL_DECODED:
+    {
+        // Painting the cell is what asks for the decode, rows scrolled past are never decoded
+        const Decoded* decoded = this->decoded(index.row());
+        if (!decoded)
+        {
+            return decodeQueue_ && decodeQueue_->decoder() ? tr("Decoding...") : QVariant();
+        }
+        QString summary = decoded->text.simplified();
+        return summary.size() > SummarySize ? summary.left(SummarySize) + "..." : summary;
+    }
+    default:
+        return QVariant();
+    }
+}
+
+
+QVariant CaptureModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+    {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section)
+    {
+    case COL_TIME:
+        return tr("Received");
+    case COL_ELAPSED:
+        return tr("Elapsed (s)");
+    case COL_TOPIC:
+        return tr("Topic");
+    case COL_FRAMES:
+        return tr("Frames");
+    case COL_SIZE:
+        return tr("Size");
+    case COL_POSITION:
+        return tr("Segment:Offset");
+    case COL_PREVIEW:
+        return tr("Payload");
+    case COL_DECODED:
+        return decodeQueue_ && decodeQueue_->decoder() ? decodeQueue_->decoder()->name() : tr("Decoded");
+    default:
+        return QVariant();
+    }
+}
+
+
+bool CaptureModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && cursor_.isValid();
+}
+
+
+// Materializes the next rows from the cursor, only the preview bytes of a message are copied
+void CaptureModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid() || !cursor_.isValid())
+    {
+        return;
+    }
+
+    QVector<Row> rows;
+    rows.reserve(FetchSize);
+    for (int i = 0; i < FetchSize && cursor_.isValid(); ++i, cursor_.next())
+    {
+        rows.append(makeRow(cursor_));
+    }
+
+    beginInsertRows(QModelIndex(), rows_.size(), rows_.size() + rows.size() - 1);
+    rows_ += rows;
+    endInsertRows();
+}
+
+
+CaptureModel::Row CaptureModel::makeRow(const CaptureCursor& cursor)
+{
+    Row row;
+    row.receiveNs = cursor.receiveNs();
+    row.segment = cursor.segment();
+    row.offset = cursor.offset();
+    row.topic = cursor.topic();
+    row.frames = cursor.frameCount();
+    row.size = cursor.dataSize();
+    if (row.frames > 1)
+    {
+        QByteArray payload = cursor.frame(row.frames - 1);
+        row.preview = QByteArray(payload.constData(), qMin(payload.size(), static_cast<int>(PreviewSize)));
+    }
+    return row;
+}
+
+
+/**
+ * @brief Decodes the payloads of the rows shown through a queue, the results of another decoder are dropped when it changes.
+ * @param queue The queue of the main window, it outlives the model.
+ * @return None
+ */
+void CaptureModel::setDecodeQueue(DecodeQueue* queue)
+{
+    decodeQueue_ = queue;
+    connect(queue, &DecodeQueue::payloadDecoded, this, &CaptureModel::payloadDecoded);
+    connect(queue, &DecodeQueue::decoderChanged, this, &CaptureModel::clearDecoded);
+}
+
+
+/**
+ * @brief The decoded payload of a row, a decode is requested if it is not known yet.
+ * @param row The row.
+ * @return The decoded text, or why it is not available; empty while it is decoded or without a decoder.
+ */
+QString CaptureModel::decodedText(int row) const
+{
+    const Decoded* decoded = row >= 0 && row < rows_.size() ? this->decoded(row) : 0;
+    return decoded ? decoded->text : QString();
+}
+
+
+const CaptureModel::Decoded* CaptureModel::decoded(int row) const
+{
+    if (!decodeQueue_ || !decodeQueue_->decoder())
+    {
+        return 0;
+    }
+    const Decoded* decoded = decoded_.object(row);
+    if (decoded || decoding_.contains(row))
+    {
+        return decoded;
+    }
+
+    const Row& r = rows_.at(row);
+    CaptureCursor cursor = capture_.at(r.segment, r.offset);
+    QByteArray payload = cursor.isValid() && cursor.frameCount() > 1 ? cursor.frame(cursor.frameCount() - 1) : QByteArray();
+    if (payload.isNull() || payload.size() > DecodeQueue::MaxPayloadSize)
+    {
+        Decoded* skipped = new Decoded;
+        skipped->text = payload.isNull() ? tr("No payload") : tr("Larger than %1 bytes, not decoded").arg(DecodeQueue::MaxPayloadSize);
+        skipped->ok = false;
+        decoded_.insert(row, skipped);
+        return skipped;
+    }
+
+    // The payload is copied out of the mapping, the capture may be closed before the decode runs
+    decoding_.insert(row);
+    decodeQueue_->decodePayload(quint64(decodeEpoch_) << 32 | static_cast<quint32>(row), QByteArray(payload.constData(), payload.size()));
+    return 0;
+}
+
+
+void CaptureModel::payloadDecoded(quint64 key, const QString& text, bool ok)
+{
+    int row = static_cast<int>(key & 0xFFFFFFFF);
+    if (static_cast<quint32>(key >> 32) != decodeEpoch_ || row >= rows_.size())
+    {
+        return;
+    }
+
+    Decoded* decoded = new Decoded;
+    decoded->text = text;
+    decoded->ok = ok;
+    decoding_.remove(row);
+    decoded_.insert(row, decoded);
+    emit dataChanged(index(row, COL_DECODED), index(row, COL_DECODED));
+    emit rowDecoded(row);
+}
+
+
+// Results of the previous rows or decoder are dropped, the shown rows ask again
+void CaptureModel::clearDecoded()
+{
+    ++decodeEpoch_;
+    decoded_.clear();
+    decoding_.clear();
+    if (!rows_.isEmpty())
+    {
+        emit dataChanged(index(0, COL_DECODED), index(rows_.size() - 1, COL_DECODED));
+    }
+    emit headerDataChanged(Qt::Horizontal, COL_DECODED, COL_DECODED);
+}
@@ -9,7 +9,10 @@
 #include <QtGui/QApplication>
 #endif
 #include "mainwindow.h"
+#include "EndpointList.hpp"
+#include <QCommandLineParser>
 #include <QTextCodec>
+#include <cstdio>
 
 MainWindow *mainWindowInstance = nullptr;
 
@@ -45,6 +48,30 @@ int main(int argc, char *argv[])
 #if QT_VERSION < 0x050000
     QTextCodec::setCodecForTr(QTextCodec::codecForName("utf8"));
 #endif
+
+    // Fan-in tests name their publishers on the command line, e.g. --endpoints 10.0.0.5:5550-5589 --connect
+    QCommandLineParser parser;
+    parser.setApplicationDescription("ZeroMQ publish/subscribe test tool");
+    parser.addHelpOption();
+    QCommandLineOption endpointsOption("endpoints", "Publishers to subscribe to, separated by commas, host:port-port adds one per port.", "list");
+    QCommandLineOption endpointsFileOption("endpoints-file", "Reads the publishers to subscribe to from a file, '#' starts a comment.", "path");
+    QCommandLineOption socketsOption("sockets", "Number of SUB sockets the endpoints are spread over, 0 for one per endpoint.", "count", "0");
+    QCommandLineOption connectOption("connect", "Connects right away.");
+    parser.addOptions({ endpointsOption, endpointsFileOption, socketsOption, connectOption });
+    parser.process(a);
+
+    QStringList endpoints;
+    QStringList fileEndpoints;
+    QString error;
+    bool valid = nzmqt::samples::EndpointList::parse(parser.value(endpointsOption), &endpoints, &error)
+        && (!parser.isSet(endpointsFileOption) || nzmqt::samples::EndpointList::load(parser.value(endpointsFileOption), &fileEndpoints, &error))
+        && nzmqt::samples::EndpointList::parse((endpoints + fileEndpoints).join(' '), &endpoints, &error);
+    if (!valid)
+    {
+        fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+
     MainWindow w;
     // mainWindowInstance should be a global or static pointer to the MainWindow instance
     mainWindowInstance = &w;
@@ -53,6 +80,15 @@ int main(int argc, char *argv[])
     qInstallMessageHandler(DebugMessageHandler);
 #endif
 
+    if (!endpoints.isEmpty())
+    {
+        w.setSubscribeEndpoints(endpoints, parser.value(socketsOption).toInt());
+    }
+
     w.show();
+    if (parser.isSet(connectOption))
+    {
+        w.connectAll();
+    }
     return a.exec();
 }
@@ -3,10 +3,15 @@
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "MessagePackDecoder.hpp"
 
 #include <cppzmq/zmq.hpp>
+#include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
 
+#include <algorithm>
+
 using namespace nzmqt;
 
 MainWindow::MainWindow(QWidget *parent) :
@@ -15,6 +20,26 @@ MainWindow::MainWindow(QWidget *parent) :
 {
     ui->setupUi(this);
 
+    qRegisterMetaType<nzmqt::samples::LatencyReports>("nzmqt::samples::LatencyReports");
+    qRegisterMetaType<nzmqt::samples::LossReport>("nzmqt::samples::LossReport");
+    qRegisterMetaType<nzmqt::samples::RateReport>("nzmqt::samples::RateReport");
+    qRegisterMetaType<nzmqt::samples::StepMeasurement>("nzmqt::samples::StepMeasurement");
+    qRegisterMetaType<nzmqt::samples::StreamReport>("nzmqt::samples::StreamReport");
+    qRegisterMetaType<nzmqt::samples::IntegrityReport>("nzmqt::samples::IntegrityReport");
+    qRegisterMetaType<nzmqt::samples::CaptureStatus>("nzmqt::samples::CaptureStatus");
+    qRegisterMetaType<nzmqt::samples::CaptureMatches>("nzmqt::samples::CaptureMatches");
+    qRegisterMetaType<nzmqt::samples::CaptureSearchSummary>("nzmqt::samples::CaptureSearchSummary");
+    qRegisterMetaType<nzmqt::samples::EndpointReport>("nzmqt::samples::EndpointReport");
+
+    // The search outlives the publishers and the subscriber of a single start, they are attached in publishInit() and subscribeInit()
+    rateSearch = new samples::RateSearchController(this);
+    connect(rateSearch, &samples::RateSearchController::stepStarted, this, [this](double rate) {
+        ui->statusBar->showMessage(tr("Searching max rate, measuring %1 msg/s ...").arg(rate, 0, 'f', 0));
+    });
+    connect(rateSearch, &samples::RateSearchController::stepFinished, this, &MainWindow::rateSearchStepFinished);
+    connect(rateSearch, &samples::RateSearchController::searchFinished, this, &MainWindow::rateSearchFinished);
+    connect(rateSearch, &samples::RateSearchController::searchFailed, this, &MainWindow::rateSearchFailed);
+
     connect(this, &MainWindow::updateTextEditSignal, ui->textView, &QTextEdit::append);
     connect(this, &MainWindow::showMessageSignal, ui->logMessage, &QTextEdit::append);
     // Create the timer but don't start it yet, it will be started once the buttonStart is clicked
@@ -28,6 +53,52 @@ MainWindow::MainWindow(QWidget *parent) :
 
     initTable();
 
+    // The ring is thread safe, the policy changes while the subscriber runs
+    connect(ui->comboBoxDisplayPolicy, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        if (displayRing)
+        {
+            displayRing->setPolicy(static_cast<samples::DisplayRing::Policy>(index));
+        }
+    });
+
+    // Sorted by the model itself, see topicstatsmodel.h; the busiest topics come first
+    topicStatsModel = new TopicStatsModel(this);
+    ui->tableViewTopicStats->setModel(topicStatsModel);
+    ui->tableViewTopicStats->setSortingEnabled(true);
+    ui->tableViewTopicStats->sortByColumn(TopicStatsModel::COL_MESSAGE_RATE, Qt::DescendingOrder);
+    ui->tableViewTopicStats->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+
+    // Rows are read from the mapped capture while scrolling, see capturemodel.h
+    captureModel = new CaptureModel(this);
+    ui->tableViewCapture->setModel(captureModel);
+    ui->tableViewCapture->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    ui->tableViewCapture->horizontalHeader()->setStretchLastSection(true);
+    ui->dateTimeEditViewSeek->setEnabled(false);
+    ui->comboBoxViewTopic->setEnabled(false);
+    ui->buttonViewSeek->setEnabled(false);
+    ui->lineEditViewSearch->setEnabled(false);
+    ui->buttonViewFind->setEnabled(false);
+
+    // Payloads are decoded on a worker thread and only for the messages shown, see DecodeQueue.hpp
+    decodeQueue = new samples::DecodeQueue(this);
+    captureModel->setDecodeQueue(decodeQueue);
+    connect(decodeQueue, &samples::DecodeQueue::messagesDecoded, this, &MainWindow::messagesDecoded);
+    connect(decodeQueue, &samples::DecodeQueue::decoderChanged, this, &MainWindow::showDecodedRow);
+    connect(ui->tableViewCapture->selectionModel(), &QItemSelectionModel::currentRowChanged, this, &MainWindow::showDecodedRow);
+    connect(captureModel, &CaptureModel::rowDecoded, this, [this](int row) {
+        if (row == ui->tableViewCapture->currentIndex().row())
+        {
+            showDecodedRow();
+        }
+    });
+    ui->lineEditProtobufType->setEnabled(false);
+    ui->buttonDescriptorsBrowse->setEnabled(false);
+
+    // Matches stream into the capture view while the search goes on
+    captureSearch = new samples::CaptureSearch(this);
+    connect(captureSearch, &samples::CaptureSearch::matchesFound, captureModel, &CaptureModel::appendMatches);
+    connect(captureSearch, &samples::CaptureSearch::searchFinished, this, &MainWindow::captureSearchFinished);
+
     ui->tableViewTopics->setSelectionBehavior(QAbstractItemView::SelectRows);
     ui->buttonSend->setEnabled(false);
     ui->buttonStop->setEnabled(false);
@@ -36,6 +107,7 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->textView->setReadOnly(true);
     ui->decDisplay->setChecked(true);
     ui->checkBoxLoop->setChecked(false);
+    ui->checkBoxStamp->setChecked(false);
     ui->statusBar->showMessage(tr("Welcome to use ZeroMQ Test Tool!"));
     ui->jouav->setText(tr("<a href=\"http://www.jouav.com\">www.jouav.com</a>"));
 }
@@ -132,32 +204,124 @@ void MainWindow::publishInit(QString ipAddress, int port, bool useHex)
     {
         QSharedPointer<ZMQContext> context(nzmqt::createDefaultContext());
 
-        // Create the connection string using the given IP address and port
-        QString connectionString = QString("tcp://%1:%2").arg(ipAddress).arg(port);
+        // Load generator: every worker gets its own thread and socket, optionally its own context.
+        // Workers either bind consecutive ports or all connect to one endpoint, e.g. an XSUB/XPUB proxy.
+        int workerCount = ui->spinBoxWorkers->value();
+        bool connectShared = ui->comboBoxWorkerMode->currentIndex() == 1;
+        bool ownContext = ui->checkBoxWorkerContext->isChecked();
+
+        QList<samples::pubsub::Publisher*> publishers;
+        publisherStats.clear();
+        for (int i = 0; i < workerCount; ++i)
+        {
+            QSharedPointer<ZMQContext> workerContext = context;
+            if (ownContext && i > 0)
+            {
+                workerContext = QSharedPointer<ZMQContext>(nzmqt::createDefaultContext());
+            }
+
+            // Create the connection string using the given IP address and port
+            QString connectionString = connectShared
+                ? QString("tcp://%1:%2").arg(ui->lineEditHost->text()).arg(port)
+                : QString("tcp://%1:%2").arg(ipAddress).arg(port + i);
+
+            // Create publisher with the connection string
+            samples::pubsub::Publisher* publisher = new samples::pubsub::Publisher(*workerContext, connectionString, useHex, this);
+            publisher->setObjectName(QString("Publisher.%1").arg(i));
+            publisher->setConnect(connectShared);
+            QSharedPointer<samples::PublisherStats> stats(new samples::PublisherStats);
+            publisher->setStats(stats);
+            publisherStats.append(stats);
+
+            connect(publisher, SIGNAL(messageSent(const QString&, const QList<QByteArray>&)), SLOT(messageSent(const QString&, const QList<QByteArray>&)));
+            connect(publisher, SIGNAL(finished()), SLOT(messageFinished()));
+            connect(publisher, SIGNAL(signal_log(int, const QString&)), SLOT(handleLogMessage(int, const QString&)));
+
+            // Stop publishing after user clicked the stop button
+            connect(ui->buttonStop, &QPushButton::clicked, publisher, &samples::pubsub::Publisher::stop);
+
+            // Create publisher execution thread.
+            QThread* publisherThread = makeExecutionThread(*publisher);
+            connect(publisherThread, &QThread::finished, [workerContext](){}); // Keeps the context alive until the thread finishes
+
+            // START TEST
+            if (workerContext != context || i == 0)
+            {
+                workerContext->start();
+            }
+            publisherThread->start();
+            publishers.append(publisher);
+        }
 
-        // Create publisher with the connection string
-        samples::pubsub::Publisher* publisher = new samples::pubsub::Publisher(*context, connectionString, useHex, this);
-        connect(publisher, SIGNAL(messageSent(const QString&, const QList<QByteArray>&)), SLOT(messageSent(const QString&, const QList<QByteArray>&)));
-        connect(publisher, SIGNAL(finished()), SLOT(messageFinished()));
-        connect(publisher, SIGNAL(signal_log(int, const QString&)), SLOT(handleLogMessage(int, const QString&)));
-        
         // Start subscriber after user clicked the add button (startAction), and stop after user clicked the stop button when the frequency is not equivalent to 0 (stopAction)
         // Note: Since we don't have a direct reference to the lambda to use in a disconnect call,
         // we need to utilize the QMetaObject::Connection object returned by the connect function to be able to disconnect it.
         // Connect your button once and use the state to decide the action
         // We need to capture the isSendMode variable by reference in the lambda so that changes to its value persist across multiple invocations of the lambda.
-        QMetaObject::Connection publishMessageConnection = connect(ui->buttonSend, &QPushButton::clicked, this, [this, publisher]() {
-            if (isSendMode) 
+        QMetaObject::Connection publishMessageConnection = connect(ui->buttonSend, &QPushButton::clicked, this, [this, publishers]() {
+            if (isSendMode && ui->checkBoxReplay->isChecked())
+            {
+                // Replay runs until the capture ends or the user stops it, it uses the first worker only
+                QString path = ui->lineEditReplayFile->text();
+                if (!QFileInfo::exists(path))
+                {
+                    QMessageBox::critical(this, tr("Error"), tr("Please select a capture file"));
+                    ui->statusBar->showMessage(tr("Please select a capture file"));
+                    return;
+                }
+
+                static const double speeds[] = { 1.0, 2.0, 10.0, 0.0 };
+                samples::pubsub::Publisher* publisher = publishers.first();
+                double speed = speeds[qBound(0, ui->comboBoxReplaySpeed->currentIndex(), 3)];
+                bool stamped = ui->checkBoxStamp->isChecked();
+                QMetaObject::invokeMethod(publisher, [publisher, path, speed, stamped]() {
+                    publisher->setReplay(path, speed);
+                    publisher->setStamped(stamped);
+                    publisher->startAction(QStringList());
+                }, Qt::QueuedConnection);
+
+                ui->statusBar->showMessage(tr("Replaying capture ..."));
+                ui->buttonSend->setText(tr("Stop"));
+                ui->buttonSend->setIcon(QIcon(":/images/stop.png"));
+                isSendMode = false;  // Switch to "Stop" mode
+            }
+            else if (isSendMode) 
             {
                 int frequency = 0;
+                samples::LoadProfile profile;
                 if (ui->checkBoxLoop->isChecked())
                 {
                     frequency = ui->publishFrequency->value();
+                    profile = samples::LoadProfile::constant(frequency);
+
+                    QString error;
+                    QString spec = ui->lineEditLoadProfile->text().trimmed();
+                    if (!spec.isEmpty() && !profile.parse(spec, &error))
+                    {
+                        QMessageBox::critical(this, tr("Error"), error);
+                        ui->statusBar->showMessage(error);
+                        return;
+                    }
+                }
+
+                // The workers share the rate and interleave their schedules, their threads apply it before the start
+                bool stamped = ui->checkBoxStamp->isChecked();
+                for (int i = 0; i < publishers.size(); ++i)
+                {
+                    samples::pubsub::Publisher* publisher = publishers.at(i);
+                    double share = 1.0 / publishers.size();
+                    double phase = static_cast<double>(i) / publishers.size();
+                    QMetaObject::invokeMethod(publisher, [publisher, profile, share, phase, stamped]() {
+                        publisher->setLoadProfile(profile);
+                        publisher->setShare(share);
+                        publisher->setPhase(phase);
+                        publisher->setReplay(QString(), 1.0);
+                        publisher->setStamped(stamped);
+                    }, Qt::QueuedConnection);
                 }
-                publisher->setFrequency(frequency);
 
-                // This block handles the "Send" behavior
-                bool res = publishMessage(publisher);
+                // This block handles the "Send" behavior, a single message is sent by the first worker only
+                bool res = publishMessage(frequency != 0 ? publishers : publishers.mid(0, 1));
 
                 if (frequency != 0 && res) 
                 {
@@ -169,39 +333,73 @@ void MainWindow::publishInit(QString ipAddress, int port, bool useHex)
             else
             {
                 // This block handles the "Stop" behavior (stopAction)
-                publisher->stopAction();
+                for (samples::pubsub::Publisher* publisher : publishers)
+                {
+                    publisher->stopAction();
+                }
                 ui->buttonSend->setText(tr("Send"));
                 ui->buttonSend->setIcon(QIcon(":/images/send.png"));
                 isSendMode = true;  // Switch back to "Send" mode
             }
         });
         
-        // Stop publishing after user clicked the stop button
-        connect(ui->buttonStop, &QPushButton::clicked, publisher, &samples::pubsub::Publisher::stop);
-        // Disconnect the ui->buttonSend when ui->buttonStop is clicked
-        connect(ui->buttonStop, &QPushButton::clicked, this, [this, publishMessageConnection](){
-            disconnect(publishMessageConnection);
-        });
+        // The rate search takes over all workers until it finishes or the user aborts it
+        QMetaObject::Connection rateSearchConnection = connect(ui->buttonRateSearch, &QPushButton::clicked, this, [this, publishers]() {
+            if (rateSearch->isRunning())
+            {
+                rateSearch->abort();
+                setRateSearchRunning(false);
+                ui->statusBar->showMessage(tr("Rate search aborted"));
+                return;
+            }
 
-        // QSignalSpy spyPublisherMessageSent(publisher, SIGNAL(messageSent(const QString&, const QList<QByteArray>&)));
-        // QSignalSpy spyPublisherFailure(publisher, SIGNAL(failure(const QString&)));
-        // QSignalSpy spyPublisherFinished(publisher, SIGNAL(finished()));
+            if (!isSendMode)
+            {
+                QMessageBox::critical(this, tr("Error"), tr("Please stop publishing before searching the max rate"));
+                return;
+            }
 
-        // Create publisher execution thread.
-        QThread* publisherThread = makeExecutionThread(*publisher);
-        connect(publisherThread, &QThread::finished, [context](){}); // Keeps the context alive until the thread finishes
-        
-        // QSignalSpy spyPublisherThreadFinished(publisherThread, SIGNAL(finished()));
+            QStringList messages;
+            samples::TopicSampler topics;
+            if (!readPublishMessage(&messages, &topics))
+            {
+                return;
+            }
 
-        // START TEST
-        context->start();
-        publisherThread->start();
+            samples::RateSearchConfig config;
+            config.minRate = qMax(1, ui->publishFrequency->value());
+            config.maxRate = ui->spinBoxSearchMaxRate->value();
+            config.p99LimitNs = ui->spinBoxSloP99->value() * 1000LL;
+            config.p999LimitNs = ui->spinBoxSloP999->value() * 1000LL;
+            config.lossLimit = ui->doubleSpinBoxSloLoss->value() / 100.0;
+            config.warmupMsec = ui->spinBoxSearchWarmup->value() * 1000;
+            config.measureMsec = ui->spinBoxSearchMeasure->value() * 1000;
+
+            logMessage(tr("Rate search from %1 to %2 msg/s, limits p99 %3, p99.9 %4, loss %5 %")
+                .arg(config.minRate, 0, 'f', 0).arg(config.maxRate, 0, 'f', 0)
+                .arg(formatDuration(config.p99LimitNs), formatDuration(config.p999LimitNs))
+                .arg(config.lossLimit * 100.0));
+            bool useHex = ui->checkBoxPublishHex->isChecked();
+            int seededSize = ui->checkBoxSeeded->isChecked() ? ui->spinBoxSeededSize->value() : 0;
+            QString path = payloadFile();
+            qint64 sliceSize = payloadSliceSize();
+            for (samples::pubsub::Publisher* publisher : publishers)
+            {
+                QMetaObject::invokeMethod(publisher, [publisher, useHex, seededSize, path, sliceSize]() {
+                    publisher->setUseHex(useHex);
+                    publisher->setSeededPayload(seededSize);
+                    publisher->setPayloadFile(path, sliceSize);
+                }, Qt::QueuedConnection);
+            }
+            setRateSearchRunning(true);
+            rateSearch->start(config, publishers, messages, topics, publisherStats);
+        });
 
-        // CHECK POSTCONDITIONS
-        // QCOMPARE(spyPublisherFailure.size(), 0);
-        // QVERIFY2(spyPublisherMessageSent.size() > 0, "Server didn't send any messages.");
-        // QCOMPARE(spyPublisherFinished.size(), 1);
-        // QCOMPARE(spyPublisherThreadFinished.size(), 1);
+        // Disconnect the ui->buttonSend and ui->buttonRateSearch when ui->buttonStop is clicked
+        connect(ui->buttonStop, &QPushButton::clicked, this, [this, publishMessageConnection, rateSearchConnection](){
+            disconnect(publishMessageConnection);
+            disconnect(rateSearchConnection);
+        });
     }
     catch (std::exception& ex)
     {
@@ -213,40 +411,103 @@ void MainWindow::publishInit(QString ipAddress, int port, bool useHex)
 
 
 /**
- * @brief Publishes a message to a given publisher.
- * @param publisher A pointer to the publisher object.
+ * @brief Publishes a message to the given publishers.
+ * @param publishers The publisher workers, each one runs its share of the rate.
  * @return bool True if the message was published successfully, false otherwise.
  * @note This function retrieves the topic and contents of the message from the UI view. 
  *       If either of them is invalid, an error message is displayed and the function returns. 
- *       Otherwise, the topic and contents are added to a QStringList and passed to the publisher's startAction() function. 
+ *       Otherwise, the topic and contents are added to a QStringList and queued with the settings into each publisher's thread, which calls startAction() there. 
  *       Finally, a status message is displayed on the UI view.
  */
-bool MainWindow::publishMessage(samples::pubsub::Publisher* publisher)
+bool MainWindow::publishMessage(const QList<samples::pubsub::Publisher*>& publishers)
+{
+    QStringList messages;
+    samples::TopicSampler topics;
+    if (!readPublishMessage(&messages, &topics))
+    {
+        return false;
+    }
+
+    // The settings are applied in each publisher's thread, a run still sending there reads them
+    bool useHex = ui->checkBoxPublishHex->isChecked();
+    int seededSize = ui->checkBoxSeeded->isChecked() ? ui->spinBoxSeededSize->value() : 0;
+    QString path = payloadFile();
+    qint64 sliceSize = payloadSliceSize();
+    bool streaming = ui->checkBoxStream->isChecked();
+    qint64 chunkSize = ui->spinBoxChunkSize->value() * 1024LL;
+    int chunkWindow = ui->spinBoxChunkWindow->value();
+    for (samples::pubsub::Publisher* publisher : publishers)
+    {
+        QMetaObject::invokeMethod(publisher, [publisher, topics, messages, useHex, seededSize, path, sliceSize, streaming, chunkSize, chunkWindow]() {
+            publisher->setTopics(topics);
+            publisher->setUseHex(useHex);
+            publisher->setSeededPayload(seededSize);
+            publisher->setPayloadFile(path, sliceSize);
+            publisher->setStreaming(streaming, chunkSize, chunkWindow);
+            publisher->startAction(messages);
+        }, Qt::QueuedConnection);
+    }
+
+    ui->statusBar->showMessage(tr("Sending message ..."));
+    return true;
+}
+
+
+/**
+ * @brief Reads and validates the topic set and the message of the publish section.
+ * @param messages Receives the topic and the message as passed to Publisher::startAction().
+ * @param topics Receives the parsed topic set with the selected distribution.
+ * @return bool False if the topic or the message is invalid, an error message has been shown then.
+ */
+bool MainWindow::readPublishMessage(QStringList* messages, samples::TopicSampler* topics)
 {
-    // Get the topic from the ui view
+    // Get the topic or topic set from the ui view
     QString topic = ui->lineEditPublishTopic->text();
-    if (!isValidString(topic))
+    QString error;
+    if (!topics->parse(topic, &error))
     {
-        QMessageBox::critical(this, tr("Error"), tr("Please enter a valid topic"));
-        ui->statusBar->showMessage(tr("Please enter a valid topic"));
+        QMessageBox::critical(this, tr("Error"), error);
+        ui->statusBar->showMessage(error);
         return false;
     }
 
+    for (int i = 0; i < topics->size(); ++i)
+    {
+        if (!isValidString(QString::fromLocal8Bit(topics->topic(i))))
+        {
+            QMessageBox::critical(this, tr("Error"), tr("Please enter a valid topic"));
+            ui->statusBar->showMessage(tr("Please enter a valid topic"));
+            return false;
+        }
+    }
+
+    static const samples::TopicSampler::Distribution distributions[] = {
+        samples::TopicSampler::DIST_UNIFORM, samples::TopicSampler::DIST_ZIPF, samples::TopicSampler::DIST_WEIGHTED
+    };
+    topics->setDistribution(distributions[qBound(0, ui->comboBoxTopicDistribution->currentIndex(), 2)],
+                            ui->doubleSpinBoxZipfExponent->value());
+
+    // A file payload replaces the message, it is mapped by the publishers when they start
     QString contents = ui->lineEditPublishMessage->toPlainText();
-    if (contents.isEmpty())
+    if (ui->checkBoxPayloadFile->isChecked())
+    {
+        if (!QFileInfo(ui->lineEditPayloadFile->text()).isFile())
+        {
+            QMessageBox::critical(this, tr("Error"), tr("Please select a file to publish"));
+            ui->statusBar->showMessage(tr("Please select a file to publish"));
+            return false;
+        }
+    }
+    else if (contents.isEmpty())
     {
         QMessageBox::critical(this, tr("Error"), tr("Please enter a valid message"));
         ui->statusBar->showMessage(tr("Please enter a valid message"));
         return false;
     }
 
-    QStringList messages;
-    messages.append(topic);
-    messages.append(contents);
-
-    publisher->startAction(messages);
-
-    ui->statusBar->showMessage(tr("Sending message ..."));
+    messages->clear();
+    messages->append(topic);
+    messages->append(contents);
     return true;
 }
 
@@ -296,6 +557,9 @@ void MainWindow::on_buttonClearAll_clicked()
 void MainWindow::on_buttonStop_clicked()
 {
     updateTimer->stop();
+    rateSearch->abort();
+    setRateSearchRunning(false);
+    ui->buttonRateSearch->setEnabled(false);
 
     ui->buttonSend->setEnabled(false);
     ui->buttonStop->setEnabled(false);
@@ -304,6 +568,12 @@ void MainWindow::on_buttonStop_clicked()
     ui->lineEditHost->setEnabled(true);
     ui->spinBoxPortPublish->setEnabled(true);
     ui->spinBoxPortSubscribe->setEnabled(true);
+    ui->spinBoxWorkers->setEnabled(true);
+    ui->comboBoxWorkerMode->setEnabled(true);
+    ui->checkBoxWorkerContext->setEnabled(true);
+    ui->lineEditEndpoints->setEnabled(true);
+    ui->buttonEndpointsBrowse->setEnabled(true);
+    ui->spinBoxSubscriberSockets->setEnabled(true);
     
     ui->buttonSend->setText(tr("Send"));
     ui->buttonSend->setIcon(QIcon(":/images/send.png"));
@@ -316,25 +586,57 @@ void MainWindow::on_buttonStop_clicked()
 Subscriber Context:
 The subscriber context refers to creating and handling the subscriber side of a publish-subscribe pattern. It is symmetrical to the publisher context with some details:
 ZMQContext: Just like the publisher, the subscriber needs a ZMQ context for its operation.
-Subscriber Creation: A subscriber is created within the same context, listening to the same endpoint that the publisher is using to publish the messages.
+Subscriber Creation: A subscriber is created within the same context, connecting to every endpoint of the endpoint list, or to the one the publisher is using to publish the messages.
 Execution Thread: Similar to the publisher, the subscriber's functionality runs in a separate thread.
 Test Start: The subscriber thread starts with a slight delay (500 ms) and is stopped after 6 seconds, similar to the publisher.
 Postconditions Check: After the test is finished, conditions are checked to verify the behavior of the subscriber (e.g., number of pings received, failures, etc.).
 */
-void MainWindow::subscribeInit(QString ipAddress, int port, bool useHex)
+void MainWindow::subscribeInit(const QStringList& endpoints, int sockets, bool useHex)
 {
     try
     {
-        QSharedPointer<ZMQContext> context(nzmqt::createDefaultContext());
-
-        // Create the connection string using the given IP address and port
-        QString connectionString = QString("tcp://%1:%2").arg(ipAddress).arg(port);
-
-        // Create subscriber with the connection string and the specified topic
-        samples::pubsub::Subscriber* subscriber = new samples::pubsub::Subscriber(*context, connectionString, useHex, this);
-        connect(subscriber, SIGNAL(messageReceived(const QString&, const QList<QByteArray>&)), SLOT(messageReceived(const QString&, const QList<QByteArray>&)));
+        // Socket connections are spread over the I/O threads, more sockets get more threads up to the core count
+        int socketCount = sockets <= 0 ? endpoints.size() : qMin(sockets, endpoints.size());
+        int ioThreads = qMax(NZMQT_DEFAULT_IOTHREADS, qMin(socketCount, QThread::idealThreadCount()));
+        QSharedPointer<ZMQContext> context(nzmqt::createDefaultContext(nullptr, ioThreads));
+
+        // Create subscriber with the endpoints of all publishers
+        samples::pubsub::Subscriber* subscriber = new samples::pubsub::Subscriber(*context, endpoints, sockets, useHex, this);
+        topicStats.reset(new samples::TopicStats);
+        topicStatsModel->clear();
+        subscriber->setTopicStats(topicStats);
+        // The view never holds more than Max Storage Items, a larger ring would only delay the drops
+        displayRing.reset(new samples::DisplayRing(ui->spinBoxMaxItem->value(), static_cast<samples::DisplayRing::Policy>(ui->comboBoxDisplayPolicy->currentIndex())));
+        displayMessages.clear();
+        subscriber->setDisplayRing(displayRing);
         connect(subscriber, SIGNAL(finished()), SLOT(messageFinished()));
         connect(subscriber, SIGNAL(signal_log(int, const QString&)), SLOT(handleLogMessage(int, const QString&)));
+        connect(subscriber, &samples::pubsub::Subscriber::latencyReported, this, &MainWindow::latencyReported);
+        connect(subscriber, &samples::pubsub::Subscriber::lossReported, this, &MainWindow::lossReported);
+        connect(subscriber, &samples::pubsub::Subscriber::rateReported, this, &MainWindow::rateReported);
+        connect(subscriber, &samples::pubsub::Subscriber::streamReported, this, &MainWindow::streamReported);
+        connect(subscriber, &samples::pubsub::Subscriber::integrityReported, this, &MainWindow::integrityReported);
+        connect(subscriber, &samples::pubsub::Subscriber::endpointsReported, this, &MainWindow::endpointsReported);
+        subscriber->setStreamDirectory(ui->lineEditStreamDir->text());
+        connect(ui->lineEditStreamDir, &QLineEdit::textChanged, subscriber, &samples::pubsub::Subscriber::setStreamDirectory);
+        connect(rateSearch, &samples::RateSearchController::measurementStarted, subscriber, &samples::pubsub::Subscriber::startMeasurement);
+        connect(rateSearch, &samples::RateSearchController::measurementRequested, subscriber, &samples::pubsub::Subscriber::finishMeasurement);
+        connect(subscriber, &samples::pubsub::Subscriber::measurementFinished, rateSearch, &samples::RateSearchController::measurementFinished);
+        subscriber->setBackfill(ui->checkBoxBackfill->isChecked());
+        connect(ui->checkBoxBackfill, &QCheckBox::toggled, subscriber, &samples::pubsub::Subscriber::setBackfill);
+        connect(subscriber, &samples::pubsub::Subscriber::captureReported, this, &MainWindow::captureReported);
+        subscriber->setCapturePrefix(ui->lineEditCapturePrefix->text());
+        connect(ui->lineEditCapturePrefix, &QLineEdit::textChanged, subscriber, &samples::pubsub::Subscriber::setCapturePrefix);
+        subscriber->setCaptureQueueDepth(ui->spinBoxCaptureDepth->value());
+        connect(ui->spinBoxCaptureDepth, QOverload<int>::of(&QSpinBox::valueChanged), subscriber, &samples::pubsub::Subscriber::setCaptureQueueDepth);
+        subscriber->setCaptureDirectIo(ui->checkBoxCaptureDirect->isChecked());
+        connect(ui->checkBoxCaptureDirect, &QCheckBox::toggled, subscriber, &samples::pubsub::Subscriber::setCaptureDirectIo);
+        subscriber->setCaptureBlocking(ui->checkBoxCaptureBlock->isChecked());
+        connect(ui->checkBoxCaptureBlock, &QCheckBox::toggled, subscriber, &samples::pubsub::Subscriber::setCaptureBlocking);
+        subscriber->setCaptureSearchIndex(ui->checkBoxCaptureSearchIndex->isChecked());
+        connect(ui->checkBoxCaptureSearchIndex, &QCheckBox::toggled, subscriber, &samples::pubsub::Subscriber::setCaptureSearchIndex);
+        subscriber->setRecording(ui->checkBoxRecord->isChecked());
+        connect(ui->checkBoxRecord, &QCheckBox::toggled, subscriber, &samples::pubsub::Subscriber::setRecording);
         
         // Connect the radio buttons to the subscriber's setUseHex and setUseDec functions
         connect(ui->hexDisplay, &QRadioButton::clicked, subscriber, &samples::pubsub::Subscriber::setUseHex);
@@ -561,6 +863,15 @@ void MainWindow::messageFinished()
     ui->lineEditHost->setEnabled(true);
     ui->spinBoxPortPublish->setEnabled(true);
     ui->spinBoxPortSubscribe->setEnabled(true);
+    ui->spinBoxWorkers->setEnabled(true);
+    ui->comboBoxWorkerMode->setEnabled(true);
+    ui->checkBoxWorkerContext->setEnabled(true);
+    ui->lineEditEndpoints->setEnabled(true);
+    ui->buttonEndpointsBrowse->setEnabled(true);
+    ui->spinBoxSubscriberSockets->setEnabled(true);
+    ui->buttonRateSearch->setEnabled(false);
+    // The timer is stopped already, the last messages and the final count are taken here
+    updateTextEdit();
     ui->statusBar->showMessage(tr("Message Finished"));
 }
 
@@ -573,23 +884,8 @@ void MainWindow::messageFinished()
  */
 void MainWindow::messageSent(const QString& timeStamp, const QList<QByteArray>& messageList)
 {
-    ui->lcdNumberPublish->display(ui->lcdNumberPublish->value() + 1);
-
     QStringList localBuffer;
-    localBuffer.append(timeStamp + QString(" Topic: ") + QString::fromUtf8(messageList.at(0)));
-    localBuffer.append("Message: ");
-
-    bool isFirst = true;
-    foreach(const QByteArray& message, messageList)
-    {
-        if (isFirst)
-        {
-            isFirst = false;
-            continue;
-        }
-        localBuffer.append(QString::fromUtf8(message));
-    }
-    localBuffer.append("\n");
+    appendMessage(&localBuffer, timeStamp, messageList);
 
     QMutexLocker locker(&bufferedMessagesMutex);
     bufferedMessages.append(localBuffer);
@@ -597,193 +893,1137 @@ void MainWindow::messageSent(const QString& timeStamp, const QList<QByteArray>&
 
 
 /**
- * @brief This function is called when a message is received. It appends the timestamp and message to the subscribe text view.
- * @param timeStamp The timestamp of the received message.
- * @param messageList The list of messages received.
+ * @brief Formats a message for the text view.
+ * @param lines Receives the lines of the message.
+ * @param timeStamp The timestamp of the message.
+ * @param messageList The topic and the frames of the message.
  * @return None
  */
-void MainWindow::messageReceived(const QString& timeStamp, const QList<QByteArray>& messageList)
+void MainWindow::appendMessage(QStringList* lines, const QString& timeStamp, const QList<QByteArray>& messageList)
 {
-    ui->lcdNumberSubscribe->display(ui->lcdNumberSubscribe->value() + 1);
-    
-    ui->textView->document()->setMaximumBlockCount(ui->spinBoxMaxItem->value());
-
-    QStringList localBuffer;
-    localBuffer.append(timeStamp + QString(" Topic: ") + QString::fromUtf8(messageList.at(0)));
-    localBuffer.append("Message: ");
+    lines->append(timeStamp + QString(" Topic: ") + QString::fromUtf8(messageList.at(0)));
+    lines->append("Message: ");
 
-    bool isFirst = true;
     // Filter out the topic from the message list
-    foreach(const QByteArray& message, messageList)
+    for (int i = 1; i < messageList.size(); ++i)
     {
-        if (isFirst)
-        {
-            isFirst = false;
-            continue;
-        }
-        localBuffer.append(QString::fromUtf8(message));
+        lines->append(QString::fromUtf8(messageList.at(i)));
     }
-    localBuffer.append("\n");
+    lines->append("\n");
+}
 
-    QMutexLocker locker(&bufferedMessagesMutex);
-    bufferedMessages.append(localBuffer);
+
+/**
+ * @brief Appends the messages of the live view once their payloads are decoded.
+ * @param messages The messages as taken from the display ring, in order.
+ * @param undecoded The number of messages passed through undecoded because the decoder was behind.
+ * @return None
+ */
+void MainWindow::messagesDecoded(const QVector<samples::DisplayMessage>& messages, int undecoded)
+{
+    QStringList lines;
+    for (const samples::DisplayMessage& message : messages)
+    {
+        appendMessage(&lines, message.timeStamp, message.frames);
+    }
+    if (!lines.isEmpty())
+    {
+        ui->textView->document()->setMaximumBlockCount(ui->spinBoxMaxItem->value());
+        emit updateTextEditSignal(lines.join("\n"));
+    }
+
+    if (undecoded > 0)
+    {
+        undecodedMessages += undecoded;
+        ui->labelDecoderValue->setText(tr("%1 shown undecoded, the decoder is behind").arg(undecodedMessages));
+    }
 }
 
 
 /**
- * @brief Updates the text edit with the buffered messages.
+ * @brief Shows the decoded payload of the selected capture message.
  * @param None
  * @return None
  */
-void MainWindow::updateTextEdit()
+void MainWindow::showDecodedRow()
 {
-    QMutexLocker locker(&bufferedMessagesMutex);
-    // Use concurrent to update the text edit for better performance
-    QtConcurrent::run([this]() {
-        // This is running in another thread        
-        if (!bufferedMessages.isEmpty())
-        {
-            emit updateTextEditSignal(bufferedMessages.join("\n"));
-            bufferedMessages.clear();
-        }
-    });
+    // Asks for the decode if needed, rowDecoded() calls again when it is done
+    QModelIndex current = ui->tableViewCapture->currentIndex();
+    QString text = current.isValid() ? captureModel->decodedText(current.row()) : QString();
+    if (text.isEmpty() && current.isValid() && decodeQueue->decoder())
+    {
+        text = tr("Decoding...");
+    }
+    ui->textEditViewDecoded->setPlainText(text);
 }
 
 
 /**
- * @brief Resets the values of the host and ports to their default values.
+ * @brief Creates the decoder chosen in the Decode As box and hands it to the decode queue.
  * @param None
  * @return None
  */
-void MainWindow::on_buttonDefault_clicked()
+void MainWindow::applyDecoder()
 {
-    ui->lineEditHost->setText("127.0.0.1");
-    ui->spinBoxPortSubscribe->setValue(9446);
-    ui->spinBoxPortPublish->setValue(9445);
-    ui->statusBar->showMessage(tr("Parameter set to default value"));
+    QSharedPointer<const samples::PayloadDecoder> decoder;
+    QString status = tr("n/a");
+    switch (ui->comboBoxDecoder->currentIndex())
+    {
+    case 1:
+        decoder.reset(new samples::JsonDecoder);
+        break;
+    case 2:
+        decoder.reset(new samples::MessagePackDecoder);
+        break;
+    case 3:
+    {
+        QByteArray type = ui->lineEditProtobufType->text().trimmed().toUtf8();
+        if (!type.isEmpty() && (!protobufDescriptors || !protobufDescriptors->message(type)))
+        {
+            status = protobufDescriptors ? tr("%1 is not in the descriptors, raw fields shown").arg(QString::fromUtf8(type))
+                : tr("No descriptors loaded, raw fields shown");
+        }
+        else if (protobufDescriptors)
+        {
+            status = tr("%1 message types loaded").arg(protobufDescriptors->messageCount());
+        }
+        decoder.reset(new samples::ProtobufDecoder(protobufDescriptors, type));
+        break;
+    }
+    default:
+        break;
+    }
+
+    undecodedMessages = 0;
+    ui->labelDecoderValue->setText(status);
+    decodeQueue->setDecoder(decoder);
 }
 
 
-void MainWindow::on_buttonQuit_clicked()
+/**
+ * @brief Shows the counters of the display ring with the subscribe counter.
+ * @param counters The counters as returned by DisplayRing::take().
+ * @return None
+ */
+void MainWindow::showDisplayCounters(const samples::DisplayCounters& counters)
 {
-    this->close();
+    // Counted by the ring, so the number stays exact however many messages the view drops
+    ui->lcdNumberSubscribe->display(static_cast<double>(counters.counted));
+    ui->labelDisplayValue->setText(counters.notDisplayed() == 0 ? tr("All shown")
+        : tr("%1 not shown (%2 %)").arg(counters.notDisplayed()).arg(100.0 * counters.notDisplayed() / counters.counted, 0, 'f', 1));
+    ui->labelDisplayValue->setToolTip(tr("Received: %1\nShown: %2\nDropped, view full: %3\nSampled out: %4\nCapacity: %5 messages\nSample stride: 1 of %6")
+        .arg(counters.counted).arg(counters.displayed).arg(counters.dropped).arg(counters.sampledOut).arg(counters.capacity).arg(counters.stride));
 }
 
 
 /**
- * @brief This function is called when the user clicks on the "Start" button. It retrieves the IP address, port, and topic from the UI, validates them, and then calls the subscribe function to start the subscription.
- * @param None
+ * @brief Shows the overall measured and corrected latency percentiles next to the subscribe counter, per topic values go to the tooltip.
+ * @param measured The latency from the actual send time, the first report covers all topics.
+ * @param corrected The latency from the intended send time, the first report covers all topics.
  * @return None
  */
-void MainWindow::on_buttonStart_clicked()
+void MainWindow::latencyReported(const samples::LatencyReports& measured, const samples::LatencyReports& corrected)
 {
-    int updateFrequency = ui->spinBoxFrequency->value();
-    if (updateFrequency < 1 || updateFrequency > 200)
+    QString header = QString("<tr><th>%1</th><th>%2</th><th>%3</th><th>%4</th><th>p50</th><th>p90</th><th>p99</th><th>p99.9</th><th>p99.99</th><th>max</th></tr>")
+        .arg(tr("Topic"), tr("Latency"), tr("Window"), tr("Count"));
+    QString rowFormat("<tr><td>%1</td><td>%2</td><td>%3</td><td>%4</td><td>%5</td><td>%6</td><td>%7</td><td>%8</td><td>%9</td>");
+    auto row = [&](const QString& topic, const QString& kind, const QString& window, const samples::LatencySummary& s) {
+        return rowFormat.arg(topic, kind, window).arg(s.count)
+            .arg(formatDuration(s.p50), formatDuration(s.p90), formatDuration(s.p99), formatDuration(s.p999), formatDuration(s.p9999))
+            + QString("<td>%1</td></tr>").arg(formatDuration(s.max));
+    };
+
+    // Measured and corrected sliding window values of all topics side by side
+    ui->labelLatencyValue->setText(QString("<table>%1%2</table>").arg(header,
+        row(tr("All topics"), tr("Measured"), tr("10 s"), measured.first().window)
+        + row(QString(), tr("Corrected"), tr("10 s"), corrected.first().window)));
+
+    // Sliding window and cumulative values of every topic as a table in the tooltip
+    QString rows;
+    for (int i = 0; i < measured.size(); ++i)
     {
-        QMessageBox::critical(this, tr("Error"), tr("Please enter a valid update frequency"));
-        return;
+        QString topic = i == 0 ? tr("All topics") : QString::fromUtf8(measured.at(i).topic).toHtmlEscaped();
+        rows += row(topic, tr("Measured"), tr("10 s"), measured.at(i).window);
+        rows += row(QString(), tr("Measured"), tr("Total"), measured.at(i).total);
+        if (i < corrected.size())
+        {
+            rows += row(QString(), tr("Corrected"), tr("10 s"), corrected.at(i).window);
+            rows += row(QString(), tr("Corrected"), tr("Total"), corrected.at(i).total);
+        }
     }
+    ui->labelLatencyValue->setToolTip(QString("<table>%1%2</table>").arg(header, rows));
+}
 
-    // Starts the timer to update every 100ms
-    updateTimer->start((int)(1000 / updateFrequency));
-
-    QString ipAddress = ui->lineEditHost->text();
-    // Bind to all available interfaces
-    QString localAddress = "*";
-    int subPort = ui->spinBoxPortSubscribe->value();
-    int pubPort = ui->spinBoxPortPublish->value();
-
-    bool useHex = false;
 
-    if (!isValidIPv4(ipAddress))
+/**
+ * @brief Shows the loss counters of all stamped streams and logs new gaps.
+ * @param report The loss report of the subscriber.
+ * @return None
+ */
+void MainWindow::lossReported(const samples::LossReport& report)
+{
+    samples::StreamLoss all;
+    int lateJoins = 0;
+    QString rows;
+    for (const samples::StreamLoss& stream : report.streams)
     {
-        QMessageBox::critical(this, tr("Error"), tr("Please enter a valid IPv4 address"));
-        ui->statusBar->showMessage(tr("Please enter a valid IPv4 address"));
-        return;
+        all.received += stream.received;
+        all.missing += stream.missing;
+        all.gaps += stream.gaps;
+        all.duplicates += stream.duplicates;
+        all.reordered += stream.reordered;
+        lateJoins += stream.lateJoin() ? 1 : 0;
+
+        rows += QString("<tr><td>%1</td><td>%2</td><td>%3</td><td>%4</td><td>%5</td><td>%6</td><td>%7</td><td>%8 %</td></tr>")
+            .arg(QString::number(stream.publisherId, 16), QString::fromUtf8(stream.topic).toHtmlEscaped())
+            .arg(stream.firstSequence).arg(stream.received).arg(stream.missing).arg(stream.gaps)
+            .arg(stream.duplicates + stream.reordered).arg(stream.lossRate() * 100.0, 0, 'f', 3);
     }
 
-    ui->buttonSend->setEnabled(true);
-    ui->buttonStart->setEnabled(false);
-    ui->buttonStop->setEnabled(true);
-    ui->buttonDefault->setEnabled(false);
-    ui->lcdNumberSubscribe->display(0);
-    ui->lcdNumberPublish->display(0);
+    ui->labelLossValue->setText(tr("%1 % lost | %2 gaps | %3 duplicates | %4 reordered | %5 late joins")
+        .arg(all.lossRate() * 100.0, 0, 'f', 3).arg(all.gaps).arg(all.duplicates).arg(all.reordered).arg(lateJoins));
 
-    ui->lineEditHost->setEnabled(false);
-    ui->spinBoxPortPublish->setEnabled(false);
-    ui->spinBoxPortSubscribe->setEnabled(false);
+    // Loss rate of the latest sampling intervals, newest first
+    QString series;
+    for (int i = report.series.size() - 1, n = 0; i >= 0 && n < 10; --i, ++n)
+    {
+        const samples::LossSample& sample = report.series.at(i);
+        series += QString("<tr><td>-%1 s</td><td>%2</td><td>%3</td><td>%4 %</td></tr>")
+            .arg(n).arg(sample.expected).arg(sample.missing).arg(sample.lossRate() * 100.0, 0, 'f', 3);
+    }
 
-    ui->statusBar->showMessage(tr("Started ..."));
+    ui->labelLossValue->setToolTip(QString("<table><tr><th>%1</th><th>%2</th><th>%3</th><th>%4</th><th>%5</th><th>%6</th><th>%7</th><th>%8</th></tr>%9</table>")
+        .arg(tr("Publisher"), tr("Topic"), tr("First"), tr("Received"), tr("Missing"), tr("Gaps"), tr("Out of order"), tr("Loss"), rows)
+        + QString("<table><tr><th>%1</th><th>%2</th><th>%3</th><th>%4</th></tr>%5</table>")
+        .arg(tr("Interval"), tr("Expected"), tr("Missing"), tr("Loss"), series));
 
-    subscribeInit(ipAddress, subPort, useHex);
-    publishInit(localAddress, pubPort, useHex);
+    for (const samples::GapEvent& gap : report.gaps)
+    {
+        logMessage(QString("Gap: Publisher %1, Topic %2, Sequence %3 - %4 (%5 missing)")
+            .arg(QString::number(gap.publisherId, 16), QString::fromUtf8(gap.topic))
+            .arg(gap.firstMissing).arg(gap.lastMissing).arg(gap.lastMissing - gap.firstMissing + 1));
+    }
 }
 
 
 /**
- * @brief Clears all input fields in the publish section of the UI.
- * @param None
+ * @brief Shows the corrected latency and loss by target rate, the highest rate seen goes to the label.
+ * @param report The rate bands of the subscriber, ordered by rate.
  * @return None
  */
-void MainWindow::on_buttonPublishClearAll_clicked()
+void MainWindow::rateReported(const samples::RateReport& report)
 {
-    ui->textView->clear();
-    ui->lineEditPublishTopic->clear();
-    ui->lineEditPublishMessage->clear();
-    ui->statusBar->showMessage(tr("Information cleared"));
+    if (report.isEmpty())
+    {
+        return;
+    }
+
+    QString rows;
+    for (const samples::RateBand& band : report)
+    {
+        rows += QString("<tr><td>%1 - %2</td><td>%3</td><td>%4</td><td>%5</td><td>%6</td><td>%7</td><td>%8 %</td></tr>")
+            .arg(band.lowRate, 0, 'f', 0).arg(band.highRate, 0, 'f', 0).arg(band.received)
+            .arg(formatDuration(band.latency.p50), formatDuration(band.latency.p99), formatDuration(band.latency.p999), formatDuration(band.latency.max))
+            .arg(band.lossRate() * 100.0, 0, 'f', 3);
+    }
+
+    const samples::RateBand& top = report.last();
+    ui->labelRateValue->setText(tr("up to %1 msg/s | p99 %2 | %3 % lost")
+        .arg(top.highRate, 0, 'f', 0).arg(formatDuration(top.latency.p99)).arg(top.lossRate() * 100.0, 0, 'f', 3));
+    ui->labelRateValue->setToolTip(QString("<table><tr><th>%1</th><th>%2</th><th>p50</th><th>p99</th><th>p99.9</th><th>max</th><th>%3</th></tr>%4</table>")
+        .arg(tr("Target rate (msg/s)"), tr("Received"), tr("Loss"), rows));
 }
 
 
 /**
- * @brief Slot function that is called when the state of the "Loop" checkbox is changed.
- *        Enables or disables the "Frequency" spin box based on the state of the checkbox.
- * @param arg1 The new state of the checkbox (Qt::Checked or Qt::Unchecked).
- * @return void
+ * @brief Counts the received streams and logs each one, the streams of the last report go to the tooltip.
+ * @param report The streams that completed or were given up since the previous report.
+ * @return None
  */
-void MainWindow::on_checkBoxLoop_stateChanged(int arg1)
+void MainWindow::streamReported(const samples::StreamReport& report)
 {
-    if (arg1 == Qt::Checked)
+    if (report.isEmpty())
     {
-        ui->publishFrequency->setEnabled(true);
+        return;
     }
-    else
+
+    QString rows;
+    for (const samples::StreamResult& stream : report)
     {
-        ui->publishFrequency->setEnabled(false);
+        QString line = tr("Stream %1/%2: %3 bytes, %4 of %5 chunks, %6 MB/s, latency %7")
+            .arg(stream.publisherId, 8, 16, QChar('0')).arg(stream.streamId).arg(stream.totalSize)
+            .arg(stream.chunkCount - stream.missingChunks).arg(stream.chunkCount)
+            .arg(stream.throughput() / 1e6, 0, 'f', 1).arg(formatDuration(stream.latencyNs));
+        if (!stream.fileName.isEmpty())
+        {
+            line += tr(", saved to %1").arg(stream.fileName);
+        }
+        logMessage(line);
+
+        rows += QString("<tr><td>%1</td><td>%2</td><td>%3 / %4</td><td>%5</td><td>%6</td></tr>")
+            .arg(stream.streamId).arg(stream.totalSize).arg(stream.chunkCount - stream.missingChunks).arg(stream.chunkCount)
+            .arg(stream.throughput() / 1e6, 0, 'f', 1).arg(formatDuration(stream.latencyNs));
+        if (stream.isComplete())
+        {
+            ++streamsComplete;
+        }
+        else
+        {
+            ++streamsIncomplete;
+        }
     }
+
+    const samples::StreamResult& last = report.last();
+    ui->labelStreamValue->setText(tr("%1 complete, %2 incomplete | %3 MB/s | latency %4")
+        .arg(streamsComplete).arg(streamsIncomplete).arg(last.throughput() / 1e6, 0, 'f', 1).arg(formatDuration(last.latencyNs)));
+    ui->labelStreamValue->setToolTip(QString("<table><tr><th>%1</th><th>%2</th><th>%3</th><th>MB/s</th><th>%4</th></tr>%5</table>")
+        .arg(tr("Stream"), tr("Bytes"), tr("Chunks"), tr("Latency"), rows));
 }
 
 
 /**
- * @brief Displays the about dialog in the center of the main window.
- * @param None
+ * @brief Shows the payload verification counters and logs the sampled mismatches.
+ * @param report The counters of the subscriber and the mismatches sampled since its previous report.
  * @return None
  */
-void MainWindow::on_actionAbout_triggered()
+void MainWindow::integrityReported(const samples::IntegrityReport& report)
 {
-    aboutdlg.show();
-    // Display in front of the main window
-    int x = this->x() + (this->width() - aboutdlg.width()) / 2;
-    int y = this->y() + (this->height() - aboutdlg.height()) / 2;
-    aboutdlg.move(x, y);
+    ui->labelIntegrityValue->setText(tr("%1 verified | %2 corrupted | %3 malformed")
+        .arg(report.verified).arg(report.corrupted).arg(report.malformed));
+
+    for (const samples::PayloadMismatch& mismatch : report.samples)
+    {
+        QString where = mismatch.receivedSize != mismatch.expectedSize
+            ? (mismatch.receivedSize < 0 ? tr("payload frame missing or split") : tr("%1 of %2 bytes").arg(mismatch.receivedSize).arg(mismatch.expectedSize))
+            : tr("first bad byte at offset %1 of %2").arg(mismatch.offset).arg(mismatch.expectedSize);
+        logMessage(QString("Payload mismatch: Publisher %1, Topic %2, Sequence %3, %4")
+            .arg(QString::number(mismatch.publisherId, 16), QString::fromUtf8(mismatch.topic))
+            .arg(mismatch.sequence).arg(where));
+    }
 }
 
 
-void MainWindow::on_actionQuit_triggered()
+/**
+ * @brief Shows the progress of the recording and logs its first write error.
+ * @param status The counters of the capture writer.
+ * @return None
+ */
+void MainWindow::captureReported(const samples::CaptureStatus& status)
 {
-    this->close();
+    QString text = tr("%1 messages | %2 MB | %3 MB/s | %4/%5 in flight | %6 dropped | %7 stalls")
+                       .arg(status.records).arg(status.bytes / 1e6, 0, 'f', 1).arg(status.throughput / 1e6, 0, 'f', 1)
+                       .arg(status.peakInFlight).arg(status.queueDepth).arg(status.dropped).arg(status.stalls);
+    ui->labelCaptureValue->setText(status.error.isEmpty() ? text : tr("%1 | failed").arg(text));
+
+    QString sync = status.lastSyncNs < 0 ? tr("n/a") : tr("%1 ms, max %2 ms").arg(status.lastSyncNs / 1e6, 0, 'f', 1).arg(status.maxSyncNs / 1e6, 0, 'f', 1);
+    QString searchIndex = status.lastSearchIndexNs < 0 ? tr("n/a") : formatDuration(status.lastSearchIndexNs);
+    if (!status.searchIndexError.isEmpty())
+    {
+        searchIndex = tr("%1, not written: %2").arg(searchIndex, status.searchIndexError);
+    }
+    QString details = tr("%1\nWriter: %2\nSegment sync: %3\nSearch index: %4\nStalled: %5 ms")
+                          .arg(status.path, status.io, sync, searchIndex).arg(status.stalledNs / 1e6, 0, 'f', 1);
+    ui->labelCaptureValue->setToolTip(status.error.isEmpty() ? details : status.error);
+
+    if (!status.error.isEmpty() && status.error != captureError)
+    {
+        captureError = status.error;
+        logMessage(QString("Recording to %1 failed: %2").arg(status.path, status.error));
+    }
 }
 
 
 /**
- * @brief Overrides the changeEvent function to handle language change events.
- * @param e A pointer to the QEvent object.
- * @return void
- * @note This function is called whenever a language change event occurs. It retranslated the UI to the new language.
+ * @brief Shows how many publishers are connected, the traffic of every endpoint goes to the tooltip.
+ * @param report The connection states of the endpoints and the counters of the subscriber sockets.
+ * @return None
  */
-void MainWindow::changeEvent(QEvent *e)
+void MainWindow::endpointsReported(const samples::EndpointReport& report)
 {
-    QMainWindow::changeEvent(e);
-    switch (e->type())
+    static const char* const states[] = { "connecting", "connected", "retrying", "disconnected" };
+
+    quint64 disconnects = 0;
+    quint64 retries = 0;
+    for (int i = 0; i < report.endpoints.size(); ++i)
+    {
+        const samples::EndpointState& endpoint = report.endpoints.at(i);
+        disconnects += endpoint.disconnects;
+        retries += endpoint.retries;
+        if (i < endpointDisconnects.size() && endpoint.disconnects > endpointDisconnects.at(i))
+        {
+            logMessage(QString("Endpoint %1 disconnected").arg(endpoint.endpoint));
+        }
+    }
+    endpointDisconnects.resize(report.endpoints.size());
+    for (int i = 0; i < report.endpoints.size(); ++i)
+    {
+        endpointDisconnects[i] = report.endpoints.at(i).disconnects;
+    }
+
+    double messageRate = 0.0;
+    double byteRate = 0.0;
+    for (const samples::SocketTraffic& traffic : report.sockets)
+    {
+        messageRate += traffic.messageRate;
+        byteRate += traffic.byteRate;
+    }
+    ui->labelEndpointValue->setText(tr("%1/%2 connected | %3 disconnects | %4 retries | %5 msg/s | %6 MB/s")
+        .arg(report.connected()).arg(report.endpoints.size()).arg(disconnects).arg(retries)
+        .arg(messageRate, 0, 'f', 0).arg(byteRate / 1e6, 0, 'f', 1));
+
+    // Endpoints that are not connected first, they are what a fan-in test is looking for
+    QVector<int> order;
+    for (int i = 0; i < report.endpoints.size(); ++i)
+    {
+        order.append(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&report](int a, int b) {
+        return (report.endpoints.at(a).state != samples::EndpointState::CONNECTED) > (report.endpoints.at(b).state != samples::EndpointState::CONNECTED);
+    });
+
+    QString rows;
+    for (int i = 0; i < order.size() && i < MaxEndpointRows; ++i)
+    {
+        const samples::EndpointState& endpoint = report.endpoints.at(order.at(i));
+        const samples::SocketTraffic& traffic = report.sockets.at(endpoint.socket);
+        QString socket = traffic.endpoints > 1 ? tr("%1 (%2 endpoints)").arg(endpoint.socket).arg(traffic.endpoints) : QString::number(endpoint.socket);
+        rows += QString("<tr><td>%1</td><td>%2</td><td>%3</td><td>%4</td><td>%5</td><td>%6</td><td>%7</td><td>%8</td><td>%9</td>")
+            .arg(endpoint.endpoint.toHtmlEscaped(), socket, tr(states[endpoint.state]))
+            .arg(endpoint.connects).arg(endpoint.disconnects).arg(endpoint.retries)
+            .arg(traffic.messages).arg(traffic.messageRate, 0, 'f', 0).arg(traffic.byteRate / 1e6, 0, 'f', 2)
+            + QString("<td>%1</td><td>%2</td><td>%3 %</td><td>%4</td></tr>")
+            .arg(traffic.latency.count == 0 ? tr("n/a") : formatDuration(traffic.latency.p50))
+            .arg(traffic.latency.count == 0 ? tr("n/a") : formatDuration(traffic.latency.p99))
+            .arg(traffic.lossRate() * 100.0, 0, 'f', 3)
+            .arg(traffic.idleNs < 0 ? tr("never") : formatDuration(traffic.idleNs));
+    }
+    QString more = order.size() > MaxEndpointRows ? tr("%1 more endpoints are connected").arg(order.size() - MaxEndpointRows) : QString();
+
+    ui->labelEndpointValue->setToolTip(QString("<table><tr><th>%1</th><th>%2</th><th>%3</th><th>%4</th><th>%5</th><th>%6</th><th>%7</th><th>msg/s</th><th>MB/s</th><th>p50</th><th>p99</th><th>%8</th><th>%9</th></tr>")
+        .arg(tr("Endpoint"), tr("Socket"), tr("State"), tr("Connects"), tr("Disconnects"), tr("Retries"), tr("Messages"), tr("Loss"), tr("Idle"))
+        + rows + QString("</table>%1").arg(more));
+}
+
+
+/**
+ * @brief Loads the subscribe endpoints from a file into the endpoints field.
+ * @param None
+ * @return None
+ */
+void MainWindow::on_buttonEndpointsBrowse_clicked()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("Load Endpoints"), QString(), tr("Endpoint Lists (*.txt *.lst);;All Files (*)"));
+    if (path.isEmpty())
+    {
+        return;
+    }
+
+    QStringList endpoints;
+    QString error;
+    if (!samples::EndpointList::load(path, &endpoints, &error))
+    {
+        QMessageBox::critical(this, tr("Error"), error);
+        return;
+    }
+    ui->lineEditEndpoints->setText(endpoints.join(", "));
+    ui->statusBar->showMessage(tr("%1 endpoints loaded").arg(endpoints.size()));
+}
+
+
+/**
+ * @brief Switches the payload decoder of the message views.
+ * @param index The format, in the order of the Decode As box.
+ * @return None
+ */
+void MainWindow::on_comboBoxDecoder_currentIndexChanged(int index)
+{
+    ui->lineEditProtobufType->setEnabled(index == 3);
+    ui->buttonDescriptorsBrowse->setEnabled(index == 3);
+    applyDecoder();
+}
+
+
+/**
+ * @brief Decodes protobuf payloads as the message type typed in.
+ * @param None
+ * @return None
+ */
+void MainWindow::on_lineEditProtobufType_editingFinished()
+{
+    applyDecoder();
+}
+
+
+/**
+ * @brief Loads the protobuf message types from a descriptor set.
+ * @param None
+ * @return None
+ */
+void MainWindow::on_buttonDescriptorsBrowse_clicked()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("Load Descriptors"), QString(), tr("Descriptor Sets (*.desc *.pb *.protoset);;All Files (*)"));
+    if (path.isEmpty())
+    {
+        return;
+    }
+
+    QSharedPointer<samples::ProtobufDescriptors> descriptors(new samples::ProtobufDescriptors);
+    QString error;
+    if (!descriptors->load(path, &error))
+    {
+        QMessageBox::critical(this, tr("Error"), error);
+        return;
+    }
+    protobufDescriptors = descriptors;
+    applyDecoder();
+    ui->statusBar->showMessage(tr("%1 message types loaded from %2").arg(descriptors->messageCount()).arg(path));
+}
+
+
+/**
+ * @brief Fills in the subscribe endpoints, e.g. from the command line.
+ * @param endpoints The publishers to connect to, see EndpointList.hpp.
+ * @param sockets The number of SUB sockets, 0 for one socket per endpoint.
+ * @return None
+ */
+void MainWindow::setSubscribeEndpoints(const QStringList& endpoints, int sockets)
+{
+    ui->lineEditEndpoints->setText(endpoints.join(", "));
+    ui->spinBoxSubscriberSockets->setValue(sockets);
+}
+
+
+/**
+ * @brief Connects as if the "Connect" button was clicked.
+ * @param None
+ * @return None
+ */
+void MainWindow::connectAll()
+{
+    if (ui->buttonStart->isEnabled())
+    {
+        on_buttonStart_clicked();
+    }
+}
+
+
+/**
+ * @brief Logs the result of one search step.
+ * @param measurement The latency and loss measured at the step's rate.
+ * @param passed True if the step met the limits.
+ * @return None
+ */
+void MainWindow::rateSearchStepFinished(const samples::StepMeasurement& measurement, bool passed)
+{
+    QString interval;
+    double low = 0.0;
+    double high = 0.0;
+    if (measurement.p99Interval(&low, &high))
+    {
+        interval = tr(" (95 % CI %1 - %2)").arg(formatDuration(static_cast<qint64>(low)), formatDuration(static_cast<qint64>(high)));
+    }
+
+    logMessage(tr("Rate search: %1 msg/s %2, %3 msg/s sent, %4 received, p50 %5, p99 %6%7, p99.9 %8, max %9, %10 % lost")
+        .arg(measurement.targetRate).arg(passed ? tr("passed") : tr("failed"))
+        .arg(measurement.sendRate, 0, 'f', 0).arg(measurement.received)
+        .arg(formatDuration(measurement.p50), formatDuration(measurement.p99), interval,
+             formatDuration(measurement.p999), formatDuration(measurement.max))
+        .arg(measurement.lossRate() * 100.0, 0, 'f', 3));
+}
+
+
+/**
+ * @brief Shows the highest rate that met the limits and the rate bracket it was narrowed to.
+ * @param None
+ * @return None
+ */
+void MainWindow::rateSearchFinished()
+{
+    setRateSearchRunning(false);
+
+    const samples::RateSearchResult& result = rateSearch->search().result();
+    QString message;
+    if (!result.found)
+    {
+        message = result.steps.isEmpty() || result.steps.first().measurement.received != 0
+            ? tr("Rate search: already %1 msg/s misses the limits").arg(rateSearch->search().config().minRate, 0, 'f', 0)
+            : tr("Rate search: no stamped messages arrived, please subscribe to the published topics");
+    }
+    else if (result.failedRate == 0.0)
+    {
+        message = tr("Rate search: the max rate of %1 msg/s meets the limits, p99 %2")
+            .arg(result.bestRate, 0, 'f', 0).arg(formatDuration(result.best.p99));
+    }
+    else
+    {
+        message = tr("Rate search: max sustainable rate %1 msg/s, %2 msg/s misses the limits, p99 %3")
+            .arg(result.bestRate, 0, 'f', 0).arg(result.failedRate, 0, 'f', 0).arg(formatDuration(result.best.p99));
+    }
+    logMessage(message);
+    ui->statusBar->showMessage(message);
+}
+
+
+/**
+ * @brief Reports a search that could not be completed.
+ * @param reason The description of the problem.
+ * @return None
+ */
+void MainWindow::rateSearchFailed(const QString& reason)
+{
+    setRateSearchRunning(false);
+    logMessage(tr("Rate search failed: %1").arg(reason));
+    ui->statusBar->showMessage(tr("Rate search failed: %1").arg(reason));
+}
+
+
+/**
+ * @brief Switches the search button between starting and aborting, the send button is disabled while a search runs.
+ * @param running True while a search runs.
+ * @return None
+ */
+void MainWindow::setRateSearchRunning(bool running)
+{
+    ui->buttonRateSearch->setText(running ? tr("Abort Search") : tr("Find Max Rate"));
+    ui->buttonSend->setEnabled(!running && ui->buttonStop->isEnabled());
+}
+
+
+/**
+ * @brief Updates the text edit with the buffered messages.
+ * @param None
+ * @return None
+ */
+void MainWindow::updateTextEdit()
+{
+    // The workers count their messages themselves, messageSent() may be throttled
+    ui->lcdNumberPublish->display(static_cast<double>(samples::PublisherTotals::collect(publisherStats).messages));
+
+    // The subscriber publishes a snapshot every Subscriber::TopicStatsIntervalMsec, the table only follows while it is shown
+    if (topicStats && ui->tabWidget->currentWidget() == ui->tabTopicStats)
+    {
+        QSharedPointer<const samples::TopicStatsSnapshot> snapshot = topicStats->latest();
+        topicStatsModel->setSnapshot(snapshot);
+        ui->tableViewTopicStats->setToolTip(snapshot->untracked == 0 ? QString()
+            : tr("%1 messages of topics beyond the first %2 are not counted").arg(snapshot->untracked).arg(samples::TopicStats::MaxTopics));
+    }
+
+    QStringList lines;
+    {
+        QMutexLocker locker(&bufferedMessagesMutex);
+        lines.swap(bufferedMessages);
+    }
+
+    // At most the capacity of the ring per frame, whatever the message rate
+    if (displayRing)
+    {
+        showDisplayCounters(displayRing->take(&displayMessages));
+        if (decodeQueue->decoder() && !displayMessages.isEmpty())
+        {
+            // Appended by messagesDecoded() once the worker is through, right away if there is nothing to decode
+            decodeQueue->decodeMessages(displayMessages);
+        }
+        else
+        {
+            for (const samples::DisplayMessage& message : displayMessages)
+            {
+                appendMessage(&lines, message.timeStamp, message.frames);
+            }
+        }
+    }
+
+    if (!lines.isEmpty())
+    {
+        ui->textView->document()->setMaximumBlockCount(ui->spinBoxMaxItem->value());
+        emit updateTextEditSignal(lines.join("\n"));
+    }
+}
+
+
+/**
+ * @brief Resets the values of the host and ports to their default values.
+ * @param None
+ * @return None
+ */
+void MainWindow::on_buttonDefault_clicked()
+{
+    ui->lineEditHost->setText("127.0.0.1");
+    ui->spinBoxPortSubscribe->setValue(9446);
+    ui->spinBoxPortPublish->setValue(9445);
+    ui->statusBar->showMessage(tr("Parameter set to default value"));
+}
+
+
+void MainWindow::on_buttonQuit_clicked()
+{
+    this->close();
+}
+
+
+/**
+ * @brief This function is called when the user clicks on the "Start" button. It retrieves the IP address, port, and topic from the UI, validates them, and then calls the subscribe function to start the subscription.
+ * @param None
+ * @return None
+ */
+void MainWindow::on_buttonStart_clicked()
+{
+    int updateFrequency = ui->spinBoxFrequency->value();
+    if (updateFrequency < 1 || updateFrequency > 200)
+    {
+        QMessageBox::critical(this, tr("Error"), tr("Please enter a valid update frequency"));
+        return;
+    }
+
+    // Starts the timer to update every 100ms
+    updateTimer->start((int)(1000 / updateFrequency));
+
+    QString ipAddress = ui->lineEditHost->text();
+    // Bind to all available interfaces
+    QString localAddress = "*";
+    int subPort = ui->spinBoxPortSubscribe->value();
+    int pubPort = ui->spinBoxPortPublish->value();
+
+    bool useHex = false;
+
+    if (!isValidIPv4(ipAddress))
+    {
+        QMessageBox::critical(this, tr("Error"), tr("Please enter a valid IPv4 address"));
+        ui->statusBar->showMessage(tr("Please enter a valid IPv4 address"));
+        return;
+    }
+
+    // The endpoint list replaces Host:Subscribe Port when it is filled in
+    QStringList endpoints(QString("tcp://%1:%2").arg(ipAddress).arg(subPort));
+    QString error;
+    if (!ui->lineEditEndpoints->text().trimmed().isEmpty() && !samples::EndpointList::parse(ui->lineEditEndpoints->text(), &endpoints, &error))
+    {
+        QMessageBox::critical(this, tr("Error"), error);
+        ui->statusBar->showMessage(error);
+        return;
+    }
+    if (endpoints.isEmpty())
+    {
+        QMessageBox::critical(this, tr("Error"), tr("Please enter at least one endpoint"));
+        ui->statusBar->showMessage(tr("Please enter at least one endpoint"));
+        return;
+    }
+
+    ui->buttonSend->setEnabled(true);
+    ui->buttonRateSearch->setEnabled(true);
+    ui->buttonStart->setEnabled(false);
+    ui->buttonStop->setEnabled(true);
+    ui->buttonDefault->setEnabled(false);
+    ui->lcdNumberSubscribe->display(0);
+    ui->lcdNumberPublish->display(0);
+    ui->labelDisplayValue->setText(tr("n/a"));
+    ui->labelDisplayValue->setToolTip(QString());
+    ui->labelLatencyValue->setText(tr("n/a"));
+    ui->labelLatencyValue->setToolTip(QString());
+    ui->labelLossValue->setText(tr("n/a"));
+    ui->labelLossValue->setToolTip(QString());
+    ui->labelRateValue->setText(tr("n/a"));
+    ui->labelRateValue->setToolTip(QString());
+    ui->labelStreamValue->setText(tr("n/a"));
+    ui->labelStreamValue->setToolTip(QString());
+    ui->labelIntegrityValue->setText(tr("n/a"));
+    ui->labelCaptureValue->setText(tr("n/a"));
+    ui->labelCaptureValue->setToolTip(QString());
+    ui->labelEndpointValue->setText(tr("n/a"));
+    ui->labelEndpointValue->setToolTip(QString());
+    captureError.clear();
+    streamsComplete = 0;
+    streamsIncomplete = 0;
+
+    ui->lineEditHost->setEnabled(false);
+    ui->spinBoxPortPublish->setEnabled(false);
+    ui->spinBoxPortSubscribe->setEnabled(false);
+    ui->spinBoxWorkers->setEnabled(false);
+    ui->comboBoxWorkerMode->setEnabled(false);
+    ui->checkBoxWorkerContext->setEnabled(false);
+    ui->lineEditEndpoints->setEnabled(false);
+    ui->buttonEndpointsBrowse->setEnabled(false);
+    ui->spinBoxSubscriberSockets->setEnabled(false);
+
+    ui->statusBar->showMessage(tr("Started ..."));
+
+    subscribeInit(endpoints, ui->spinBoxSubscriberSockets->value(), useHex);
+    publishInit(localAddress, pubPort, useHex);
+}
+
+
+/**
+ * @brief Clears all input fields in the publish section of the UI.
+ * @param None
+ * @return None
+ */
+void MainWindow::on_buttonPublishClearAll_clicked()
+{
+    ui->textView->clear();
+    ui->lineEditPublishTopic->clear();
+    ui->lineEditPublishMessage->clear();
+    ui->statusBar->showMessage(tr("Information cleared"));
+}
+
+
+/**
+ * @brief Slot function that is called when the state of the "Loop" checkbox is changed.
+ *        Enables or disables the "Frequency" spin box based on the state of the checkbox.
+ * @param arg1 The new state of the checkbox (Qt::Checked or Qt::Unchecked).
+ * @return void
+ */
+void MainWindow::on_checkBoxLoop_stateChanged(int arg1)
+{
+    if (arg1 == Qt::Checked)
+    {
+        ui->publishFrequency->setEnabled(true);
+    }
+    else
+    {
+        ui->publishFrequency->setEnabled(false);
+    }
+}
+
+
+/**
+ * @brief Enables the Zipf exponent while the Zipf distribution is selected.
+ * @param index The index of the selected distribution.
+ * @return void
+ */
+void MainWindow::on_comboBoxTopicDistribution_currentIndexChanged(int index)
+{
+    ui->doubleSpinBoxZipfExponent->setEnabled(index == 1);
+}
+
+
+/**
+ * @brief Enables the replay file and speed inputs while the "Replay Capture" checkbox is checked.
+ * @param arg1 The new state of the checkbox (Qt::Checked or Qt::Unchecked).
+ * @return void
+ */
+void MainWindow::on_checkBoxReplay_stateChanged(int arg1)
+{
+    bool replay = arg1 == Qt::Checked;
+    ui->lineEditReplayFile->setEnabled(replay);
+    ui->buttonReplayBrowse->setEnabled(replay);
+    ui->comboBoxReplaySpeed->setEnabled(replay);
+    ui->lineEditPublishTopic->setEnabled(!replay);
+    ui->lineEditPublishMessage->setEnabled(!replay && !ui->checkBoxPayloadFile->isChecked());
+}
+
+
+/**
+ * @brief Enables the payload file and slice size inputs while the "File Payload" checkbox is checked.
+ * @param arg1 The new state of the checkbox (Qt::Checked or Qt::Unchecked).
+ * @return void
+ */
+void MainWindow::on_checkBoxPayloadFile_stateChanged(int arg1)
+{
+    bool file = arg1 == Qt::Checked;
+    ui->lineEditPayloadFile->setEnabled(file);
+    ui->buttonPayloadBrowse->setEnabled(file);
+    ui->spinBoxPayloadSlice->setEnabled(file && !ui->checkBoxStream->isChecked());
+    ui->lineEditPublishMessage->setEnabled(!file && !ui->checkBoxReplay->isChecked());
+}
+
+
+/**
+ * @brief Lets the user pick the file to publish.
+ * @param None
+ * @return void
+ */
+void MainWindow::on_buttonPayloadBrowse_clicked()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("Open Payload"), ui->lineEditPayloadFile->text(), tr("All Files (*)"));
+    if (!path.isEmpty())
+    {
+        ui->lineEditPayloadFile->setText(path);
+    }
+}
+
+
+/**
+ * @brief Enables the seeded payload size input while the "Seeded Payload" checkbox is checked.
+ * @param arg1 The new state of the checkbox (Qt::Checked or Qt::Unchecked).
+ * @return void
+ */
+void MainWindow::on_checkBoxSeeded_stateChanged(int arg1)
+{
+    ui->spinBoxSeededSize->setEnabled(arg1 == Qt::Checked);
+}
+
+
+/**
+ * @brief Enables the chunk size and window inputs while the "Stream Chunks" checkbox is checked.
+ * @param arg1 The new state of the checkbox (Qt::Checked or Qt::Unchecked).
+ * @return void
+ */
+void MainWindow::on_checkBoxStream_stateChanged(int arg1)
+{
+    bool stream = arg1 == Qt::Checked;
+    ui->spinBoxChunkSize->setEnabled(stream);
+    ui->spinBoxChunkWindow->setEnabled(stream);
+    ui->spinBoxPayloadSlice->setEnabled(!stream && ui->checkBoxPayloadFile->isChecked());
+}
+
+
+/**
+ * @brief Lets the user pick the directory received streams are written to.
+ * @param None
+ * @return void
+ */
+void MainWindow::on_buttonStreamDirBrowse_clicked()
+{
+    QString path = QFileDialog::getExistingDirectory(this, tr("Reassemble Streams To"), ui->lineEditStreamDir->text());
+    if (!path.isEmpty())
+    {
+        ui->lineEditStreamDir->setText(path);
+    }
+}
+
+
+/**
+ * @brief Lets the user pick the name of the capture to record, the segment suffix is removed.
+ * @param None
+ * @return void
+ */
+void MainWindow::on_buttonCaptureBrowse_clicked()
+{
+    QString path = QFileDialog::getSaveFileName(this, tr("Record Capture"), ui->lineEditCapturePrefix->text(), tr("Captures (*.zcap);;All Files (*)"));
+    if (path.isEmpty())
+    {
+        return;
+    }
+
+    QString prefix;
+    int index = 0;
+    if (samples::CaptureFormat::parseSegmentPath(path, &prefix, &index))
+    {
+        path = prefix;
+    }
+    else if (path.endsWith(".zcap"))
+    {
+        path.chop(5);
+    }
+    ui->lineEditCapturePrefix->setText(path);
+}
+
+
+/**
+ * @brief Returns the file to publish instead of the message.
+ * @param None
+ * @return QString The selected file, empty if the "File Payload" checkbox is not checked.
+ */
+QString MainWindow::payloadFile() const
+{
+    return ui->checkBoxPayloadFile->isChecked() ? ui->lineEditPayloadFile->text() : QString();
+}
+
+
+/**
+ * @brief Returns the size of the frames the payload file is split into.
+ * @param None
+ * @return qint64 The slice size in bytes, 0 for the whole file.
+ */
+qint64 MainWindow::payloadSliceSize() const
+{
+    return ui->spinBoxPayloadSlice->value() * 1024LL;
+}
+
+
+/**
+ * @brief Lets the user pick the capture file to replay.
+ * @param None
+ * @return void
+ */
+void MainWindow::on_buttonReplayBrowse_clicked()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("Open Capture"), ui->lineEditReplayFile->text(), tr("Captures (*.zcap);;All Files (*)"));
+    if (!path.isEmpty())
+    {
+        ui->lineEditReplayFile->setText(path);
+    }
+}
+
+
+/**
+ * @brief Lets the user pick a capture and shows it in the CaptureView tab.
+ * @param None
+ * @return void
+ */
+void MainWindow::on_buttonViewBrowse_clicked()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("View Capture"), ui->lineEditViewFile->text(), tr("Captures (*.zcap);;All Files (*)"));
+    if (!path.isEmpty())
+    {
+        ui->lineEditViewFile->setText(path);
+        openCaptureView(path);
+    }
+}
+
+
+/**
+ * @brief Shows the capture typed into the file field in the CaptureView tab.
+ * @param None
+ * @return void
+ */
+void MainWindow::on_lineEditViewFile_returnPressed()
+{
+    openCaptureView(ui->lineEditViewFile->text());
+}
+
+
+/**
+ * @brief Lists the viewed capture from the selected time and topic.
+ * @param None
+ * @return void
+ */
+void MainWindow::on_buttonViewSeek_clicked()
+{
+    QByteArray topic = ui->comboBoxViewTopic->currentIndex() > 0 ? ui->comboBoxViewTopic->currentText().toUtf8() : QByteArray();
+    QElapsedTimer timer;
+    timer.start();
+    captureSearch->cancel();
+    captureModel->seek(ui->dateTimeEditViewSeek->dateTime().toMSecsSinceEpoch(), topic);
+    ui->tableViewCapture->scrollToTop();
+    ui->statusBar->showMessage(tr("Seek took %1").arg(formatDuration(timer.nsecsElapsed())));
+}
+
+
+/**
+ * @brief Lists the messages of the viewed capture whose payload contains the search bytes.
+ * @param None
+ * @return void
+ */
+void MainWindow::on_buttonViewFind_clicked()
+{
+    // Typed like the messages are shown, hex while the display is hex
+    QByteArray text = ui->lineEditViewSearch->text().toUtf8();
+    QByteArray pattern = text;
+    QString error;
+    if (ui->hexDisplay->isChecked() && !samples::HexCodec::decode(text, &pattern, &error))
+    {
+        QMessageBox::critical(this, tr("Error"), error);
+        return;
+    }
+    if (pattern.isEmpty())
+    {
+        return;
+    }
+
+    captureModel->showMatches();
+    captureSearch->start(captureModel->capture().segmentPath(0), pattern);
+    ui->statusBar->showMessage(tr("Searching the capture ..."));
+}
+
+
+/**
+ * @brief Searches the viewed capture for the bytes typed into the search field.
+ * @param None
+ * @return void
+ */
+void MainWindow::on_lineEditViewSearch_returnPressed()
+{
+    on_buttonViewFind_clicked();
+}
+
+
+/**
+ * @brief Shows how many matches a payload search found and how much of the capture it read.
+ * @param summary The counters of the finished search.
+ * @return None
+ */
+void MainWindow::captureSearchFinished(const samples::CaptureSearchSummary& summary)
+{
+    if (!summary.error.isEmpty())
+    {
+        ui->statusBar->showMessage(tr("Search failed: %1").arg(summary.error));
+        return;
+    }
+
+    ui->statusBar->showMessage(tr("%1%2 matches in %3 | %4 of %5 segments indexed | %6 of %7 blocks read | %8 messages verified")
+                                   .arg(summary.matches).arg(summary.truncated ? tr(" (truncated)") : QString())
+                                   .arg(formatDuration(summary.elapsedNs)).arg(summary.indexedSegments).arg(summary.segments)
+                                   .arg(summary.candidateBlocks).arg(summary.blocks).arg(summary.messages));
+}
+
+
+/**
+ * @brief Opens a capture in the CaptureView tab and fills in its time range and topics.
+ * @param path A segment of the capture.
+ * @return None
+ */
+void MainWindow::openCaptureView(const QString& path)
+{
+    QString error;
+    captureSearch->cancel();
+    bool opened = captureModel->open(path, &error);
+    ui->dateTimeEditViewSeek->setEnabled(opened);
+    ui->comboBoxViewTopic->setEnabled(opened);
+    ui->buttonViewSeek->setEnabled(opened);
+    ui->lineEditViewSearch->setEnabled(opened);
+    ui->buttonViewFind->setEnabled(opened);
+    ui->comboBoxViewTopic->clear();
+    ui->comboBoxViewTopic->addItem(tr("All Topics"));
+    if (!opened)
+    {
+        ui->labelViewInfo->setText(tr("n/a"));
+        QMessageBox::critical(this, tr("Error"), error);
+        return;
+    }
+
+    const samples::MappedCapture& capture = captureModel->capture();
+    QDateTime first = QDateTime::fromMSecsSinceEpoch(capture.toUtcMs(capture.firstNs()));
+    QDateTime last = QDateTime::fromMSecsSinceEpoch(capture.toUtcMs(capture.lastNs()));
+    ui->dateTimeEditViewSeek->setDateTimeRange(first, last);
+    ui->dateTimeEditViewSeek->setDateTime(first);
+    for (const QByteArray& topic : capture.topics())
+    {
+        ui->comboBoxViewTopic->addItem(QString::fromUtf8(topic));
+    }
+
+    int scanned = 0;
+    for (int i = 0; i < capture.segmentCount(); ++i)
+    {
+        scanned += capture.isScanned(i) ? 1 : 0;
+    }
+    ui->labelViewInfo->setText(tr("%1 segments (%2 without index) | %3 MB | %4 to %5 | %6 topics")
+                                   .arg(capture.segmentCount()).arg(scanned).arg(capture.size() / 1e6, 0, 'f', 1)
+                                   .arg(first.toString("yyyy-MM-dd hh:mm:ss.zzz"), last.toString("yyyy-MM-dd hh:mm:ss.zzz"))
+                                   .arg(ui->comboBoxViewTopic->count() - 1));
+}
+
+
+/**
+ * @brief Displays the about dialog in the center of the main window.
+ * @param None
+ * @return None
+ */
+void MainWindow::on_actionAbout_triggered()
+{
+    aboutdlg.show();
+    // Display in front of the main window
+    int x = this->x() + (this->width() - aboutdlg.width()) / 2;
+    int y = this->y() + (this->height() - aboutdlg.height()) / 2;
+    aboutdlg.move(x, y);
+}
+
+
+void MainWindow::on_actionQuit_triggered()
+{
+    this->close();
+}
+
+
+/**
+ * @brief Overrides the changeEvent function to handle language change events.
+ * @param e A pointer to the QEvent object.
+ * @return void
+ * @note This function is called whenever a language change event occurs. It retranslated the UI to the new language.
+ */
+void MainWindow::changeEvent(QEvent *e)
+{
+    QMainWindow::changeEvent(e);
+    switch (e->type())
     {
     case QEvent::LanguageChange:
         ui->retranslateUi(this);
@@ -795,20 +2035,38 @@ void MainWindow::changeEvent(QEvent *e)
 
 
 /**
- * @brief Checks if the given string contains only alphanumeric characters.
+ * @brief Checks if the given string contains only alphanumeric characters, '/' and the wildcards '#' and '+'.
  * @param str The string to be checked.
- * @return True if the string contains only alphanumeric characters, false otherwise.
+ * @return True if the string contains only allowed characters, false otherwise.
  */
 bool MainWindow::isValidString(const QString &str)
 {
     if (str.isEmpty())
         return false;
 
-    QRegExp regex("^[a-zA-Z0-9/#]*$");
+    QRegExp regex("^[a-zA-Z0-9/#+]*$");
     return regex.exactMatch(str);
 }
 
 
+/**
+ * @brief Formats a duration in nanoseconds with a unit that keeps three significant digits.
+ * @param ns The duration in nanoseconds.
+ * @return The formatted duration, e.g. "12.3 us".
+ */
+QString MainWindow::formatDuration(qint64 ns)
+{
+    if (ns < 1000)
+        return QString("%1 ns").arg(ns);
+    if (ns < 1000000)
+        return QString("%1 us").arg(ns / 1e3, 0, 'g', 3);
+    if (ns < 1000000000)
+        return QString("%1 ms").arg(ns / 1e6, 0, 'g', 3);
+
+    return QString("%1 s").arg(ns / 1e9, 0, 'g', 3);
+}
+
+
 /**
  * @brief Checks if a given string is a valid IPv4 address.
  *
@@ -0,0 +1,263 @@
+// Copyright (C) 2023 The JOUAV Company Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "topicstatsmodel.h"
+
+#include <algorithm>
+
+using nzmqt::samples::TopicRow;
+using nzmqt::samples::TopicStatsSnapshot;
+
+TopicStatsModel::TopicStatsModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , snapshot_(new TopicStatsSnapshot)
+    , sortColumn_(COL_MESSAGE_RATE)
+    , sortOrder_(Qt::DescendingOrder)
+{
+}
+
+
+/**
+ * @brief Shows a new snapshot, the rows keep the current sort order.
+ * @param snapshot The snapshot, a snapshot that is already shown is ignored.
+ * @return None
+ */
+void TopicStatsModel::setSnapshot(const QSharedPointer<const TopicStatsSnapshot>& snapshot)
+{
+    if (snapshot.isNull() || snapshot == snapshot_)
+    {
+        return;
+    }
+
+    // Topics are never removed from the stats, a new snapshot can only add rows
+    int oldRows = order_.size();
+    int newRows = snapshot->rows.size();
+    if (newRows < oldRows)
+    {
+        beginResetModel();
+        snapshot_ = snapshot;
+        order_.clear();
+        endResetModel();
+        oldRows = 0;
+    }
+    if (newRows > oldRows)
+    {
+        beginInsertRows(QModelIndex(), oldRows, newRows - 1);
+        snapshot_ = snapshot;
+        for (int i = oldRows; i < newRows; ++i)
+        {
+            order_.append(i);
+        }
+        endInsertRows();
+    }
+    snapshot_ = snapshot;
+
+    relayout();
+    if (newRows > 0)
+    {
+        emit dataChanged(index(0, 0), index(newRows - 1, COLUMN_COUNT - 1));
+    }
+}
+
+
+/**
+ * @brief Removes all rows, e.g. when a new subscriber starts.
+ * @param None
+ * @return None
+ */
+void TopicStatsModel::clear()
+{
+    beginResetModel();
+    snapshot_.reset(new TopicStatsSnapshot);
+    order_.clear();
+    endResetModel();
+}
+
+
+int TopicStatsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : order_.size();
+}
+
+
+int TopicStatsModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+
+QVariant TopicStatsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= order_.size())
+    {
+        return QVariant();
+    }
+
+    if (role == Qt::TextAlignmentRole)
+    {
+        return index.column() == COL_TOPIC ? QVariant(Qt::AlignLeft | Qt::AlignVCenter) : QVariant(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    if (role != Qt::DisplayRole)
+    {
+        return QVariant();
+    }
+
+    const TopicRow& row = snapshot_->rows.at(order_.at(index.row()));
+    switch (index.column())
+    {
+    case COL_TOPIC:
+        return QString::fromUtf8(row.topic);
+    case COL_MESSAGES:
+        return QString::number(row.messages);
+    case COL_MESSAGE_RATE:
+        return QString::number(row.messageRate, 'f', 1);
+    case COL_BYTE_RATE:
+        return QString::number(row.byteRate / 1e6, 'f', 3);
+    case COL_MIN_SIZE:
+        return row.messages == 0 ? QString() : QString::number(row.minSize);
+    case COL_AVG_SIZE:
+        return QString::number(row.averageSize(), 'f', 1);
+    case COL_MAX_SIZE:
+        return QString::number(row.maxSize);
+    case COL_LAST_SEEN:
+        return tr("%1 s ago").arg((snapshot_->takenNs - row.lastNs) / 1e9, 0, 'f', 1);
+    case COL_JITTER:
+        return QString::number(row.jitterNs / 1e6, 'f', 3);
+    default:
+        return QVariant();
+    }
+}
+
+
+QVariant TopicStatsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+    {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section)
+    {
+    case COL_TOPIC:
+        return tr("Topic");
+    case COL_MESSAGES:
+        return tr("Messages");
+    case COL_MESSAGE_RATE:
+        return tr("msg/s");
+    case COL_BYTE_RATE:
+        return tr("MB/s");
+    case COL_MIN_SIZE:
+        return tr("Min Size");
+    case COL_AVG_SIZE:
+        return tr("Avg Size");
+    case COL_MAX_SIZE:
+        return tr("Max Size");
+    case COL_LAST_SEEN:
+        return tr("Last Seen");
+    case COL_JITTER:
+        return tr("Jitter (ms)");
+    default:
+        return QVariant();
+    }
+}
+
+
+/**
+ * @brief Sorts the rows by a column, called by the view when a header section is clicked.
+ * @param column The column to sort by.
+ * @param order The sort order.
+ * @return None
+ */
+void TopicStatsModel::sort(int column, Qt::SortOrder order)
+{
+    sortColumn_ = column;
+    sortOrder_ = order;
+    relayout();
+}
+
+
+/**
+ * @brief Sorts the rows again and moves the persistent indexes, e.g. the selection, along with their topics.
+ * @param None
+ * @return None
+ */
+void TopicStatsModel::relayout()
+{
+    emit layoutAboutToBeChanged();
+
+    // Rows of the snapshot keep their topic, so a persistent index follows the snapshot row it showed
+    QModelIndexList before = persistentIndexList();
+    QVector<int> snapshotRows;
+    snapshotRows.reserve(before.size());
+    for (const QModelIndex& index : before)
+    {
+        snapshotRows.append(order_.at(index.row()));
+    }
+
+    sortRows();
+
+    QVector<int> viewRows(order_.size());
+    for (int i = 0; i < order_.size(); ++i)
+    {
+        viewRows[order_.at(i)] = i;
+    }
+    QModelIndexList after;
+    after.reserve(before.size());
+    for (int i = 0; i < before.size(); ++i)
+    {
+        after.append(index(viewRows.at(snapshotRows.at(i)), before.at(i).column()));
+    }
+    changePersistentIndexList(before, after);
+
+    emit layoutChanged();
+}
+
+
+// Sorts order_ by the raw values of the sort column, the topic breaks ties so that rows do not jump between snapshots
+void TopicStatsModel::sortRows()
+{
+    const QVector<TopicRow>& rows = snapshot_->rows;
+    auto value = [this, &rows](int i) -> double {
+        const TopicRow& row = rows.at(i);
+        switch (sortColumn_)
+        {
+        case COL_MESSAGES:
+            return static_cast<double>(row.messages);
+        case COL_MESSAGE_RATE:
+            return row.messageRate;
+        case COL_BYTE_RATE:
+            return row.byteRate;
+        case COL_MIN_SIZE:
+            return row.minSize;
+        case COL_AVG_SIZE:
+            return row.averageSize();
+        case COL_MAX_SIZE:
+            return row.maxSize;
+        case COL_LAST_SEEN:
+            return static_cast<double>(-row.lastNs);
+        case COL_JITTER:
+            return row.jitterNs;
+        default:
+            return 0.0;
+        }
+    };
+
+    bool ascending = sortOrder_ == Qt::AscendingOrder;
+    if (sortColumn_ == COL_TOPIC)
+    {
+        std::sort(order_.begin(), order_.end(), [&rows, ascending](int a, int b) {
+            return ascending ? rows.at(a).topic < rows.at(b).topic : rows.at(b).topic < rows.at(a).topic;
+        });
+        return;
+    }
+
+    std::sort(order_.begin(), order_.end(), [&rows, &value, ascending](int a, int b) {
+        double va = value(a);
+        double vb = value(b);
+        if (va != vb)
+        {
+            return ascending ? va < vb : vb < va;
+        }
+        return rows.at(a).topic < rows.at(b).topic;
+    });
+}
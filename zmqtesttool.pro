@@ -1,4 +1,4 @@
-QT       += core gui testlib
+QT       += core gui testlib concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -18,7 +18,9 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 SOURCES += src/main.cpp\
         src/aboutdialog.cpp \
-        src/mainwindow.cpp
+        src/mainwindow.cpp \
+        src/topicstatsmodel.cpp \
+        src/capturemodel.cpp
 
 HEADERS += include/mainwindow.h \
     include/aboutdialog.h \
@@ -31,7 +33,46 @@ HEADERS += include/mainwindow.h \
     include/mainwindow.h \
     include/nzmqt/global.hpp \
     include/nzmqt/impl.hpp \
-    include/nzmqt/nzmqt.hpp
+    include/nzmqt/nzmqt.hpp \
+    include/MessageStamp.hpp \
+    include/HdrHistogram.hpp \
+    include/LatencyStats.hpp \
+    include/RateScheduler.hpp \
+    include/SequenceTracker.hpp \
+    include/CaptureFormat.hpp \
+    include/FastRandom.hpp \
+    include/TopicSampler.hpp \
+    include/PublisherStats.hpp \
+    include/CachedFrame.hpp \
+    include/LoadProfile.hpp \
+    include/RateStats.hpp \
+    include/RateSearch.hpp \
+    include/RateSearchController.hpp \
+    include/MappedPayload.hpp \
+    include/ChunkHeader.hpp \
+    include/ChunkSender.hpp \
+    include/ChunkAssembler.hpp \
+    include/MessageTemplate.hpp \
+    include/HexCodec.hpp \
+    include/SeededPayload.hpp \
+    include/PayloadVerifier.hpp \
+    include/TopicStats.hpp \
+    include/topicstatsmodel.h \
+    include/TopicMatcher.hpp \
+    include/CaptureWriter.hpp \
+    include/CaptureIo.hpp \
+    include/MappedCapture.hpp \
+    include/capturemodel.h \
+    include/ByteSearch.hpp \
+    include/TrigramIndex.hpp \
+    include/CaptureSearch.hpp \
+    include/EndpointList.hpp \
+    include/EndpointStats.hpp \
+    include/DisplayRing.hpp \
+    include/PayloadDecoder.hpp \
+    include/MessagePackDecoder.hpp \
+    include/ProtobufDecoder.hpp \
+    include/DecodeQueue.hpp
 
 FORMS += ui/aboutdialog.ui \
     ui/mainwindow.ui